@@ -16,6 +16,15 @@
 #include <string>
 #include <stdio.h>
 #include <memory>
+#include <functional>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <unordered_map>
+#include <list>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -95,6 +104,8 @@ class SO_Shader : public SO_BaseShader {
         virtual void setProjectionMatrix(glm::mat4 projectionMatrix);
 };
 
+class SO_ColorMap;
+
 /// The options which can be passed into SO_PhongShader to control the exact behaviour
 enum SO_ShaderOptions : unsigned int {
     /// Enables the alpha channel on the object
@@ -136,7 +147,28 @@ enum SO_ShaderOptions : unsigned int {
     /// Enables the alpha colour to be passed as a vertex attribute in material mode as opposed to a uniform using setMaterialAlpha()
     SO_ALPHA_ATTRIBUTE = 64,
     /// Enables the colour to be passed as a vertex attribute in colour mode as opposed to a uniform using setColor()
-    SO_COLOR_ATTRIBUTE = 128
+    SO_COLOR_ATTRIBUTE = 128,
+    /// Enables procedural colouring with perlin noise evaluated on the GPU - see perlinShaderSource()
+    /**
+     * The noise `n` is evaluated per fragment at `position*noiseScale + noiseOffset`, where `position` is the model space vertex position,
+     * and the ambient and diffuse colours become `mix(noiseColor, colour, n)`. Moving the offset animates the pattern with no textures to rebake.
+     * The permutation table texture from createPerlinPermsTexture() must be bound to the unit set by setNoiseTextureUnit() (3 by default).
+    **/
+    SO_NOISE_COLOR = 256,
+    /// Enables procedural displacement with perlin noise evaluated on the GPU - see perlinShaderSource()
+    /**
+     * Each vertex is moved along its normal by `noiseAmplitude*(2n - 1)`, with `n` evaluated at the undisplaced model space position as in SO_NOISE_COLOR.
+     * The normals are not changed, so the mesh should be finely divided and the amplitude small for the lighting to stay believable.
+    **/
+    SO_NOISE_DISPLACEMENT = 512,
+    /// Enables colouring from a float vertex attribute "scalar" looked up in a colormap texture on the GPU - see SO_ColorMap::createTexture()
+    /**
+     * The scalar is normalised with the `scalarMin` and `scalarMax` uniforms and looked up per fragment as SO_ColorMap::getLerpColor() does, so
+     * changing the range with setScalarRange(), or the colormap with SO_ColorMap::updateTexture() and setColorMap(), needs no vertex data re-uploaded.
+     * The colormap texture must be bound to the unit set by setColorMapTextureUnit() (4 by default). Takes the place of SO_COLOR_ATTRIBUTE,
+     * and the alpha comes from the texture. Ignored in material mode.
+    **/
+    SO_SCALAR_ATTRIBUTE = 1024
 };
 
 /// 3D Phong model lighting class
@@ -158,6 +190,16 @@ class SO_PhongShader : public SO_Shader {
         GLint alphaMatLoc; ///< The OpenGL location of the float uniform named "alphaMat" in the shader
         GLint colorLoc; ///< The OpenGL location of the vec3/4 (depending on SO_Alpha) uniform named "Color" in the shader
         GLint specularPowerLoc; ///< The OpenGL location of the unsigned int uniform named "specPower" in the shader
+        GLint noiseScaleLoc; ///< The OpenGL location of the float uniform named "noiseScale" in the shader
+        GLint noiseOffsetLoc; ///< The OpenGL location of the vec3 uniform named "noiseOffset" in the shader
+        GLint noiseRepeatLoc; ///< The OpenGL location of the float uniform named "noiseRepeat" in the shader
+        GLint noiseColorLoc; ///< The OpenGL location of the vec3 uniform named "noiseColor" in the shader
+        GLint noiseAmplitudeLoc; ///< The OpenGL location of the float uniform named "noiseAmplitude" in the shader
+        GLint noisePermsLoc; ///< The OpenGL location of the usampler1D uniform named "perlinPerms" in the shader
+        GLint scalarMinLoc; ///< The OpenGL location of the float uniform named "scalarMin" in the shader
+        GLint scalarMaxLoc; ///< The OpenGL location of the float uniform named "scalarMax" in the shader
+        GLint colorMapKeysLoc; ///< The OpenGL location of the vec2 uniform named "colorMapKeys" in the shader
+        GLint colorMapLoc; ///< The OpenGL location of the sampler1D uniform named "colorMap" in the shader
         using SO_Shader::createVertexShader;
         using SO_Shader::createFragmentShader;
         using SO_Shader::linkProgram;
@@ -200,6 +242,24 @@ class SO_PhongShader : public SO_Shader {
         void setColor(glm::vec4 color);
         /// Set the power of the specular highlights - higher integers produce 'sharper' spots
         void setSpecularPower(unsigned int specPower);
+        /// Set the scale from model space to noise space - available only if SO_NOISE_COLOR or SO_NOISE_DISPLACEMENT is enabled (default 1)
+        void setNoiseScale(float scale);
+        /// Set the offset added in noise space - move it over time to animate the noise (default (0, 0, 0))
+        void setNoiseOffset(glm::vec3 offset);
+        /// Set the period of the noise in noise space - as the `repeat` of perlin(), 0 for no repeat (default 0)
+        void setNoiseRepeat(float repeat);
+        /// Set the colour mixed in where the noise is low - available only if SO_NOISE_COLOR is enabled (default black)
+        void setNoiseColor(glm::vec3 color);
+        /// Set the largest distance vertices are moved along their normals - available only if SO_NOISE_DISPLACEMENT is enabled (default 0.1)
+        void setNoiseAmplitude(float amplitude);
+        /// Set the texture unit the createPerlinPermsTexture() texture is bound to when rendering (default 3)
+        void setNoiseTextureUnit(unsigned int unit);
+        /// Set the expected extremes of the scalar attribute - the `min` and `max` of SO_ColorMap::getLerpColor() - available only if SO_SCALAR_ATTRIBUTE is enabled (default 0 and 1)
+        void setScalarRange(float min, float max);
+        /// Set the key positions of the colormap whose texture is bound - call it whenever the texture is made from a map with different lowest or highest key positions (default 0 and 1)
+        void setColorMap(const SO_ColorMap& colorMap);
+        /// Set the texture unit the SO_ColorMap::createTexture() texture is bound to when rendering (default 4)
+        void setColorMapTextureUnit(unsigned int unit);
 };
 
 ///Generate a skybox using 6 images which will appear in the background
@@ -265,6 +325,13 @@ class SO_ModelShader : public SO_Shader {
         GLint normalMatrixLoc; ///< The OpenGL location of the mat4 uniform named "normalMatrix" in the shader
         GLint viewPositionLoc; ///< The OpenGL location of the vec3 uniform named "viewPos" in the shader
         GLint specularPowerLoc; ///< The OpenGL location of the unsigned int uniform named "specPower" in the shader
+        unsigned int options = 0; ///< The noise options passed to generate()
+        GLint noiseScaleLoc; ///< The OpenGL location of the float uniform named "noiseScale" in the shader
+        GLint noiseOffsetLoc; ///< The OpenGL location of the vec3 uniform named "noiseOffset" in the shader
+        GLint noiseRepeatLoc; ///< The OpenGL location of the float uniform named "noiseRepeat" in the shader
+        GLint noiseColorLoc; ///< The OpenGL location of the vec3 uniform named "noiseColor" in the shader
+        GLint noiseAmplitudeLoc; ///< The OpenGL location of the float uniform named "noiseAmplitude" in the shader
+        GLint noisePermsLoc; ///< The OpenGL location of the usampler1D uniform named "perlinPerms" in the shader
         using SO_Shader::createVertexShader;
         using SO_Shader::createFragmentShader;
         using SO_Shader::linkProgram;
@@ -272,9 +339,10 @@ class SO_ModelShader : public SO_Shader {
         /// Generate the shader program using the number of lights/textures of each type as provided
         /**
          * Note that the current shader implementation will only use the first texture of each type provided.
-         * The shader implements a Phong lighting model.
+         * The shader implements a Phong lighting model. `optionsIn` may hold SO_NOISE_COLOR and SO_NOISE_DISPLACEMENT, which act as in
+         * SO_PhongShader - the noise colour is mixed into the diffuse colour or texture. The other SO_ShaderOptions are ignored.
         **/
-        GLuint generate(int numberLightsIn, int diffuseTextures, int specularTextures, int normalTextures);
+        GLuint generate(int numberLightsIn, int diffuseTextures, int specularTextures, int normalTextures, unsigned int optionsIn = 0);
         /// An override of the base class method which also calculates the transformation for normal vectors and passes this into the shader.
         void setModelMatrix(glm::mat4 modelMatrix) override;
         /// Set the position of the camera in world space
@@ -295,6 +363,18 @@ class SO_ModelShader : public SO_Shader {
         void setLightSpecular(int index, glm::vec3 lightSpecular);
         /// Set the power of the specular highlights - higher integers produce 'sharper' spots
         void setSpecularPower(unsigned int specPower);
+        /// Set the scale from model space to noise space - see SO_PhongShader::setNoiseScale()
+        void setNoiseScale(float scale);
+        /// Set the offset added in noise space - see SO_PhongShader::setNoiseOffset()
+        void setNoiseOffset(glm::vec3 offset);
+        /// Set the period of the noise in noise space - see SO_PhongShader::setNoiseRepeat()
+        void setNoiseRepeat(float repeat);
+        /// Set the colour mixed in where the noise is low - see SO_PhongShader::setNoiseColor()
+        void setNoiseColor(glm::vec3 color);
+        /// Set the largest distance vertices are moved along their normals - see SO_PhongShader::setNoiseAmplitude()
+        void setNoiseAmplitude(float amplitude);
+        /// Set the texture unit the createPerlinPermsTexture() texture is bound to when rendering (default 3, after the unit used by each SO_ModelMesh map)
+        void setNoiseTextureUnit(unsigned int unit);
 };
 
 /// A class which stores an advanced mesh object - including textures
@@ -396,6 +476,73 @@ class SO_FfmpegStream {
 #pragma message("WARNING: class SO_Ffmpeg is not supported on this OS, and is not available")
 #endif
 
+/// A work-stealing pool of worker threads used by the library for parallel work
+/**
+ * Each worker has its own queue of tasks: tasks submitted from a worker go onto that worker's queue, tasks submitted from any other thread
+ * are spread across the queues, and a worker which runs out of tasks steals from the other queues. The pool used by the library is
+ * returned by global() and is created on first use with one thread per core - users may also submit their own tasks to it, or create
+ * separate pools. parallelFor() blocks the calling thread, which runs ranges of the loop itself and then sleeps until the rest are finished.
+**/
+class SO_ThreadPool {
+    /// A single worker's queue of tasks - the owner takes from the back, thieves take from the front
+    struct SO_TaskQueue {
+        std::mutex mutex; ///< Guards `tasks`
+        std::deque<std::function<void()>> tasks; ///< The queued tasks
+    };
+    /// The state shared by the calling thread and the helper tasks of one parallelFor() call
+    struct SO_ParallelForState {
+        size_t count; ///< The number of iterations
+        size_t grainSize; ///< The number of iterations in each range
+        size_t ranges; ///< The number of ranges
+        const std::function<void(size_t, size_t)>* body; ///< The loop body - only valid while a range is unfinished
+        std::atomic<size_t> nextRange; ///< The next range to be claimed
+        std::mutex mutex; ///< Guards `finishedRanges` and `error`
+        std::condition_variable finishedCondition; ///< Notified when the last range finishes
+        size_t finishedRanges; ///< The number of ranges which have finished
+        std::exception_ptr error; ///< The first exception thrown by `body`
+        SO_ParallelForState(size_t countIn, size_t grainSizeIn, size_t rangesIn, const std::function<void(size_t, size_t)>& bodyIn);
+        void runRanges(void); ///< Claims and runs ranges until none are left
+    };
+    std::vector<std::unique_ptr<SO_TaskQueue>> queues; ///< One queue per worker thread
+    std::vector<std::thread> workers; ///< The worker threads
+    std::mutex sleepMutex; ///< The mutex idle workers wait on
+    std::condition_variable wakeCondition; ///< Notified when a task is pushed or the pool is stopping
+    std::atomic<size_t> queuedTasks; ///< The number of tasks sitting in the queues
+    std::atomic<unsigned int> nextQueue; ///< Round-robin counter used to spread tasks submitted from outside the pool
+    bool stopping = false; ///< Set (under sleepMutex) by the destructor to stop the workers
+    void workerLoop(unsigned int index); ///< The body of each worker thread
+    bool runQueuedTask(unsigned int preferredQueue); ///< Pops a task from `preferredQueue`, or steals one from another queue, and runs it. Returns false if every queue was empty
+    public:
+        /// Create a pool with `threadCount` worker threads - 0 uses one per core
+        SO_ThreadPool(unsigned int threadCount = 0);
+        ///The custom destructor for the SO_ThreadPool class
+        /**
+         * The destructor waits for all queued tasks to finish and then joins the worker threads.
+        **/
+        ~SO_ThreadPool(void);
+        SO_ThreadPool(const SO_ThreadPool&) = delete;
+        SO_ThreadPool& operator=(const SO_ThreadPool&) = delete;
+        /// returns the number of worker threads in the pool
+        unsigned int getThreadCount(void);
+        /// queue a task to be run on one of the worker threads
+        void push(std::function<void()> task);
+        /// queue a task to be run on one of the worker threads - returns a future holding the result (or exception) of the task
+        template <typename F> std::future<typename std::result_of<F()>::type> submit(F task) {
+            auto packaged = std::make_shared<std::packaged_task<typename std::result_of<F()>::type()>>(std::move(task));
+            push([packaged]() { (*packaged)(); });
+            return packaged->get_future();
+        }
+        /// runs `body(begin, end)` over [0, `count`) split into ranges of `grainSize`, blocking until every range is finished
+        /**
+         * The ranges are run on the worker threads and the calling thread. The calling thread only ever runs ranges of this call, never
+         * unrelated queued tasks, and sleeps rather than spinning once every range has been claimed. If any call of `body` throws, the first
+         * exception is rethrown once all the ranges have finished.
+        **/
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+        /// returns the pool shared by the library, creating it on first use
+        static SO_ThreadPool& global(void);
+};
+
 
 ///struct containing data for a simple mesh which can be used or manipulated by the user
 /**
@@ -405,6 +552,7 @@ class SO_FfmpegStream {
 struct SO_MeshData {
     std::vector<glm::vec3> vertices;
     std::vector<int> faceElements;
+    std::vector<glm::vec3> normals; ///< one unit normal per vertex, or empty if the mesh was created without normals (e.g. by createIcosphere())
 };
 
 ///creates a weighted sum of two vectors
@@ -418,16 +566,67 @@ glm::vec3 createRatioVector(int subdivisions, int division, glm::vec3 vector1, g
 /**
  * Creates a sphere mesh by taking an icosahedron and dividing each edge into `subdivisions` sections. 
  * Then the faces of the icosahedron are split up from the cuts of the edges.
- * Finally all the vertices are normalised to s distance 1 from the origin
+ * Finally all the vertices are normalised to s distance 1 from the origin.
+ * The mesh has 10*`subdivisions`^2 + 2 vertices and 20*`subdivisions`^2 triangles. Every index is known in closed form, so the arrays are sized
+ * once and the edges, the rows of each face and the normalisation are all spread over SO_ThreadPool::global(). `subdivisions` must be at least 1,
+ * and at most 14654 so the vertex indices fit in an int.
 **/
 SO_MeshData createIcosphere(int subdivisions);
 
+/// The OpenGL buffers of an icosphere, shared through icosphereBuffers()
+struct SO_IcosphereBuffers {
+    std::shared_ptr<const SO_MeshData> mesh; ///< The mesh in the buffers - held so it stays cached while the buffers are in use
+    GLuint vbo; ///< The vertex buffer - 3 floats per vertex, which serve as both the position and the normal as the sphere has radius 1
+    GLuint ebo; ///< The element buffer - 3 unsigned ints per triangle
+    GLsizei elementCount; ///< The number of elements to draw with glDrawElements()
+};
+
+/// returns the icosphere with `subdivisions`, from a process-wide cache of immutable meshes
+/**
+ * The first call for a level creates the mesh with createIcosphere() - later calls for that level share it, however many objects use it,
+ * until the last handle to it is released. Safe to call from any thread - callers asking for a level while it is being created wait for that one
+ * creation, and callers for other levels are not held up by it. `subdivisions` must be at least 1.
+**/
+std::shared_ptr<const SO_MeshData> cachedIcosphere(int subdivisions);
+/// returns a VBO and EBO holding cachedIcosphere(`subdivisions`), shared by every caller until the last handle is released - which deletes them
+/**
+ * The buffers are created in the current OpenGL context, so the function is for the OpenGL thread only and the handles should be released before
+ * the context is destroyed. Bind them to a VAO of your own - the vertex buffer can feed the "position" and "normal" attributes of SO_PhongShader alike.
+**/
+std::shared_ptr<const SO_IcosphereBuffers> icosphereBuffers(int subdivisions);
+
+/// extracts the surface where a sampled scalar field crosses `isoLevel` as an indexed triangle mesh, using marching cubes
+/**
+ * The sample at `samples[i + j*width + k*width*height]` is taken to lie at (`x0 + i*dx`, `y0 + j*dy`, `z0 + k*dz`) - the layout used by perlinGrid3D().
+ * The grid is split into blocks of `blockSize`^3 cells which are meshed in parallel on SO_ThreadPool::global(). Each grid edge the surface crosses
+ * gets a single vertex, shared by every triangle that uses it - including triangles in neighbouring blocks - so the mesh is closed wherever the
+ * surface doesn't leave the grid. Where the corners of a cube face are ambiguous the inside (> `isoLevel`) corners are kept apart, the same choice
+ * from both cubes sharing the face, so there are no cracks.
+ * Apart from the mesh itself the working memory grows with the number of vertices and with `blockSize`, not with the size of the grid.
+ *
+ * `normals` is filled with the normalised negative gradient of the field (by central differences on the grid), so normals point out of the region
+ * above `isoLevel`, and triangles are wound counter-clockwise seen from that side. Provided for float and double samples.
+**/
+template <typename T> SO_MeshData marchingCubes(const T* samples, int width, int height, int depth, double x0, double y0, double z0,
+                                                double dx, double dy, double dz, T isoLevel, int blockSize = 16);
+/// extracts the surface where `field(x, y, z)` crosses `isoLevel` on a `width`x`height`x`depth` grid of samples, using marching cubes
+/**
+ * The field is sampled at (`x0 + i*dx`, `y0 + j*dy`, `z0 + k*dz`) in parallel on SO_ThreadPool::global() - so `field` must be safe to call from
+ * several threads at once - and then meshed as the sampled form of marchingCubes().
+**/
+SO_MeshData marchingCubes(const std::function<double(double, double, double)>& field, int width, int height, int depth, double x0, double y0, double z0,
+                          double dx, double dy, double dz, double isoLevel, int blockSize = 16);
+
 /// Return 6t^5-15t^4+10t^3 - a smooth function between (0,0) and (1,1) with gradient 0 at each point
 double fade(double x);
+/// fade() in the precision `T` - provided for float and double
+template <typename T> T fade(T x);
 /// increments a number `num` looping around to 0 at the value of `repeat` (i.e. returns (num+1)%repeat if num >0) - not mod since it doesn't loop negative values
 int inc(int num, int repeat);
 /// gets the gradient of perlin corner (see algorithm)
 double grad(int hash, double x, double y, double z);
+/// grad() in the precision `T` - provided for float and double
+template <typename T> T grad(int hash, T x, T y, T z);
 
 /// linear interpolation for any type T with mulitplication an addition defined
 /**
@@ -442,12 +641,660 @@ template <typename T> T lerp(T a, T b, float x) {
  * returns `x - y*floor(x/y)`
 **/
 double modulus(double x, double y);
+/// modulus() in the precision `T` - provided for float and double
+template <typename T> T modulus(T x, T y);
 
 /// stores the table of permutations required to generate perlin noise
 extern int perlinPerms[512];
 
 /// generates perlin noise at coordinates `x`,`y`,`z`, with a repeat size of `repeat`
 double perlin(double x, double y, double z, double repeat);
+/// generates perlin noise in the precision `T` - provided for float and double
+/**
+ * `perlin<double>` is the implementation behind perlin() and gives identical results. `perlin<float>` runs the same algorithm entirely in float, 
+ * including the fade curve and interpolation - it agrees with perlin() to within about 1e-6 and is the better choice when the results are stored as float.
+ * Calling perlin() with four float arguments selects `perlin<float>`.
+**/
+template <typename T> T perlin(T x, T y, T z, T repeat);
+
+/// perlin<Wrap>() policy for noise which repeats every `Period` units, fixed at compile time - `Period` must be 16, 32, 64, 128 or 256
+template <int Period> struct SO_FixedPeriod {
+    static_assert(Period >= 16 && Period <= 256 && (Period & (Period - 1)) == 0, "SO_FixedPeriod needs a period of 16, 32, 64, 128 or 256");
+};
+
+/// generates perlin noise with the wrapping policy `Wrap` chosen at compile time - `SO_FixedPeriod<Period>`
+/**
+ * perlin() with a `repeat` wraps the coordinates by a runtime period and the lattice indices with comparisons. `perlin<SO_FixedPeriod<Period>>`
+ * compiles the period in, so the coordinates are wrapped with an exact multiply and the lattice indices with a mask - about 1.2-1.3x faster
+ * than perlin() on tests/K. The results are the same as perlin() with a `repeat` of `Period`, and they are provided for double and float
+ * (which runs in single precision as `perlin<float>` does).
+ * e.g. `perlin<SO_FixedPeriod<16> >(x, y, z)` gives noise which tiles every 16 units.
+**/
+template <typename Wrap> double perlin(double x, double y, double z);
+/// the single precision form of `perlin<Wrap>`
+template <typename Wrap> float perlin(float x, float y, float z);
+
+/// generates perlin noise at `count` points with coordinates `x[i]`,`y[i]`,`z[i]`, writing the results into `out[i]`
+/**
+ * This is a batch form of perlin() intended for large numbers of points, e.g. the vertices of a heightfield. The points are processed
+ * several at a time using AVX2 (4 points) or SSE4.2 (2 points) kernels, whichever is the best the CPU supports - this is checked at runtime
+ * so the library may be run on any x86 machine. If neither is supported perlin() is called for each point.
+ * The kernels use the same order of operations as perlin() so the results agree with it to within 1e-12 - when the library is built with
+ * SSE floating point maths (e.g. 64-bit builds) the results are bit-identical.
+ * `x`, `y`, `z` and `out` must each hold `count` doubles; `repeat` has the same meaning as in perlin().
+**/
+void perlinBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+/// the single precision form of perlinBatch() - the results match `perlin<float>`
+/**
+ * Working in float packs twice as many points into each vector (8 with AVX2, 4 with SSE4.2) and halves the memory traffic.
+ * The results agree with `perlin<float>` to within 1e-6 (bit-identical with SSE floating point maths).
+**/
+void perlinBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+
+/// generates perlin noise at coordinates `x`,`y`,`z` and writes its gradient (d/dx, d/dy, d/dz) into `gradient`
+/**
+ * The value is identical to perlin(). The gradient is worked out analytically from the same corner hashes and fade weights, so this costs
+ * little more than perlin() itself, where central differences need six further calls. The gradient of a heightfield `h = perlin(x, 0, z, repeat)`
+ * gives its normal directly as `normalize(-dh/dx, 1, -dh/dz)` (scaled by the height and coordinate scales).
+**/
+double perlinDerivative(double x, double y, double z, double repeat, glm::dvec3& gradient);
+/// generates perlin noise and its gradient at `count` points - the batch form of perlinDerivative()
+/**
+ * `out[i]` is as perlinBatch() and (`gradX[i]`, `gradY[i]`, `gradZ[i]`) is the gradient at point `i`. The same SIMD kernels and runtime
+ * selection as perlinBatch() are used, and the results agree with perlinDerivative() to within 1e-12.
+**/
+void perlinDerivativeBatch(const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat);
+/// the single precision form of perlinDerivativeBatch()
+void perlinDerivativeBatch(const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat);
+
+/// generates `channels` independent channels of perlin noise at coordinates `x`,`y`,`z` from one walk of the lattice, writing channel `c` into `out[c]`
+/**
+ * Calling perlin() once per channel at offset coordinates redoes all of the wrapping, lattice and fade work for each channel. Here that is done
+ * once, along with the 14 table lookups for the corner hashes, and each further channel only costs one more lookup per corner - channel 0 is
+ * perlin() itself and channel `c` looks each corner hash up again at an offset of `c`. `repeat` is as in perlin() and `channels` must be
+ * between 1 and 256 (std::invalid_argument is thrown otherwise). e.g. 3 channels give a noise vector per point, as used for particle advection.
+**/
+void perlinChannels(double x, double y, double z, double repeat, double* out, int channels);
+/// generates `channels` channels of perlin noise at `count` points, writing channel `c` of point `i` into `out[c*count + i]`
+/**
+ * The batch form of perlinChannels(), using the same runtime selected SSE4.2/AVX2 kernels as perlinBatch(). `out` must hold `channels*count` values.
+**/
+void perlinChannelsBatch(const double* x, const double* y, const double* z, double* out, size_t count, int channels, double repeat);
+/// the single precision form of perlinChannelsBatch()
+void perlinChannelsBatch(const float* x, const float* y, const float* z, float* out, size_t count, int channels, float repeat);
+/// generates divergence free curl noise at coordinates `x`,`y`,`z`, with a repeat size of `repeat`
+/**
+ * Returns the curl of the vector potential made of channels 0, 1 and 2 of perlinChannels(). The potential's gradients are worked out analytically
+ * as in perlinDerivative(), sharing one walk of the lattice, so the field has exactly zero divergence - particles advected by it swirl without
+ * bunching up or spreading out. The components are roughly in [-2, 2] per unit of the coordinates, so scale the coordinates and result to taste.
+**/
+glm::dvec3 curlNoise(double x, double y, double z, double repeat);
+/// generates curl noise at `count` points, writing the components into `outX[i]`, `outY[i]`, `outZ[i]`
+/**
+ * The batch form of curlNoise(), using the same runtime selected SSE4.2/AVX2 kernels as perlinBatch().
+**/
+void curlNoiseBatch(const double* x, const double* y, const double* z, double* outX, double* outY, double* outZ, size_t count, double repeat);
+/// the single precision form of curlNoiseBatch()
+void curlNoiseBatch(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count, float repeat);
+
+/// generates 2D perlin noise at coordinates `x`,`y`, with a repeat size of `repeat`
+/**
+ * perlin() on a plane, e.g. `perlin(x, y, 0.0, 0)` for a heightfield, still hashes and interpolates the 8 corners of a cube. This interpolates
+ * only the 4 corners of the lattice square around the point, with 2 table lookups per corner rather than 3, and one gradient from the 2D set
+ * (+-1, +-1), (+-1, 0), (0, +-1) each - about half the work. Like perlin() it returns values in [0, 1] (centred on 0.5), uses `perlinPerms`
+ * and repeats every `repeat` along each axis if `repeat` is greater than 0. The noise is not the same as any slice of perlin().
+**/
+double perlin2D(double x, double y, double repeat);
+/// the single precision form of perlin2D() - runs entirely in float, as `perlin<float>` does
+float perlin2D(float x, float y, float repeat);
+/// generates 2D perlin noise at `count` points with coordinates `x[i]`,`y[i]`, writing the results into `out[i]`
+/**
+ * The batch form of perlin2D(), using the same runtime selected SSE4.2/AVX2 kernels as perlinBatch(). The results are identical to perlin2D().
+**/
+void perlin2DBatch(const double* x, const double* y, double* out, size_t count, double repeat);
+/// the single precision form of perlin2DBatch() - the results are identical to the float perlin2D()
+void perlin2DBatch(const float* x, const float* y, float* out, size_t count, float repeat);
+
+/// generates 3D simplex noise at coordinates `x`,`y`,`z`, with a repeat size of `repeat`
+/**
+ * Simplex noise sums the contributions of the 4 corners of the tetrahedron containing the point, rather than interpolating between the 8 corners
+ * of a cube as perlin() does, which gives fewer axis-aligned artefacts. The scalar form skips corners too far away to contribute and is about
+ * 1.5x faster than perlin(), but the batch form has to weight all 4 corners in every lane and is not faster than perlinBatch() - about 0.9x
+ * without a `repeat` and 0.8x with one, where each corner also has to be wrapped. The saving in corners grows with the dimension, see simplex4D().
+ * Like perlin() it returns values in [0, 1] (centred on 0.5),
+ * uses `perlinPerms` and repeats every `repeat` along each axis if `repeat` is greater than 0 - the tetrahedra are those of the body centred cubic
+ * lattice, which tiles exactly with any whole number `repeat`. The noise is not the same as perlin() at the same coordinates.
+**/
+double simplex(double x, double y, double z, double repeat);
+/// generates 4D simplex noise at coordinates `x`,`y`,`z`,`w`
+/**
+ * Only the 5 corners of the 4D simplex containing the point are visited, where 4D perlin noise would need 16 - e.g. for 3D fields animated along `w`.
+ * Corners too far from the point to contribute are not hashed, so a call costs about the same as the 3D perlin() it would otherwise replace.
+ * Returns values in [0, 1]. Unlike 3D the 4D simplex lattice cannot be lined up with the axes, so it cannot repeat seamlessly and there is no
+ * `repeat` - use 3D simplex() or perlin() for tiling textures.
+**/
+double simplex4D(double x, double y, double z, double w);
+/// generates 3D simplex noise at `count` points with coordinates `x[i]`,`y[i]`,`z[i]`, writing the results into `out[i]`
+/**
+ * The batch form of simplex(), using the same runtime selected SSE4.2/AVX2 kernels as perlinBatch(). The results agree with simplex() to within 1e-12.
+**/
+void simplexBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+/// the single precision form of the 3D simplexBatch() - the results agree with simplex() to within about 1e-4, as the coordinates themselves are rounded to float
+void simplexBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+/// generates 4D simplex noise at `count` points with coordinates `x[i]`,`y[i]`,`z[i]`,`w[i]`, writing the results into `out[i]` - the batch form of simplex4D(), see simplexBatch()
+void simplex4DBatch(const double* x, const double* y, const double* z, const double* w, double* out, size_t count);
+/// the single precision form of simplex4DBatch()
+void simplex4DBatch(const float* x, const float* y, const float* z, const float* w, float* out, size_t count);
+
+/// fills `out` with perlin noise on a `width`x`height` grid in the plane at `z`
+/**
+ * The sample at `out[i + j*width]` is `perlin(x0 + i*dx, y0 + j*dy, z, repeat)` - the results are identical to calling perlin() for each sample.
+ * The per-coordinate work (wrapping, lattice cell and fade weight) is done once per row/column rather than once per sample, and the
+ * corner hashes are only recomputed when a row crosses into a new lattice cell, so this is much faster than calling perlin() in a loop.
+ * `out` must hold `width*height` doubles.
+**/
+void perlinGrid2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat);
+
+/// fills `out` with perlin noise on a `width`x`height`x`depth` grid
+/**
+ * The sample at `out[i + j*width + k*width*height]` is `perlin(x0 + i*dx, y0 + j*dy, z0 + k*dz, repeat)` - see perlinGrid2D().
+ * `out` must hold `width*height*depth` doubles.
+**/
+void perlinGrid3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat);
+
+/// a parallel form of perlinGrid2D() which splits the grid into tiles of about `grainSize` samples and runs them on SO_ThreadPool::global()
+/**
+ * The results are identical to perlinGrid2D(). The default `grainSize` of 4096 samples (32KB of output) keeps each tile's output in the L1 cache -
+ * tiles are made of whole rows where possible as the corner hashes are reused along each row. Smaller grains balance the load better on small grids.
+**/
+void perlinGridParallel2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat, size_t grainSize = 4096);
+
+/// a parallel form of perlinGrid3D() which splits the grid into tiles of about `grainSize` samples and runs them on SO_ThreadPool::global()
+/**
+ * The results are identical to perlinGrid3D() - see perlinGridParallel2D().
+**/
+void perlinGridParallel3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat, size_t grainSize = 4096);
+
+/// fills `out` with 2D perlin noise on a `width`x`height` grid
+/**
+ * The sample at `out[i + j*width]` is `perlin2D(x0 + i*dx, y0 + j*dy, repeat)` - the results are identical to calling perlin2D() for each sample.
+ * As in perlinGrid2D() the per-coordinate work is done once per row/column and the 4 corner hashes are only recomputed when a row crosses into a new lattice cell.
+ * `out` must hold `width*height` doubles.
+**/
+void perlin2DGrid(double* out, int width, int height, double x0, double y0, double dx, double dy, double repeat);
+
+/// a parallel form of perlin2DGrid() which splits the grid into tiles of about `grainSize` samples and runs them on SO_ThreadPool::global()
+/**
+ * The results are identical to perlin2DGrid() - see perlinGridParallel2D().
+**/
+void perlin2DGridParallel(double* out, int width, int height, double x0, double y0, double dx, double dy, double repeat, size_t grainSize = 4096);
+
+/// generates worley (cellular) noise at coordinates `x`,`y`,`z`, returning the distances to the nearest (F1, in x) and second nearest (F2, in y) feature points
+/**
+ * Space is cut into unit cells which each hold one feature point, placed by hashing the cell with the same permutation table lookups as perlin(),
+ * so the feature points are never stored and each sample only visits the 27 cells around its own - the cost is the same however many
+ * points the noise covers. F1 is less than sqrt(3) and F2 rarely passes 1.5 - F1 gives cells and F2 - F1 gives cracks along the cell edges.
+ * Very rarely (about 1 sample in 30000) F1 or F2 comes out too large, when the true nearest point is two cells away. `repeat` is as in perlin().
+**/
+glm::dvec2 worley(double x, double y, double z, double repeat);
+/// generates worley noise at `count` points, writing F1 into `outF1[i]` and F2 into `outF2[i]`
+/**
+ * The batch form of worley(), with identical results. Unlike perlinBatch() there are no SSE4.2/AVX2 kernels - the 81 table lookups per
+ * sample have to be gathered, and the vector kernels were no faster than worley() - so use worleyGrid2D()/worleyGrid3D() for regular grids.
+**/
+void worleyBatch(const double* x, const double* y, const double* z, double* outF1, double* outF2, size_t count, double repeat);
+/// the single precision form of worleyBatch()
+void worleyBatch(const float* x, const float* y, const float* z, float* outF1, float* outF2, size_t count, float repeat);
+/// fills `outF1` and `outF2` with worley noise on a `width`x`height` grid in the plane at `z`
+/**
+ * The samples at `outF1[i + j*width]` and `outF2[i + j*width]` are `worley(x0 + i*dx, y0 + j*dy, z, repeat)`. The lattice cells of each
+ * column and row are found once, and the feature points around a row are hashed once per cell rather than once per sample, which makes
+ * it about 1.5x faster than calling worley() for every sample. `outF1` and `outF2` must each hold `width*height` doubles.
+**/
+void worleyGrid2D(double* outF1, double* outF2, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat);
+/// fills `outF1` and `outF2` with worley noise on a `width`x`height`x`depth` grid - laid out as perlinGrid3D()
+void worleyGrid3D(double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat);
+/// a parallel form of worleyGrid2D() which splits the grid into tiles of about `grainSize` samples and runs them on SO_ThreadPool::global() - see perlinGridParallel2D()
+void worleyGridParallel2D(double* outF1, double* outF2, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat, size_t grainSize = 4096);
+/// a parallel form of worleyGrid3D() which splits the grid into tiles of about `grainSize` samples and runs them on SO_ThreadPool::global() - see perlinGridParallel2D()
+void worleyGridParallel3D(double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat, size_t grainSize = 4096);
+
+/// returns GLSL source defining `float perlin(vec3 p, float repeat)`, which gives the same noise as perlin() on the GPU
+/**
+ * The source declares the uniform `usampler1D perlinPerms` which must hold the texture made by createPerlinPermsTexture(), and a few helper
+ * functions prefixed with `perlin`. Paste it into a shader after the `#version` line (330 or later). The GPU works in single precision so the
+ * results agree with `perlin<float>` to about 1e-6, except very close to lattice cell boundaries where the GPU's mod() may round the other way.
+ * SO_PhongShader and SO_ModelShader include it when given SO_NOISE_COLOR or SO_NOISE_DISPLACEMENT.
+**/
+std::string perlinShaderSource(void);
+/// creates a 512 texel `GL_R8UI` 1D texture holding perlinPerms for perlinShaderSource() - returns the OpenGL texture ID, which the caller owns
+GLuint createPerlinPermsTexture(void);
+
+/// A perlin noise generator with its own seeded permutation table
+/**
+ * perlin() and the functions built on it all share the fixed table `perlinPerms`, so every noise field they produce is the same.
+ * Each SO_PerlinNoise shuffles the numbers 0-255 with its `seed` into a table of its own, so objects with different seeds give
+ * independent noise fields while objects with the same seed always give the same one. The table is stored as 512 bytes aligned to a
+ * 64 byte cache line (rather than the 2KB of ints in `perlinPerms`) so many noise layers can be sampled without crowding each other out of the L1 cache.
+ * The methods mirror the free functions - noise() is perlin(), noiseBatch() is perlinBatch() and noiseGrid2D() etc. are perlinGrid2D() etc. -
+ * and have the same accuracy and performance, just using this object's table.
+ * The table is built by the constructor and never changed, and all methods are const, so one object may be used from any number of threads at once.
+**/
+class SO_PerlinNoise {
+    unsigned int seed; ///< The seed the table was shuffled with
+    alignas(64) unsigned char table[512 + 3]; ///< The permutation table, repeated twice, starting on a cache line - plus 3 bytes of padding read by the AVX2 gathers
+    public:
+        /// Constructor for a perlin noise generator - the permutation table is shuffled by `std::mt19937` seeded with `seedIn`
+        SO_PerlinNoise(unsigned int seedIn = 0);
+        /// returns the seed passed to the constructor
+        unsigned int getSeed(void) const;
+        /// returns the 512 entry permutation table - entries `i` and `i+256` are equal
+        const unsigned char* getPermutations(void) const;
+        /// returns perlin noise at `x`,`y`,`z` with a repeat size of `repeat` - see perlin()
+        double noise(double x, double y, double z, double repeat = 0) const;
+        /// returns single precision perlin noise at `x`,`y`,`z` with a repeat size of `repeat` - see `perlin<float>`
+        float noise(float x, float y, float z, float repeat = 0) const;
+        /// writes the noise at the `count` points `x[i]`,`y[i]`,`z[i]` into `out[i]` - see perlinBatch()
+        void noiseBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat = 0) const;
+        /// the single precision form of noiseBatch() - see perlinBatch()
+        void noiseBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat = 0) const;
+        /// returns perlin noise at `x`,`y`,`z` and writes its gradient into `gradient` - see perlinDerivative()
+        double noiseDerivative(double x, double y, double z, glm::dvec3& gradient, double repeat = 0) const;
+        /// writes the noise and its gradient at the `count` points `x[i]`,`y[i]`,`z[i]` into `out[i]` and `gradX[i]`, `gradY[i]`, `gradZ[i]` - see perlinDerivativeBatch()
+        void noiseDerivativeBatch(const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat = 0) const;
+        /// the single precision form of noiseDerivativeBatch()
+        void noiseDerivativeBatch(const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat = 0) const;
+        /// fills `out` with noise on a `width`x`height` grid in the plane at `z` - see perlinGrid2D()
+        void noiseGrid2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat = 0) const;
+        /// fills `out` with noise on a `width`x`height`x`depth` grid - see perlinGrid3D()
+        void noiseGrid3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat = 0) const;
+        /// a parallel form of noiseGrid2D() - see perlinGridParallel2D()
+        void noiseGridParallel2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat = 0, size_t grainSize = 4096) const;
+        /// a parallel form of noiseGrid3D() - see perlinGridParallel3D()
+        void noiseGridParallel3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat = 0, size_t grainSize = 4096) const;
+};
+
+/// The ways SO_FractalNoise can combine its octaves
+enum SO_FractalType : unsigned int {
+    /// fractal brownian motion - the weighted sum of the octaves, giving smooth rolling noise
+    SO_FRACTAL_FBM = 0,
+    /// each octave is folded to 1-|n| and squared before summing, giving sharp ridges - e.g. mountain ranges
+    SO_FRACTAL_RIDGED = 1,
+    /// the weighted sum of the absolute value of each octave, giving billowing noise with creases - e.g. clouds or fire
+    SO_FRACTAL_TURBULENCE = 2
+};
+
+/// A class which sums several octaves of perlin noise
+/**
+ * Octave `i` samples perlin() at `frequency*lacunarity^i` times the coordinates and is weighted by `gain^i`, with the noise taken as
+ * the signed value 2*perlin()-1. The sum is divided by the total weight so every type returns values in [0, 1], like perlin().
+ * If `repeat` is greater than 0 the coordinates are wrapped once into [0, `repeat`) and octave `i` repeats every `repeat*frequency*lacunarity^i`,
+ * so the summed noise repeats every `repeat` provided `frequency` and `lacunarity` are whole numbers.
+ * noiseBatch() works through the points in small blocks, running every octave over a block with perlinBatch() while it is still in the cache, 
+ * so the input and output arrays are only read and written once however many octaves are used.
+**/
+class SO_FractalNoise {
+    public:
+        SO_FractalType type; ///< How the octaves are combined
+        int octaves; ///< The number of octaves summed
+        double frequency; ///< The frequency of the first octave
+        double lacunarity; ///< The factor the frequency is multiplied by for each successive octave
+        double gain; ///< The factor the weight is multiplied by for each successive octave
+        double repeat; ///< The period of the noise in each direction - 0 for non-repeating noise
+        /// Constructor for a fractal noise object - the arguments set the public members of the same name
+        SO_FractalNoise(SO_FractalType typeIn = SO_FRACTAL_FBM, int octavesIn = 6, double frequencyIn = 1.0, double lacunarityIn = 2.0, double gainIn = 0.5, double repeatIn = 0);
+        /// returns the fractal noise at `x`,`y`,`z`
+        double noise(double x, double y, double z) const;
+        /// writes the fractal noise at the `count` points `x[i]`,`y[i]`,`z[i]` into `out[i]` - the results match noise()
+        void noiseBatch(const double* x, const double* y, const double* z, double* out, size_t count) const;
+};
+
+/// A single channel 3D texture of noise which is generated on worker threads and streamed to the GPU a few slices at a time
+/**
+ * generate() allocates the texture and queues one task per z slice on SO_ThreadPool::global(), then returns straight away. Each frame the
+ * program calls update() on the OpenGL thread, which copies finished slices into a ring of pixel buffer objects and uploads them with
+ * glTexSubImage3D() - the copies are limited to `byteBudget` bytes per call so no single frame stalls, and a buffer is only reused once the
+ * GPU has finished reading from it. Once every slice is uploaded isReady() returns true and the future from getFuture() becomes ready,
+ * so a level can keep rendering while its textures arrive. finish() does the whole job immediately for use at startup.
+ * The texture is stored as `GL_R8`, with noise values in [0, 1] mapped to 0-255, and uses linear filtering and `GL_REPEAT` wrapping.
+ * \warning all methods other than isReady() and getFuture() must be called on the thread which owns the OpenGL context
+**/
+class SO_NoiseTexture {
+    /// The state shared with the generation tasks - held by shared pointer so tasks still running when the texture is destroyed or regenerated are safe
+    struct SO_NoiseTextureState {
+        std::vector<unsigned char> voxels; ///< The generated noise, one byte per texel, slice by slice
+        std::unique_ptr<std::atomic<bool>[]> sliceReady; ///< Set by the generation task when a slice of `voxels` is complete
+        std::atomic<bool> cancelled; ///< Set when the results are no longer wanted so queued tasks return straight away
+        std::mutex mutex; ///< Guards `error` and `slicesFinished`
+        std::condition_variable finishedCondition; ///< Notified each time a generation task finishes
+        std::exception_ptr error; ///< The first exception thrown by a generation task
+        int slicesFinished; ///< The number of generation tasks which have finished, whether they succeeded, threw or were cancelled
+    };
+    std::shared_ptr<SO_NoiseTextureState> state; ///< The state of the current generation
+    std::vector<bool> sliceUploaded; ///< Whether each slice has been passed to glTexSubImage3D()
+    int slicesUploaded = 0; ///< The number of true entries in `sliceUploaded`
+    GLuint textureID = 0; ///< The OpenGL texture ID
+    GLuint pixelBuffers[4] = {0, 0, 0, 0}; ///< The ring of pixel buffer objects slices are uploaded through
+    GLsync bufferFences[4] = {0, 0, 0, 0}; ///< Fences marking when the GPU has finished reading from each pixel buffer
+    unsigned int nextBuffer = 0; ///< The next pixel buffer in the ring to use
+    int width = 0; ///< The width of the texture in texels
+    int height = 0; ///< The height of the texture in texels
+    int depth = 0; ///< The depth of the texture in texels (the number of slices)
+    bool ready = false; ///< Whether every slice has been uploaded
+    bool failed = false; ///< Whether a generation task threw - the exception has been passed to `readyPromise`
+    std::atomic<bool> readyFlag; ///< A copy of `ready` which may be read from any thread
+    std::promise<void> readyPromise; ///< Fulfilled when the texture is ready, or given the generation error
+    std::shared_future<void> readyFuture; ///< The future of `readyPromise`
+    /// cancels any generation in progress and releases the OpenGL objects
+    void release(void);
+    /// the body of update() - waits up to `fenceTimeout` nanoseconds for the GPU to release each pixel buffer
+    bool uploadSlices(size_t byteBudget, GLuint64 fenceTimeout);
+    public:
+        /// Constructor for an empty noise texture - generate() creates the texture
+        SO_NoiseTexture(void);
+        SO_NoiseTexture(const SO_NoiseTexture&) = delete;
+        SO_NoiseTexture& operator=(const SO_NoiseTexture&) = delete;
+        /// The destructor deletes the texture and buffers - any slices still being generated are discarded
+        ~SO_NoiseTexture(void);
+        /// start generating a `widthIn`x`heightIn`x`depthIn` texture, where `sliceFunction(k, out)` writes the `widthIn*heightIn` noise values of slice `k` into `out`
+        /**
+         * `out[i + j*widthIn]` is the value of texel (i, j, k), and should be in [0, 1] - values outside are clamped. `sliceFunction` is called from
+         * worker threads, possibly several at once, so it must be thread safe. Any texture already generated or in progress is replaced -
+         * the future of a generation that is replaced before it finishes is given a std::runtime_error, so threads waiting on it wake up,
+         * and getFuture() must be called again for the new texture. If `sliceFunction` throws, the exception is passed to the future and
+         * the texture never becomes ready.
+        **/
+        void generate(int widthIn, int heightIn, int depthIn, std::function<void(int, double*)> sliceFunction);
+        /// start generating a texture where texel (i, j, k) is `noise.noise(i*scale, j*scale, k*scale, repeat)`
+        void generate(int widthIn, int heightIn, int depthIn, const SO_PerlinNoise& noise, double scale, double repeat = 0);
+        /// start generating a texture where texel (i, j, k) is `fractal.noise(i*scale, j*scale, k*scale)`
+        void generate(int widthIn, int heightIn, int depthIn, const SO_FractalNoise& fractal, double scale);
+        /// upload finished slices, copying at most `byteBudget` bytes (but always at least one slice if one is waiting) - returns isReady()
+        bool update(size_t byteBudget = 1 << 20);
+        /// block until every slice is generated and uploaded - rethrows any exception from the generation
+        /**
+         * The calling thread sleeps until the generation tasks have finished, then uploads every slice at once, waiting for the GPU if a
+         * pixel buffer is still in use.
+        **/
+        void finish(void);
+        /// returns whether the whole texture has been uploaded - may be called from any thread
+        bool isReady(void) const;
+        /// returns a future which becomes ready when the whole texture has been uploaded - may be waited on from any thread except the OpenGL thread
+        std::shared_future<void> getFuture(void) const;
+        /// returns the OpenGL texture ID - the texture exists as soon as generate() returns, but its contents are undefined until it is ready
+        GLuint getTextureID(void) const;
+        /// bind the texture to texture unit `unit`
+        void bind(unsigned int unit = 0) const;
+};
+
+/// Identifies one chunk of an SO_NoiseChunkCache
+struct SO_ChunkKey {
+    int layer; ///< The layer index returned by SO_NoiseChunkCache::addLayer()
+    int x; ///< The chunk coordinate along x
+    int y; ///< The chunk coordinate along y
+    int z; ///< The chunk coordinate along z - 0 for 2D layers
+    int lod; ///< The level of detail
+    /// Constructor for a chunk key - the arguments set the members of the same name
+    SO_ChunkKey(int layerIn = 0, int xIn = 0, int yIn = 0, int zIn = 0, int lodIn = 0);
+    bool operator==(const SO_ChunkKey& other) const;
+};
+
+/// The hash function used to look up SO_ChunkKey in an SO_NoiseChunkCache
+struct SO_ChunkKeyHash {
+    size_t operator()(const SO_ChunkKey& key) const;
+};
+
+/// A cache of chunks of generated noise, e.g. the heights of the terrain tiles around the camera, generated on worker threads
+/**
+ * Each layer has a generator function which fills the samples of one chunk given its SO_ChunkKey - what a chunk covers (its position, size
+ * and sample spacing at each level of detail) is up to the generator. getChunk() never blocks: it returns the chunk if it is in the cache,
+ * otherwise it queues the chunk on SO_ThreadPool::global() and returns an empty pointer, so the render thread just asks again next frame.
+ * At most `maxPending` chunks are generated at once - further requests are turned away until some finish, so chunks the camera has
+ * already moved past don't build up in the queue.
+ * Finished chunks are kept until the cache holds more than `byteBudget` bytes of samples, when the least recently used chunks are dropped
+ * (the newest chunk is always kept, even if it is larger than the budget).
+ * Chunks are handed out as shared pointers, so a chunk which is still in use stays valid after it has been dropped from the cache.
+ * All methods may be called from any thread.
+**/
+class SO_NoiseChunkCache {
+    public:
+        /// Fills the samples of the chunk with the given key - called on worker threads, so it must be thread safe
+        typedef std::function<void(const SO_ChunkKey&, double*)> SO_ChunkGenerator;
+        /// The samples of a generated chunk
+        typedef std::shared_ptr<const std::vector<double>> SO_Chunk;
+    private:
+        /// One generated or pending chunk
+        struct SO_ChunkEntry {
+            SO_Chunk samples; ///< The samples - empty until generated
+            bool ready = false; ///< Whether the chunk has been generated
+            std::exception_ptr error; ///< The exception thrown by the generator, if it failed
+            std::list<SO_ChunkKey>::iterator lruPosition; ///< The chunk's position in `lru` once ready
+        };
+        /// The state shared with the generation tasks - held by shared pointer so tasks still running when the cache is destroyed are safe
+        struct SO_ChunkCacheState {
+            std::mutex mutex; ///< Guards all of the state
+            std::vector<std::pair<size_t, SO_ChunkGenerator>> layers; ///< The sample count and generator of each layer
+            std::unordered_map<SO_ChunkKey, SO_ChunkEntry, SO_ChunkKeyHash> chunks; ///< Every generated and pending chunk
+            std::list<SO_ChunkKey> lru; ///< The generated chunks, most recently used first
+            size_t byteBudget; ///< The most bytes of samples kept once generated
+            size_t bytesUsed = 0; ///< The bytes of samples in the generated chunks
+            size_t maxPending; ///< The most chunks generated at once
+            size_t pending = 0; ///< The number of chunks being generated
+            unsigned int generation = 0; ///< Incremented by clear() so chunks generated before it are discarded
+        };
+        std::shared_ptr<SO_ChunkCacheState> state; ///< The cache state
+        /// drop least recently used chunks until the cache is within its budget - `state->mutex` must be held
+        static void evict(SO_ChunkCacheState& cacheState);
+        /// the implementation of getChunk() and request() - a failed chunk is dropped and its error only rethrown if `rethrow` is true
+        SO_Chunk lookup(const SO_ChunkKey& key, bool rethrow);
+    public:
+        /// Constructor for an empty cache which keeps up to `byteBudgetIn` bytes of samples and generates up to `maxPendingIn` chunks at once
+        SO_NoiseChunkCache(size_t byteBudgetIn = 256 << 20, size_t maxPendingIn = 64);
+        SO_NoiseChunkCache(const SO_NoiseChunkCache&) = delete;
+        SO_NoiseChunkCache& operator=(const SO_NoiseChunkCache&) = delete;
+        /// add a layer whose chunks have `samplesPerChunk` samples filled by `generator` - returns the layer index to use in SO_ChunkKey
+        int addLayer(size_t samplesPerChunk, SO_ChunkGenerator generator);
+        /// returns the chunk if it has been generated, otherwise queues it to be generated (if it isn't already) and returns an empty pointer
+        /**
+         * Never blocks on generation. If the generator threw an exception for this chunk it is rethrown here, once, and the next call tries again.
+        **/
+        SO_Chunk getChunk(const SO_ChunkKey& key);
+        /// queue the chunk to be generated if it isn't in the cache, without returning it - e.g. to prefetch the chunks ahead of the camera
+        /**
+         * If the generator threw an exception for this chunk the exception is discarded and the chunk is queued again - use getChunk() to see errors.
+        **/
+        void request(const SO_ChunkKey& key);
+        /// returns whether the chunk has been generated and is in the cache
+        bool isReady(const SO_ChunkKey& key);
+        /// drop every chunk - chunks still being generated are discarded when they finish
+        void clear(void);
+        /// change the byte budget, dropping chunks straight away if the cache is now over it
+        void setByteBudget(size_t byteBudgetIn);
+        /// returns the bytes of samples held by the generated chunks
+        size_t getBytesUsed(void);
+        /// returns the number of generated chunks in the cache
+        size_t getChunkCount(void);
+        /// returns the number of chunks being generated
+        size_t getPendingCount(void);
+};
+
+/// A terrain mesh made from a regular grid of heights, generated straight into a packed vertex buffer
+/**
+ * Sample (i, j) is vertex `i + j*width`, at (`x0 + i*dx`, height, `z0 + j*dz`) with y upwards as in SO_Camera. getVertices() holds 6 floats per
+ * vertex - the position then the unit normal - so the whole grid is uploaded with one glBufferData() and drawn with e.g. the "position" and "normal"
+ * attributes of SO_PhongShader. Normals come from central differences of the heights (one-sided at the edges of the grid) and are normalised 4 at a time with SSE2.
+ * Each setHeights() method fills the heights and then the vertices a few rows at a time on SO_ThreadPool::global().
+ * The triangles depend only on the grid size, so getElements() returns an index list shared by every heightfield of the same size, and
+ * createBuffers() shares one element buffer object between them in the same way. Triangles are wound counter-clockwise seen from above.
+ * The grid and vertices need no OpenGL context until createBuffers() is called.
+ * \warning createBuffers(), updateBuffers(), render() and - once the buffers exist - the destructor must be called on the thread which owns the OpenGL context
+**/
+class SO_Heightfield {
+    int width; ///< The number of samples along x
+    int depth; ///< The number of samples along z
+    float x0; ///< The x coordinate of the first sample
+    float z0; ///< The z coordinate of the first sample
+    float dx; ///< The distance between samples along x
+    float dz; ///< The distance between samples along z
+    std::vector<float> heights; ///< The height of each sample, x fastest
+    std::vector<float> vertices; ///< The packed positions and normals
+    std::shared_ptr<const std::vector<unsigned int>> elements; ///< The shared triangle list for this grid size
+    std::shared_ptr<const GLuint> elementBuffer; ///< The shared element buffer object for this grid size - empty until createBuffers()
+    GLuint vao = 0; ///< The vertex array object - 0 until createBuffers()
+    GLuint vbo = 0; ///< The vertex buffer object - 0 until createBuffers()
+    /// rebuild `vertices` from `heights`
+    void fillVertices(void);
+    public:
+        /// Constructor for a flat `widthIn`x`depthIn` heightfield with its first sample at (`x0In`, 0, `z0In`) and samples `dxIn` and `dzIn` apart
+        SO_Heightfield(int widthIn, int depthIn, float x0In = 0.0f, float z0In = 0.0f, float dxIn = 1.0f, float dzIn = 1.0f);
+        SO_Heightfield(const SO_Heightfield&) = delete;
+        SO_Heightfield& operator=(const SO_Heightfield&) = delete;
+        /// The destructor deletes the VAO and VBO if createBuffers() made them - the element buffer is deleted once no heightfield of this size uses it
+        ~SO_Heightfield(void);
+        /// copy the `width*depth` heights from `heightsIn`, where `heightsIn[i + j*width]` is the height of sample (i, j)
+        void setHeights(const float* heightsIn);
+        /// set the height of each sample to `heightFunction(x, z)` - called from worker threads, possibly several at once, so it must be thread safe
+        void setHeights(const std::function<float(float, float)>& heightFunction);
+        /// set the height of each sample to `amplitude*noise.noise(x*scale, z*scale, 0, repeat)`
+        void setHeights(const SO_PerlinNoise& noise, double scale, float amplitude, double repeat = 0);
+        /// set the height of each sample to `amplitude*fractal.noise(x*scale, z*scale, 0)`
+        void setHeights(const SO_FractalNoise& fractal, double scale, float amplitude);
+        /// returns the number of samples along x
+        int getWidth(void) const;
+        /// returns the number of samples along z
+        int getDepth(void) const;
+        /// returns the heights, x fastest
+        const std::vector<float>& getHeights(void) const;
+        /// returns the packed vertices - 6 floats per vertex, the position then the normal
+        const std::vector<float>& getVertices(void) const;
+        /// returns the triangle list - see gridElements()
+        std::shared_ptr<const std::vector<unsigned int>> getElements(void) const;
+        /// writes the packed vertices of a `widthIn`x`depthIn` grid into `out` on the calling thread, from heights with a border of one extra sample on every side
+        /**
+         * `borderedHeights` holds `(widthIn + 2)*(depthIn + 2)` heights, x fastest, with sample (i, j) of the grid at `borderedHeights[(i + 1) + (j + 1)*(widthIn + 2)]`.
+         * The border lets every normal be taken by central differences, so pieces of a larger terrain get the same normals either side of a seam.
+         * `out` must hold `widthIn*depthIn*6` floats.
+        **/
+        static void packVertices(const float* borderedHeights, int widthIn, int depthIn, float x0In, float z0In, float dxIn, float dzIn, float* out);
+        /// returns the triangle list of a `widthIn`x`depthIn` grid, 6 indices per cell - lists are cached while in use, so grids of the same size share one. Thread safe
+        static std::shared_ptr<const std::vector<unsigned int>> gridElements(int widthIn, int depthIn);
+        /// create the VAO and VBO, upload the vertices and attach the element buffer shared by heightfields of this size
+        /**
+         * `positionAttrib` and `normalAttrib` are the attribute locations the positions and normals are passed to - e.g. from glGetAttribLocation().
+         * Any buffers made by an earlier call are deleted first.
+        **/
+        void createBuffers(GLint positionAttrib = 0, GLint normalAttrib = 1);
+        /// upload the vertices again after the heights have changed
+        void updateBuffers(void);
+        /// draw the heightfield with whichever shader program is in use
+        void render(void) const;
+};
+
+/// A large heightfield terrain drawn as a grid of chunks, each generated on worker threads at a level of detail chosen from its distance to the camera
+/**
+ * The terrain covers `chunksX`x`chunksZ` chunks of `chunkCells`x`chunkCells` cells, `spacing` apart, starting at (`x0`, `z0`), with y upwards.
+ * A chunk at level of detail L is a grid of `chunkCells/2^L` cells, sampling every 2^L-th point of the full resolution grid - so the points a
+ * chunk shares with its neighbours are sampled at exactly the same positions at every level. Level 0 is used within `lodDistance` of the
+ * camera and each doubling of the distance beyond that adds a level, up to the level where a chunk is 2x2 cells. A chunk keeps its level until
+ * the camera is about 7% past the boundary, so it doesn't flip back and forth.
+ *
+ * update() runs once a frame on the OpenGL thread. It picks each chunk's level from the camera position and queues the chunks that need a new
+ * mesh on SO_ThreadPool::global(), chunks with nothing to draw first and then nearest first, with no more than `maxPending` queued at once.
+ * Each worker samples `heightFunction` with a one sample border, so the normals match across seams (see SO_Heightfield::packVertices()).
+ * update() then uploads finished meshes until `byteBudget` bytes have been uploaded that frame. A chunk keeps drawing its old mesh until the new one arrives.
+ *
+ * render() stitches each chunk to its coarser neighbours: the ring of cells along a shared edge is triangulated to the neighbour's vertices.
+ * The index lists depend only on the chunk's cell count and the level difference on each side, so they are built on first use and shared between chunks.
+ * The vertices use the packed layout of SO_Heightfield - the position then the normal - and are in world space.
+ * \warning all methods must be called on the thread which owns the OpenGL context
+**/
+class SO_Terrain {
+    /// A finished chunk mesh waiting to be uploaded
+    struct SO_TerrainMesh {
+        int chunk; ///< The index of the chunk
+        int lod; ///< The level of detail of the mesh
+        std::vector<float> vertices; ///< The packed vertices
+        float minHeight; ///< The lowest height in the mesh
+        float maxHeight; ///< The highest height in the mesh
+    };
+    /// The state shared with the generation tasks - held by shared pointer so tasks still running when the terrain is destroyed are safe
+    struct SO_TerrainState {
+        std::function<float(float, float)> heightFunction; ///< The height of the terrain at (x, z)
+        std::mutex mutex; ///< Guards `finished` and `error`
+        std::vector<SO_TerrainMesh> finished; ///< Meshes waiting for update() to upload them
+        std::exception_ptr error; ///< The first exception thrown by `heightFunction` since update() last reported one
+        std::atomic<bool> cancelled; ///< Set by the destructor so queued tasks return straight away
+    };
+    /// One chunk of the terrain
+    struct SO_TerrainChunk {
+        int lod = -1; ///< The level of detail of the mesh in `vbo` - -1 until the first mesh is uploaded
+        int targetLod = -1; ///< The level of detail chosen by the last update()
+        int pendingLod = -1; ///< The level of detail being generated - -1 if none is
+        float minHeight = 0.0f; ///< The lowest height in the uploaded mesh
+        float maxHeight = 0.0f; ///< The highest height in the uploaded mesh
+        GLuint vao = 0; ///< The vertex array object
+        GLuint vbo = 0; ///< The vertex buffer object
+    };
+    /// An element buffer for one chunk cell count and set of level differences
+    struct SO_TerrainElements {
+        GLuint ebo; ///< The element buffer object
+        GLsizei count; ///< The number of indices
+    };
+    std::shared_ptr<SO_TerrainState> state; ///< The state shared with the generation tasks
+    std::vector<SO_TerrainChunk> chunks; ///< The chunks, x fastest
+    std::map<unsigned long long, SO_TerrainElements> elementBuffers; ///< The element buffers made so far, keyed by elementKey()
+    int chunksX; ///< The number of chunks along x
+    int chunksZ; ///< The number of chunks along z
+    int chunkCells; ///< The number of cells along each side of a chunk at full detail
+    int maxLod; ///< The coarsest level of detail - a chunk of 2x2 cells
+    float spacing; ///< The distance between samples at full detail
+    float x0; ///< The x coordinate of the first sample
+    float z0; ///< The z coordinate of the first sample
+    GLint positionAttrib; ///< The attribute location of the positions
+    GLint normalAttrib; ///< The attribute location of the normals
+    size_t pending = 0; ///< The number of chunks being generated
+    /// queue the generation of chunk `chunk` at level `lod`
+    void queueChunk(int chunk, int lod);
+    /// returns the element buffer for a chunk of `cells` cells whose sides (-z, +x, +z, -x) are `lodSteps` levels finer than their neighbours, making it on first use
+    const SO_TerrainElements& elementBuffer(int cells, const int lodSteps[4]);
+    public:
+        float lodDistance; ///< The distance from the camera at which chunks drop from level 0 to level 1
+        size_t maxPending; ///< The most chunks generated at once
+        /// Constructor for a terrain of `chunksXIn`x`chunksZIn` chunks whose heights are `heightFunctionIn(x, z)`
+        /**
+         * `chunkCellsIn` must be a power of 2 of at least 2. `heightFunctionIn` is called from worker threads, possibly several at once, so it must be thread safe.
+         * `positionAttribIn` and `normalAttribIn` are the attribute locations the positions and normals are passed to - e.g. from glGetAttribLocation().
+         * No chunks are generated until the first update().
+        **/
+        SO_Terrain(std::function<float(float, float)> heightFunctionIn, int chunksXIn, int chunksZIn, int chunkCellsIn = 64, float spacingIn = 1.0f,
+                   float x0In = 0.0f, float z0In = 0.0f, float lodDistanceIn = 64.0f, GLint positionAttribIn = 0, GLint normalAttribIn = 1);
+        SO_Terrain(const SO_Terrain&) = delete;
+        SO_Terrain& operator=(const SO_Terrain&) = delete;
+        /// The destructor deletes the OpenGL objects - any chunks still being generated are discarded
+        ~SO_Terrain(void);
+        /// choose each chunk's level of detail from `camera`'s position, queue the chunks which need a new mesh and upload finished meshes
+        /**
+         * At most `byteBudget` bytes of vertices are uploaded (but always at least one mesh if one is waiting). If `heightFunction` threw
+         * while generating a chunk the exception is rethrown here, once, and the chunk is queued again on the next call.
+        **/
+        void update(const SO_Camera& camera, size_t byteBudget = 4 << 20);
+        /// call update() with no upload budget until every chunk is drawn at its chosen level - e.g. at startup
+        void finish(const SO_Camera& camera);
+        /// draw every chunk which has a mesh with whichever shader program is in use
+        void render(void);
+        /// returns the coarsest level of detail
+        int getMaxLod(void) const;
+        /// returns the level of detail chunk (`chunkX`, `chunkZ`) is drawn at - -1 if it has no mesh yet
+        int getChunkLod(int chunkX, int chunkZ) const;
+        /// returns the number of chunks being generated
+        size_t getPendingCount(void) const;
+        /// returns the indices of the triangles of a chunk of `cells`x`cells` cells whose sides (-z, +x, +z, -x) are `lodSteps` levels finer than their neighbours
+        /**
+         * Vertex (i, j) of the chunk is index `i + j*(cells + 1)`. A side with a level difference of d only uses every 2^d-th vertex along it, so it
+         * meets the coarser neighbour without cracks. Triangles are wound counter-clockwise seen from above.
+        **/
+        static std::vector<unsigned int> chunkElements(int cells, const int lodSteps[4]);
+};
 
 /// A class which allows easy creation and use of colormaps
 /**
@@ -457,21 +1304,76 @@ double perlin(double x, double y, double z, double repeat);
 **/
 class SO_ColorMap {
     private:
-        std::map<float, glm::vec3> colors; ///< The map of colours and associated positions
+        std::vector<float> positions; ///< The key positions in ascending order - kept apart from the colours so the search only touches positions
+        std::vector<glm::vec3> colors; ///< The key colours - `colors[i]` is the colour at `positions[i]`
+        /// A table of colours sampled evenly between the lowest and highest key positions
+        struct SO_ColorTable {
+            std::shared_ptr<const float> entries; ///< 4 floats (RGB and an alpha of 1) per entry, aligned to a cache line - empty if the map is. Shared by copies as it is never modified
+            int resolution = 0; ///< The number of intervals - one less than the number of entries
+            float start = 0.0f; ///< The position of the first entry - the lowest key position
+            float scale = 0.0f; ///< The number of intervals per unit of position
+        };
+        SO_ColorTable lut; ///< The baked table - its resolution is 0 when not baked
+        SO_ColorTable makeTable(int resolution) const; ///< Sample the map into a new table of `resolution` intervals
     public:
-        void setValue(float position, glm::vec3 color); ///< Set a keyColor and position in the map
-        void deleteValue(float position); ///< Delete the keyColor at `position`. If no color is present at the position, there is no effect.
-        std::vector<float> getPositions(); ///< Returns an ordered vector of the key positions within the map
-        std::vector<glm::vec3> getColors(); ///< Returns an ordered vector of the key colours in the map - order corresponds with the vector returned by getPositions()
+        void setValue(float position, glm::vec3 color); ///< Set a keyColor and position in the map - rebuilds the baked table if there is one
+        void deleteValue(float position); ///< Delete the keyColor at `position`. If no color is present at the position, there is no effect. Rebuilds the baked table if there is one
+        /// Sample the map into a table of `resolution` equal intervals between the lowest and highest key positions, which getLerpColor() then uses
+        /**
+         * With a baked table getLerpColor() is an index and one linear interpolation between neighbouring table entries, however many keys there are.
+         * The result is exact at the table entries and between them wherever no key lies inside the interval - a key inside an interval has its
+         * corner rounded off, by at most the colour change across one interval. Positions beyond the lowest and highest keys still return the end colours.
+         * setValue() and deleteValue() rebuild the table straight away. `resolution` must be at least 1.
+        **/
+        void bake(int resolution = 1024);
+        void unbake(void); ///< Discard the baked table so getLerpColor() walks the map again
+        bool isBaked(void) const; ///< Returns whether bake() is in effect
+        const std::vector<float>& getPositions() const; ///< Returns the key positions within the map in ascending order - a reference to the map's own storage, valid until the keys change
+        const std::vector<glm::vec3>& getColors() const; ///< Returns the key colours in the map - order corresponds with getPositions(), and valid until the keys change
+        size_t getSize(void) const; ///< Returns the number of keys in the map
         /// Returns a color from a linear interpolation of the keyColors
         /**
          * The SO_ColorMap is used to create a smooth color gradient. The `min` and `max` variables are taken as the expected extremes of the data, 
          * and normalised laong with `value` to the range [0, 1]. If `value<min` or `value>max` then positions outside the range [0,1] can be accessed.
          * This is not forbidden behaviour. If the requested `value` lies between two known key positions after normalisation then the linear interpolation
          *  of the two key colors is returned. If the `value` beyond the minimum or maximum known key position then the minimum or maximum colors are returned.
-         * If the SO_ColorMap is empty then `glm::vec3(0.0f, 0.0f, 0.0f)` is returned.
+         * If the SO_ColorMap is empty then `glm::vec3(0.0f, 0.0f, 0.0f)` is returned. The keys are found by binary search, so long maps stay cheap.
+         * If the map is baked the table is used instead - see bake().
+        **/
+        glm::vec3 getLerpColor(float min, float max, float value) const;
+        /// Writes getLerpColor(`min`, `max`, `values[i]`) for the `count` values into `out` as 3 floats per value
+        /**
+         * The baked table is used if there is one - otherwise a table of the default bake() resolution is made for the call - so the results
+         * match getLerpColor() on a baked map exactly. The values are mapped 4 at a time with SSE2 in ranges of `grainSize` values split across SO_ThreadPool::global(),
+         * writing each colour straight to `out`. `out` must hold `3*count` floats.
+        **/
+        void getLerpColorBatch(float min, float max, const float* values, float* out, size_t count, size_t grainSize = 65536) const;
+        /// Writes the colours of getLerpColorBatch() into `out` as 4 bytes per value - RGB clamped to [0, 1] and rounded to 0-255, and an alpha of 255
+        /**
+         * `out` must hold `4*count` bytes - e.g. an RGBA8 texture or pixel buffer.
+        **/
+        void getLerpColorBatchRGBA8(float min, float max, const float* values, unsigned char* out, size_t count, size_t grainSize = 65536) const;
+        /// Returns the range (min, max) of `values` to map - the lowest and highest finite values, or the given percentiles of them
+        /**
+         * The lowest and highest values are found 4 at a time with SSE2 in ranges of `grainSize` values split across SO_ThreadPool::global().
+         * If `lowPercentile` or `highPercentile` (0 to 100) clip the range, a second pass counts the values into `bins` equal bins between the
+         * extremes - each range fills its own histogram and they are summed - and the percentiles are interpolated within their bins, so they are
+         * accurate to 1/`bins` of the full range. Clipping a percent or so at each end stops a few outliers squashing the map into a single colour.
+         * NaN and infinite values are ignored, and (0, 0) is returned if there are no finite values.
+        **/
+        static glm::vec2 findRange(const float* values, size_t count, float lowPercentile = 0.0f, float highPercentile = 100.0f, int bins = 4096, size_t grainSize = 65536);
+        /// getLerpColorBatch() over the range from findRange() with the given percentiles - returns the range used
+        glm::vec2 getAutoLerpColorBatch(const float* values, float* out, size_t count, float lowPercentile = 0.0f, float highPercentile = 100.0f, size_t grainSize = 65536) const;
+        /// getLerpColorBatchRGBA8() over the range from findRange() with the given percentiles - returns the range used
+        glm::vec2 getAutoLerpColorBatchRGBA8(const float* values, unsigned char* out, size_t count, float lowPercentile = 0.0f, float highPercentile = 100.0f, size_t grainSize = 65536) const;
+        /// Creates a GL_RGBA8 1D texture of the map for SO_SCALAR_ATTRIBUTE - returns the OpenGL texture ID
+        /**
+         * The texture holds `resolution + 1` colours sampled evenly from the lowest to the highest key position, as bake() does, with linear filtering
+         * and clamping to the edges. A single key gives a single colour, and an empty map a single opaque black texel. `resolution` must be at least 1.
         **/
-        glm::vec3 getLerpColor(float min, float max, float value);
+        GLuint createTexture(int resolution = 1024) const;
+        /// Rewrites the colours of a texture from createTexture() after the keys have changed - the texture is resized to `resolution + 1` texels
+        void updateTexture(GLuint textureID, int resolution = 1024) const;
 };
 
 GLuint loadTextureFromFile(std::string path); ///< Loads a texture from an image file - returns OpenGL texture ID
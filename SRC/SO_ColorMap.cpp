@@ -1,45 +1,453 @@
 /** \file SO_ColorMap.cpp */
 #include "sceneObjects.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+namespace {
+
+//the table getLerpColor() samples, copied out so the batch kernels don't touch the shared_ptr
+struct ColorTableView {
+    const float* entries;
+    int resolution;
+    float start;
+    float scale;
+};
+
+//sample the table at normalised `value` into the 4 floats of `color` - the single definition of the baked lookup
+inline void colorTableSample(const ColorTableView& table, float value, float* color) {
+    float t = (value - table.start)*table.scale;
+    t = t > 0.0f ? (t < table.resolution ? t : (float)table.resolution) : 0.0f;
+    int index = (int)t < table.resolution ? (int)t : table.resolution - 1;
+    const float* entry = table.entries + 4*index;
+    float fraction = t - index;
+    for (int channel = 0; channel < 4; channel++) {
+        color[channel] = entry[channel] + fraction*(entry[channel + 4] - entry[channel]);
+    }
+}
+
+//the index of the first of the `count` ascending `positions` which `value` is not above - `count` if it is above them all, as it is for NaN
+//each halving step is a select rather than a branch, so the search runs in log2(count) steps whatever the value
+inline size_t colorKeyIndex(const float* positions, size_t count, float value) {
+    const float* base = positions;
+    size_t length = count;
+    while (length > 1) {
+        size_t half = length/2;
+        base = !(value <= base[half - 1]) ? base + half : base;
+        length -= half;
+    }
+    return (base - positions) + (count > 0 && !(value <= *base));
+}
+
+//the lowest and highest finite values in [begin, end), written to `low` and `high` - which are left alone if there are none
+//non-finite lanes are replaced by the running extremes before they are compared, so they can never win
+inline void finiteRange(const float* values, size_t begin, size_t end, float& low, float& high) {
+    size_t i = begin;
+#ifdef __SSE2__
+    if (end - begin >= 4) {
+        __m128 lows = _mm_set1_ps(low);
+        __m128 highs = _mm_set1_ps(high);
+        __m128i magnitude = _mm_set1_epi32(0x7fffffff);
+        __m128i infinity = _mm_set1_epi32(0x7f800000);
+        for (; i + 4 <= end; i += 4) {
+            __m128 value = _mm_loadu_ps(values + i);
+            __m128 finite = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_and_si128(_mm_castps_si128(value), magnitude), infinity));
+            lows = _mm_min_ps(lows, _mm_or_ps(_mm_and_ps(finite, value), _mm_andnot_ps(finite, lows)));
+            highs = _mm_max_ps(highs, _mm_or_ps(_mm_and_ps(finite, value), _mm_andnot_ps(finite, highs)));
+        }
+        alignas(16) float lanes[8];
+        _mm_store_ps(lanes, lows);
+        _mm_store_ps(lanes + 4, highs);
+        for (int lane = 0; lane < 4; lane++) {
+            low = lanes[lane] < low ? lanes[lane] : low;
+            high = lanes[lane + 4] > high ? lanes[lane + 4] : high;
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        if (std::isfinite(values[i])) {
+            low = values[i] < low ? values[i] : low;
+            high = values[i] > high ? values[i] : high;
+        }
+    }
+}
+
+//a histogram of the values in [low, high] in equal bins, with a count of the values below it
+struct HistogramWindow {
+    float low;
+    float high;
+    size_t below;
+    std::vector<size_t> counts;
+};
+
+//fill each window from the finite values in one parallel pass - each range counts into its own copies and adds them in under a lock
+void fillHistograms(const float* values, size_t count, size_t grainSize, std::vector<HistogramWindow>& windows) {
+    std::mutex windowMutex;
+    sceneObjects::SO_ThreadPool::global().parallelFor(count, grainSize, [&](size_t begin, size_t end) {
+        std::vector<HistogramWindow> local;
+        for (const HistogramWindow& window : windows) {
+            local.push_back(HistogramWindow{window.low, window.high, 0, std::vector<size_t>(window.counts.size(), 0)});
+        }
+        for (HistogramWindow& window : local) {
+            float binScale = window.counts.size()/(window.high - window.low);
+            int lastBin = (int)window.counts.size() - 1;
+            for (size_t i = begin; i < end; i++) {
+                float value = values[i];
+                if (!std::isfinite(value)) {
+                    continue;
+                }
+                if (value < window.low) {
+                    window.below++;
+                } else if (value <= window.high) {
+                    int bin = (int)((value - window.low)*binScale);
+                    window.counts[bin < lastBin ? bin : lastBin]++;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(windowMutex);
+        for (size_t w = 0; w < windows.size(); w++) {
+            windows[w].below += local[w].below;
+            for (size_t bin = 0; bin < windows[w].counts.size(); bin++) {
+                windows[w].counts[bin] += local[w].counts[bin];
+            }
+        }
+    });
+}
+
+//the value with `rank` of the counted values below it, interpolated within its bin of `window` - whose edges go to `binLow` and `binHigh`
+float windowPercentile(const HistogramWindow& window, double rank, float& binLow, float& binHigh) {
+    double below = (double)window.below;
+    size_t bin = 0;
+    while (bin + 1 < window.counts.size() && below + window.counts[bin] < rank) {
+        below += window.counts[bin];
+        bin++;
+    }
+    double binWidth = ((double)window.high - window.low)/window.counts.size();
+    double within = window.counts[bin] > 0 ? (rank - below)/window.counts[bin] : 0.0;
+    within = within < 0.0 ? 0.0 : (within > 1.0 ? 1.0 : within);
+    binLow = (float)(window.low + bin*binWidth);
+    binHigh = bin + 1 < window.counts.size() ? (float)(window.low + (bin + 1)*binWidth) : window.high;
+    return (float)(window.low + (bin + within)*binWidth);
+}
+
+//a colour channel in [0, 1] as a byte, rounding to nearest
+inline unsigned char colorByte(float channel) {
+    return (unsigned char)((channel > 0.0f ? (channel < 1.0f ? channel : 1.0f) : 0.0f)*255.0f + 0.5f);
+}
+
+#ifdef __SSE2__
+//sample the table at 4 values at once into `colors`, one RGBA colour per value
+//the float operations are those of getLerpColor() and colorTableSample() in the same order, so the colours are bit-identical
+//max(t, 0) gives 0 for NaN as the scalar comparison does
+inline void colorTableSample4(const ColorTableView& table, __m128 min, __m128 range, const float* values, __m128* colors) {
+    __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(_mm_sub_ps(_mm_loadu_ps(values), min), range), _mm_set1_ps(table.start)), _mm_set1_ps(table.scale));
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps((float)table.resolution));
+    __m128i index = _mm_cvttps_epi32(_mm_min_ps(t, _mm_set1_ps((float)(table.resolution - 1))));
+    __m128 fraction = _mm_sub_ps(t, _mm_cvtepi32_ps(index));
+    alignas(16) int indices[4];
+    alignas(16) float fractions[4];
+    _mm_store_si128((__m128i*)indices, index);
+    _mm_store_ps(fractions, fraction);
+    for (int i = 0; i < 4; i++) {
+        const float* entry = table.entries + 4*indices[i];
+        __m128 first = _mm_load_ps(entry);
+        colors[i] = _mm_add_ps(first, _mm_mul_ps(_mm_set1_ps(fractions[i]), _mm_sub_ps(_mm_load_ps(entry + 4), first)));
+    }
+}
+#endif
+
+}
+
+
+//insert the key in order, or replace the colour of an existing key at the same position
 void sceneObjects::SO_ColorMap::setValue(float position, glm::vec3 color) {
-    colors[position] = color;
+    size_t index = std::lower_bound(positions.begin(), positions.end(), position) - positions.begin();
+    if (index < positions.size() && positions[index] == position) {
+        colors[index] = color;
+    } else {
+        positions.insert(positions.begin() + index, position);
+        colors.insert(colors.begin() + index, color);
+    }
+    if (lut.resolution > 0) {
+        lut = makeTable(lut.resolution);
+    }
 }
 
 void sceneObjects::SO_ColorMap::deleteValue(float position) {
-    if (colors.count(position) != 1) { //key exists
-        colors.erase(colors.find(position));
+    size_t index = std::lower_bound(positions.begin(), positions.end(), position) - positions.begin();
+    if (index < positions.size() && positions[index] == position) { //key exists
+        positions.erase(positions.begin() + index);
+        colors.erase(colors.begin() + index);
+        if (lut.resolution > 0) {
+            lut = makeTable(lut.resolution);
+        }
     } //otherwise no need to do anything
 }
 
-std::vector<float> sceneObjects::SO_ColorMap::getPositions() {
-    std::vector<float> positions;
-    for (auto it = colors.begin(); it != colors.end(); it++) {
-        positions.push_back(it->first);
+void sceneObjects::SO_ColorMap::bake(int resolution) {
+    if (resolution < 1) {
+        throw std::invalid_argument("SO_ColorMap::bake() requires a resolution of at least 1, got " + std::to_string(resolution));
     }
-    return positions;
+    lut = makeTable(resolution);
+}
+
+void sceneObjects::SO_ColorMap::unbake(void) {
+    lut = SO_ColorTable();
+}
+
+bool sceneObjects::SO_ColorMap::isBaked(void) const {
+    return lut.resolution > 0;
 }
 
-std::vector<glm::vec3> sceneObjects::SO_ColorMap::getColors() {
-    std::vector<glm::vec3> returnColors;
-    for (auto it = colors.begin(); it != colors.end(); it++) {
-        returnColors.push_back(it->second);
+//walk the keys alongside the table entries, interpolating exactly as the unbaked getLerpColor() does
+//a new table is made each time rather than written in place, so copies of the map sharing the old one are unaffected
+sceneObjects::SO_ColorMap::SO_ColorTable sceneObjects::SO_ColorMap::makeTable(int resolution) const {
+    SO_ColorTable table;
+    table.resolution = resolution;
+    if (positions.empty()) {
+        return table;
+    }
+    float first = positions.front();
+    float last = positions.back();
+    std::shared_ptr<float> block(new float[4*(resolution + 1) + 16], std::default_delete<float[]>());
+    float* entries = (float*)(((uintptr_t)block.get() + 63) & ~(uintptr_t)63);
+    size_t next = 0;
+    for (int entry = 0; entry <= resolution; entry++) {
+        float position = entry == resolution ? last : first + entry*((last - first)/resolution);
+        while (next < positions.size() && positions[next] < position) {
+            next++;
+        }
+        glm::vec3 color;
+        if (next == 0) {
+            color = colors.front();
+        } else if (next == positions.size()) {
+            color = colors.back();
+        } else {
+            color = lerp(colors[next - 1], colors[next], (position - positions[next - 1])/(positions[next] - positions[next - 1]));
+        }
+        entries[4*entry + 0] = color.x;
+        entries[4*entry + 1] = color.y;
+        entries[4*entry + 2] = color.z;
+        entries[4*entry + 3] = 1.0f;
     }
-    return returnColors;
+    table.start = first;
+    table.scale = last > first ? resolution/(last - first) : 0.0f;
+    table.entries = std::shared_ptr<const float>(block, entries);
+    return table;
+}
+
+const std::vector<float>& sceneObjects::SO_ColorMap::getPositions() const {
+    return positions;
+}
+
+const std::vector<glm::vec3>& sceneObjects::SO_ColorMap::getColors() const {
+    return colors;
 }
 
-glm::vec3 sceneObjects::SO_ColorMap::getLerpColor(float min, float max, float value) {
-    if (colors.size() == 0) { //return black if no color
+size_t sceneObjects::SO_ColorMap::getSize(void) const {
+    return positions.size();
+}
+
+glm::vec3 sceneObjects::SO_ColorMap::getLerpColor(float min, float max, float value) const {
+    if (positions.empty()) { //return black if no color
         return glm::vec3(0.0f, 0.0f, 0.0f);
     }
     value = (value - min)/(max - min); //normalise values
-    if (value <= colors.begin()->first) {
-        return colors.begin()->second; // if below min value return lowest value
+    if (lut.entries) { //index into the baked table - clamping to its ends gives the end colours beyond the keys
+        float color[4];
+        colorTableSample({lut.entries.get(), lut.resolution, lut.start, lut.scale}, value, color);
+        return glm::vec3(color[0], color[1], color[2]);
+    }
+    size_t index = colorKeyIndex(positions.data(), positions.size(), value);
+    if (index == 0) {
+        return colors.front(); // if below min value return lowest value
+    }
+    if (index == positions.size()) {
+        return colors.back(); //if above max value return greatest value
+    }
+    return lerp(colors[index - 1], colors[index], (value - positions[index - 1])/(positions[index] - positions[index - 1])); // otherwise a linear interpolation
+}
+
+//map ranges of the values across the thread pool, through the baked table or a temporary one of the default resolution
+//each range runs 4 values at a time through colorTableSample4(), finishing with the scalar lookup
+void sceneObjects::SO_ColorMap::getLerpColorBatch(float min, float max, const float* values, float* out, size_t count, size_t grainSize) const {
+    SO_ColorTable table = lut.entries ? lut : makeTable(1024);
+    if (!table.entries) { //black if no color
+        std::fill(out, out + 3*count, 0.0f);
+        return;
+    }
+    ColorTableView view = {table.entries.get(), table.resolution, table.start, table.scale};
+    SO_ThreadPool::global().parallelFor(count, grainSize, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#ifdef __SSE2__
+        __m128 minimum = _mm_set1_ps(min);
+        __m128 range = _mm_set1_ps(max - min);
+        __m128 samples[4];
+        for (; i + 4 <= end; i += 4) {
+            colorTableSample4(view, minimum, range, values + i, samples);
+            //each store spills its padding lane into the next colour, which the next store overwrites - the last colour is stored in two parts so nothing past the group is written
+            float* rgb = out + 3*i;
+            _mm_storeu_ps(rgb, samples[0]);
+            _mm_storeu_ps(rgb + 3, samples[1]);
+            _mm_storeu_ps(rgb + 6, samples[2]);
+            _mm_storel_pi((__m64*)(rgb + 9), samples[3]);
+            _mm_store_ss(rgb + 11, _mm_movehl_ps(samples[3], samples[3]));
+        }
+#endif
+        for (; i < end; i++) {
+            float color[4];
+            colorTableSample(view, (values[i] - min)/(max - min), color);
+            out[3*i + 0] = color[0];
+            out[3*i + 1] = color[1];
+            out[3*i + 2] = color[2];
+        }
+    });
+}
+
+//as getLerpColorBatch(), converting each group of 4 colours to 16 bytes with saturating packs - the table's alpha of 1 becomes 255
+void sceneObjects::SO_ColorMap::getLerpColorBatchRGBA8(float min, float max, const float* values, unsigned char* out, size_t count, size_t grainSize) const {
+    SO_ColorTable table = lut.entries ? lut : makeTable(1024);
+    if (!table.entries) { //opaque black if no color
+        for (size_t i = 0; i < count; i++) {
+            out[4*i + 0] = out[4*i + 1] = out[4*i + 2] = 0;
+            out[4*i + 3] = 255;
+        }
+        return;
+    }
+    ColorTableView view = {table.entries.get(), table.resolution, table.start, table.scale};
+    SO_ThreadPool::global().parallelFor(count, grainSize, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#ifdef __SSE2__
+        __m128 minimum = _mm_set1_ps(min);
+        __m128 range = _mm_set1_ps(max - min);
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 scale = _mm_set1_ps(255.0f);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 samples[4];
+        __m128i bytes[4];
+        for (; i + 4 <= end; i += 4) {
+            colorTableSample4(view, minimum, range, values + i, samples);
+            for (int j = 0; j < 4; j++) {
+                __m128 channels = _mm_min_ps(_mm_max_ps(samples[j], zero), one);
+                bytes[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(channels, scale), half));
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(bytes[0], bytes[1]), _mm_packs_epi32(bytes[2], bytes[3]));
+            _mm_storeu_si128((__m128i*)(out + 4*i), packed);
+        }
+#endif
+        for (; i < end; i++) {
+            float color[4];
+            colorTableSample(view, (values[i] - min)/(max - min), color);
+            out[4*i + 0] = colorByte(color[0]);
+            out[4*i + 1] = colorByte(color[1]);
+            out[4*i + 2] = colorByte(color[2]);
+            out[4*i + 3] = colorByte(color[3]);
+        }
+    });
+}
+
+//create a 1D texture for SO_PhongShader's SO_SCALAR_ATTRIBUTE, filled by updateTexture()
+GLuint sceneObjects::SO_ColorMap::createTexture(int resolution) const {
+    if (resolution < 1) {
+        throw std::invalid_argument("SO_ColorMap::createTexture() requires a resolution of at least 1, got " + std::to_string(resolution));
+    }
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_1D, textureID);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    updateTexture(textureID, resolution);
+    return textureID;
+}
+
+//upload the table entries as bytes - the shader puts the key range across the texel centres, so linear filtering is the table's interpolation
+//one key gives a table whose entries are all equal, which is uploaded as a single texel
+void sceneObjects::SO_ColorMap::updateTexture(GLuint textureID, int resolution) const {
+    if (resolution < 1) {
+        throw std::invalid_argument("SO_ColorMap::updateTexture() requires a resolution of at least 1, got " + std::to_string(resolution));
     }
-    for (auto it = std::next(colors.begin()); it != colors.end(); ++it) { // if below max value returns a linear interpolation
-        if (value <= it->first) {
-            auto prev = std::prev(it);
-            return lerp(prev->second, it->second, (value - prev->first)/(it->first - prev->first));
+    int texels = positions.size() > 1 ? resolution + 1 : 1;
+    std::vector<unsigned char> bytes(4*texels, 0);
+    SO_ColorTable table = makeTable(resolution);
+    for (int texel = 0; texel < texels; texel++) {
+        for (int channel = 0; channel < 4; channel++) {
+            bytes[4*texel + channel] = table.entries ? colorByte(table.entries.get()[4*texel + channel]) : (channel == 3 ? 255 : 0);
         }
     }
-    return std::prev(colors.end())->second; //if above max value return greatest value
-}
\ No newline at end of file
+    glBindTexture(GL_TEXTURE_1D, textureID);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, texels, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+//reduce the ranges to their extremes, then if clipping is asked for histogram the values between them and read the percentiles off
+//the extremes of each range sit in a slot of their own, as parallelFor() always splits at multiples of grainSize
+glm::vec2 sceneObjects::SO_ColorMap::findRange(const float* values, size_t count, float lowPercentile, float highPercentile, int bins, size_t grainSize) {
+    if (!(lowPercentile >= 0.0f && lowPercentile <= highPercentile && highPercentile <= 100.0f)) {
+        throw std::invalid_argument("SO_ColorMap::findRange() requires 0 <= lowPercentile <= highPercentile <= 100, got " + std::to_string(lowPercentile) + " and " + std::to_string(highPercentile));
+    }
+    if (bins < 1) {
+        throw std::invalid_argument("SO_ColorMap::findRange() requires at least 1 bin, got " + std::to_string(bins));
+    }
+    grainSize = grainSize > 0 ? grainSize : 1;
+    std::vector<glm::vec2> rangeExtremes((count + grainSize - 1)/grainSize, glm::vec2(INFINITY, -INFINITY));
+    SO_ThreadPool::global().parallelFor(count, grainSize, [&](size_t begin, size_t end) {
+        float low = INFINITY;
+        float high = -INFINITY;
+        finiteRange(values, begin, end, low, high);
+        rangeExtremes[begin/grainSize] = glm::vec2(low, high);
+    });
+    float low = INFINITY;
+    float high = -INFINITY;
+    for (const glm::vec2& extremes : rangeExtremes) {
+        low = extremes.x < low ? extremes.x : low;
+        high = extremes.y > high ? extremes.y : high;
+    }
+    if (low > high) { //no finite values
+        return glm::vec2(0.0f, 0.0f);
+    }
+    if ((lowPercentile <= 0.0f && highPercentile >= 100.0f) || low == high) {
+        return glm::vec2(low, high);
+    }
+
+    //histogram the whole range, then while the bins are coarse against the clipped range - as when a few outliers stretch the full range -
+    //histogram just the bins the percentiles fell in, both in one pass
+    std::vector<HistogramWindow> windows(1, HistogramWindow{low, high, 0, std::vector<size_t>(bins, 0)});
+    fillHistograms(values, count, grainSize, windows);
+    size_t total = windows[0].below;
+    for (size_t binCount : windows[0].counts) {
+        total += binCount;
+    }
+    double lowRank = lowPercentile/100.0*total;
+    double highRank = highPercentile/100.0*total;
+    float lowBin[2], highBin[2];
+    float clippedLow = windowPercentile(windows[0], lowRank, lowBin[0], lowBin[1]);
+    float clippedHigh = windowPercentile(windows[0], highRank, highBin[0], highBin[1]);
+    for (int refinement = 0; refinement < 2 && (lowBin[1] - lowBin[0])*256.0f > clippedHigh - clippedLow; refinement++) {
+        windows.assign(1, HistogramWindow{lowBin[0], lowBin[1], 0, std::vector<size_t>(bins, 0)});
+        windows.push_back(HistogramWindow{highBin[0], highBin[1], 0, std::vector<size_t>(bins, 0)});
+        fillHistograms(values, count, grainSize, windows);
+        clippedLow = windowPercentile(windows[0], lowRank, lowBin[0], lowBin[1]);
+        clippedHigh = windowPercentile(windows[1], highRank, highBin[0], highBin[1]);
+    }
+    return glm::vec2(lowPercentile > 0.0f ? clippedLow : low, highPercentile < 100.0f ? clippedHigh : high);
+}
+
+glm::vec2 sceneObjects::SO_ColorMap::getAutoLerpColorBatch(const float* values, float* out, size_t count, float lowPercentile, float highPercentile, size_t grainSize) const {
+    glm::vec2 range = findRange(values, count, lowPercentile, highPercentile, 4096, grainSize);
+    getLerpColorBatch(range.x, range.y, values, out, count, grainSize);
+    return range;
+}
+
+glm::vec2 sceneObjects::SO_ColorMap::getAutoLerpColorBatchRGBA8(const float* values, unsigned char* out, size_t count, float lowPercentile, float highPercentile, size_t grainSize) const {
+    glm::vec2 range = findRange(values, count, lowPercentile, highPercentile, 4096, grainSize);
+    getLerpColorBatchRGBA8(range.x, range.y, values, out, count, grainSize);
+    return range;
+}
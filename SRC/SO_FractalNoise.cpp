@@ -0,0 +1,119 @@
+/** \file SO_FractalNoise.cpp */
+#include "sceneObjects.hpp"
+#include <cmath>
+
+namespace {
+
+//the number of points noiseBatch() works on at a time - 3 coordinate blocks and a result block fit comfortably in L1
+const size_t fractalBlockSize = 256;
+
+/// The per-octave settings used by noiseBatch()
+struct SO_Octaves {
+    std::vector<double> frequencies; ///< the coordinate scale of each octave
+    std::vector<double> weights; ///< the weight of each octave
+    std::vector<double> repeats; ///< the period of each octave, in scaled coordinates
+    double totalWeight = 0; ///< the sum of `weights`
+};
+
+SO_Octaves octaveSettings(const sceneObjects::SO_FractalNoise& fractal) {
+    SO_Octaves settings;
+    double frequency = fractal.frequency;
+    double weight = 1.0;
+    for (int i = 0; i < fractal.octaves; i++) {
+        settings.frequencies.push_back(frequency);
+        settings.weights.push_back(weight);
+        settings.repeats.push_back(fractal.repeat > 0 ? fractal.repeat*frequency : 0);
+        settings.totalWeight += weight;
+        frequency *= fractal.lacunarity;
+        weight *= fractal.gain;
+    }
+    return settings;
+}
+
+//the contribution of one octave with perlin value p, before weighting
+inline double octaveValue(sceneObjects::SO_FractalType type, double p) {
+    double signedNoise = 2*p - 1;
+    switch (type) {
+        case sceneObjects::SO_FRACTAL_RIDGED: {
+            double ridge = 1 - std::fabs(signedNoise);
+            return ridge*ridge;
+        }
+        case sceneObjects::SO_FRACTAL_TURBULENCE: return std::fabs(signedNoise);
+        default: return signedNoise;
+    }
+}
+
+//map the weighted sum into [0, 1]
+inline double fractalResult(sceneObjects::SO_FractalType type, double sum, double totalWeight) {
+    if (totalWeight == 0) {
+        return type == sceneObjects::SO_FRACTAL_FBM ? 0.5 : 0;
+    }
+    if (type == sceneObjects::SO_FRACTAL_FBM) {
+        return (sum/totalWeight + 1)/2;
+    }
+    return sum/totalWeight;
+}
+
+}
+
+sceneObjects::SO_FractalNoise::SO_FractalNoise(SO_FractalType typeIn, int octavesIn, double frequencyIn, double lacunarityIn, double gainIn, double repeatIn) {
+    type = typeIn;
+    octaves = octavesIn;
+    frequency = frequencyIn;
+    lacunarity = lacunarityIn;
+    gain = gainIn;
+    repeat = repeatIn;
+}
+
+double sceneObjects::SO_FractalNoise::noise(double x, double y, double z) const {
+    if (repeat > 0) { //wrap once - every octave's period is a multiple of repeat
+        x = modulus(x, repeat);
+        y = modulus(y, repeat);
+        z = modulus(z, repeat);
+    }
+    //the octave settings are built up in the same order as octaveSettings() so noiseBatch() gives identical results
+    double f = frequency;
+    double weight = 1.0;
+    double totalWeight = 0;
+    double sum = 0;
+    for (int i = 0; i < octaves; i++) {
+        sum += weight*octaveValue(type, perlin(x*f, y*f, z*f, repeat > 0 ? repeat*f : 0));
+        totalWeight += weight;
+        f *= lacunarity;
+        weight *= gain;
+    }
+    return fractalResult(type, sum, totalWeight);
+}
+
+//run every octave over one small block of points at a time so the arrays are only streamed through once
+void sceneObjects::SO_FractalNoise::noiseBatch(const double* x, const double* y, const double* z, double* out, size_t count) const {
+    SO_Octaves settings = octaveSettings(*this);
+    double wrappedX[fractalBlockSize], wrappedY[fractalBlockSize], wrappedZ[fractalBlockSize];
+    double octaveX[fractalBlockSize], octaveY[fractalBlockSize], octaveZ[fractalBlockSize];
+    double values[fractalBlockSize], sums[fractalBlockSize];
+    for (size_t start = 0; start < count; start += fractalBlockSize) {
+        size_t blockSize = count - start < fractalBlockSize ? count - start : fractalBlockSize;
+        for (size_t i = 0; i < blockSize; i++) {
+            wrappedX[i] = repeat > 0 ? modulus(x[start + i], repeat) : x[start + i];
+            wrappedY[i] = repeat > 0 ? modulus(y[start + i], repeat) : y[start + i];
+            wrappedZ[i] = repeat > 0 ? modulus(z[start + i], repeat) : z[start + i];
+            sums[i] = 0;
+        }
+        for (int octave = 0; octave < octaves; octave++) {
+            double f = settings.frequencies[octave];
+            for (size_t i = 0; i < blockSize; i++) {
+                octaveX[i] = wrappedX[i]*f;
+                octaveY[i] = wrappedY[i]*f;
+                octaveZ[i] = wrappedZ[i]*f;
+            }
+            perlinBatch(octaveX, octaveY, octaveZ, values, blockSize, settings.repeats[octave]);
+            double weight = settings.weights[octave];
+            for (size_t i = 0; i < blockSize; i++) {
+                sums[i] += weight*octaveValue(type, values[i]);
+            }
+        }
+        for (size_t i = 0; i < blockSize; i++) {
+            out[start + i] = fractalResult(type, sums[i], settings.totalWeight);
+        }
+    }
+}
@@ -0,0 +1,271 @@
+/** \file SO_Heightfield.cpp */
+#include "sceneObjects.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//the number of samples each row task aims to work through, as for the parallel noise grids
+const size_t heightfieldGrainSize = 4096;
+
+//the number of rows given to each task for a grid `width` samples wide
+size_t heightfieldRowsPerTask(int width) {
+    return (size_t)width < heightfieldGrainSize ? heightfieldGrainSize/width : 1;
+}
+
+//write the packed positions and normals of one row at `z` into `out` - the normal is (-dh/dx, 1, -dh/dz) normalised
+//`previous` and `next` are the rows either side, `scaleZ` is 1 over the distance between them, and if `bordered` is set the row has an extra sample at each end
+void heightfieldRow(const float* row, const float* previous, const float* next, float scaleZ, bool bordered, float* out, int width,
+                    float x0, float z, float dx, float* scratch) {
+    float* slopeX = scratch;
+    float* slopeZ = scratch + width;
+    float* normalX = scratch + 2*width;
+    float* normalY = scratch + 3*width;
+    float* normalZ = scratch + 4*width;
+    for (int i = 0; i < width; i++) {
+        slopeZ[i] = (next[i] - previous[i])*scaleZ;
+    }
+    int first = bordered ? 0 : 1;
+    int last = bordered ? width : width - 1;
+    for (int i = first; i < last; i++) {
+        slopeX[i] = (row[i + 1] - row[i - 1])*(0.5f/dx);
+    }
+    if (!bordered) {
+        slopeX[0] = (row[1] - row[0])/dx;
+        slopeX[width - 1] = (row[width - 1] - row[width - 2])/dx;
+    }
+
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= width; i += 4) {
+        __m128 gx = _mm_loadu_ps(slopeX + i);
+        __m128 gz = _mm_loadu_ps(slopeZ + i);
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gz, gz)), one)));
+        _mm_storeu_ps(normalX + i, _mm_xor_ps(_mm_mul_ps(gx, inverseLength), signBit));
+        _mm_storeu_ps(normalY + i, inverseLength);
+        _mm_storeu_ps(normalZ + i, _mm_xor_ps(_mm_mul_ps(gz, inverseLength), signBit));
+    }
+#endif
+    for (; i < width; i++) {
+        float inverseLength = 1.0f/std::sqrt(slopeX[i]*slopeX[i] + slopeZ[i]*slopeZ[i] + 1.0f);
+        normalX[i] = -(slopeX[i]*inverseLength);
+        normalY[i] = inverseLength;
+        normalZ[i] = -(slopeZ[i]*inverseLength);
+    }
+
+    float* vertex = out;
+    for (i = 0; i < width; i++, vertex += 6) {
+        vertex[0] = x0 + i*dx;
+        vertex[1] = row[i];
+        vertex[2] = z;
+        vertex[3] = normalX[i];
+        vertex[4] = normalY[i];
+        vertex[5] = normalZ[i];
+    }
+}
+
+//fill the heights a few rows at a time on the thread pool - `rowFunction(j, count, out)` writes `count` rows starting at row j
+void heightfieldFillRows(std::vector<float>& heights, int width, int depth, const std::function<void(int, int, float*)>& rowFunction) {
+    sceneObjects::SO_ThreadPool::global().parallelFor(depth, heightfieldRowsPerTask(width), [&](size_t begin, size_t end) {
+        rowFunction((int)begin, (int)(end - begin), heights.data() + begin*width);
+    });
+}
+
+//an element buffer shared by the heightfields of one size - only touched on the OpenGL thread
+std::shared_ptr<const GLuint> sharedElementBuffer(int width, int depth, const std::vector<unsigned int>& elements) {
+    static std::map<std::pair<int, int>, std::weak_ptr<const GLuint>> buffers;
+    std::shared_ptr<const GLuint> buffer = buffers[std::make_pair(width, depth)].lock();
+    if (buffer) {
+        return buffer;
+    }
+    GLuint* ebo = new GLuint;
+    glGenBuffers(1, ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(unsigned int), elements.data(), GL_STATIC_DRAW);
+    buffer = std::shared_ptr<const GLuint>(ebo, [](const GLuint* id) {
+        glDeleteBuffers(1, id);
+        delete id;
+    });
+    buffers[std::make_pair(width, depth)] = buffer;
+    return buffer;
+}
+
+}
+
+sceneObjects::SO_Heightfield::SO_Heightfield(int widthIn, int depthIn, float x0In, float z0In, float dxIn, float dzIn) {
+    if (widthIn < 2 || depthIn < 2) {
+        throw std::invalid_argument("SO_Heightfield requires at least 2 samples along each axis");
+    }
+    width = widthIn;
+    depth = depthIn;
+    x0 = x0In;
+    z0 = z0In;
+    dx = dxIn;
+    dz = dzIn;
+    heights.assign((size_t)width*depth, 0.0f);
+    vertices.resize((size_t)width*depth*6);
+    elements = gridElements(width, depth);
+    fillVertices();
+}
+
+//a heightfield which never made its buffers makes no OpenGL calls, so it can be used without a context
+sceneObjects::SO_Heightfield::~SO_Heightfield(void) {
+    if (vao) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+    }
+}
+
+//rows are independent once the heights are known, so they are split across the pool with a scratch buffer per task
+void sceneObjects::SO_Heightfield::fillVertices(void) {
+    SO_ThreadPool::global().parallelFor(depth, heightfieldRowsPerTask(width), [&](size_t begin, size_t end) {
+        std::vector<float> scratch((size_t)width*5);
+        for (size_t j = begin; j < end; j++) {
+            const float* row = heights.data() + j*width;
+            const float* previous = j > 0 ? row - width : row;
+            const float* next = j + 1 < (size_t)depth ? row + width : row;
+            float scaleZ = 1.0f/((next - previous)/width)/dz;
+            heightfieldRow(row, previous, next, scaleZ, false, vertices.data() + j*width*6, width, x0, z0 + j*dz, dx, scratch.data());
+        }
+    });
+}
+
+//the same as fillVertices() but on the calling thread, and with every normal taken by central differences thanks to the border
+void sceneObjects::SO_Heightfield::packVertices(const float* borderedHeights, int widthIn, int depthIn, float x0In, float z0In, float dxIn, float dzIn, float* out) {
+    std::vector<float> scratch((size_t)widthIn*5);
+    size_t stride = widthIn + 2;
+    for (int j = 0; j < depthIn; j++) {
+        const float* row = borderedHeights + (j + 1)*stride + 1;
+        heightfieldRow(row, row - stride, row + stride, 0.5f/dzIn, true, out + (size_t)j*widthIn*6, widthIn, x0In, z0In + j*dzIn, dxIn, scratch.data());
+    }
+}
+
+void sceneObjects::SO_Heightfield::setHeights(const float* heightsIn) {
+    std::copy(heightsIn, heightsIn + heights.size(), heights.begin());
+    fillVertices();
+}
+
+void sceneObjects::SO_Heightfield::setHeights(const std::function<float(float, float)>& heightFunction) {
+    heightfieldFillRows(heights, width, depth, [&](int j, int rows, float* out) {
+        for (int row = 0; row < rows; row++) {
+            float z = z0 + (j + row)*dz;
+            for (int i = 0; i < width; i++) {
+                *out++ = heightFunction(x0 + i*dx, z);
+            }
+        }
+    });
+    fillVertices();
+}
+
+//each task fills its rows with one call of noiseGrid2D(), which reuses the lattice work along the rows
+void sceneObjects::SO_Heightfield::setHeights(const SO_PerlinNoise& noise, double scale, float amplitude, double repeat) {
+    heightfieldFillRows(heights, width, depth, [&](int j, int rows, float* out) {
+        std::vector<double> values((size_t)width*rows);
+        noise.noiseGrid2D(values.data(), width, rows, x0*scale, (z0 + j*(double)dz)*scale, dx*scale, dz*scale, 0, repeat);
+        for (size_t n = 0; n < values.size(); n++) {
+            out[n] = amplitude*(float)values[n];
+        }
+    });
+    fillVertices();
+}
+
+void sceneObjects::SO_Heightfield::setHeights(const SO_FractalNoise& fractal, double scale, float amplitude) {
+    heightfieldFillRows(heights, width, depth, [&](int j, int rows, float* out) {
+        std::vector<double> xs(width), zs(width), zeros(width, 0.0), values(width);
+        for (int i = 0; i < width; i++) {
+            xs[i] = (x0 + i*(double)dx)*scale;
+        }
+        for (int row = 0; row < rows; row++) {
+            std::fill(zs.begin(), zs.end(), (z0 + (j + row)*(double)dz)*scale);
+            fractal.noiseBatch(xs.data(), zs.data(), zeros.data(), values.data(), width);
+            for (int i = 0; i < width; i++) {
+                *out++ = amplitude*(float)values[i];
+            }
+        }
+    });
+    fillVertices();
+}
+
+int sceneObjects::SO_Heightfield::getWidth(void) const {
+    return width;
+}
+
+int sceneObjects::SO_Heightfield::getDepth(void) const {
+    return depth;
+}
+
+const std::vector<float>& sceneObjects::SO_Heightfield::getHeights(void) const {
+    return heights;
+}
+
+const std::vector<float>& sceneObjects::SO_Heightfield::getVertices(void) const {
+    return vertices;
+}
+
+std::shared_ptr<const std::vector<unsigned int>> sceneObjects::SO_Heightfield::getElements(void) const {
+    return elements;
+}
+
+//the lists are held by weak pointer, so a size's list is freed once no heightfield uses it
+std::shared_ptr<const std::vector<unsigned int>> sceneObjects::SO_Heightfield::gridElements(int widthIn, int depthIn) {
+    static std::mutex cacheMutex;
+    static std::map<std::pair<int, int>, std::weak_ptr<const std::vector<unsigned int>>> cache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::shared_ptr<const std::vector<unsigned int>> cached = cache[std::make_pair(widthIn, depthIn)].lock();
+    if (cached) {
+        return cached;
+    }
+    std::shared_ptr<std::vector<unsigned int>> list = std::make_shared<std::vector<unsigned int>>((size_t)(widthIn - 1)*(depthIn - 1)*6);
+    unsigned int* element = list->data();
+    for (int j = 0; j < depthIn - 1; j++) {
+        for (int i = 0; i < widthIn - 1; i++) {
+            unsigned int corner = (unsigned int)(i + j*widthIn);
+            element[0] = corner;
+            element[1] = corner + widthIn;
+            element[2] = corner + 1;
+            element[3] = corner + 1;
+            element[4] = corner + widthIn;
+            element[5] = corner + widthIn + 1;
+            element += 6;
+        }
+    }
+    cache[std::make_pair(widthIn, depthIn)] = list;
+    return list;
+}
+
+void sceneObjects::SO_Heightfield::createBuffers(GLint positionAttrib, GLint normalAttrib) {
+    if (vao) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+    }
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    //binding the shared buffer while the VAO is bound attaches it to the VAO
+    elementBuffer = sharedElementBuffer(width, depth, *elements);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *elementBuffer);
+
+    glEnableVertexAttribArray(positionAttrib);
+    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)0);
+    glEnableVertexAttribArray(normalAttrib);
+    glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
+    glBindVertexArray(0);
+}
+
+void sceneObjects::SO_Heightfield::updateBuffers(void) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size()*sizeof(float), vertices.data());
+}
+
+void sceneObjects::SO_Heightfield::render(void) const {
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, elements->size(), GL_UNSIGNED_INT, 0);
+}
@@ -2,8 +2,11 @@
 #include "sceneObjects.hpp"
 
 // generate a shader program for a assimp mesh
-GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTextures, int specularTextures, int normalTextures) {
+GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTextures, int specularTextures, int normalTextures, unsigned int optionsIn) {
     numberLights = numberLightsIn;
+    options = optionsIn & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT);
+    bool noiseColor = (options & SO_NOISE_COLOR) == SO_NOISE_COLOR;
+    bool noiseDisplacement = (options & SO_NOISE_DISPLACEMENT) == SO_NOISE_DISPLACEMENT;
     std::string vertexSourceStr;
     vertexSourceStr = R"glsl(
         #version 330 core
@@ -28,6 +31,20 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
         out vec3 norm;
         )glsl";
     }
+    if (noiseColor) {
+        vertexSourceStr += "\nout vec3 noisePos;";
+    }
+    if (noiseColor || noiseDisplacement) {
+        vertexSourceStr += R"glsl(
+        uniform float noiseScale;
+        uniform vec3 noiseOffset;)glsl";
+    }
+    if (noiseDisplacement) {
+        vertexSourceStr += R"glsl(
+        uniform float noiseRepeat;
+        uniform float noiseAmplitude;)glsl" + perlinShaderSource();
+    }
+    std::string vertexPosition = noiseDisplacement ? "displaced" : "position";
     vertexSourceStr += R"glsl(
 
         uniform mat4 normalMatrix;
@@ -35,8 +52,15 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
         uniform mat4 view;
         uniform mat4 proj;
 
-        void main() {
-            gl_Position = proj * view *  model * vec4(position, 1.0);)glsl";
+        void main() {)glsl";
+    if (noiseColor) {
+        vertexSourceStr += "\n\tnoisePos = position*noiseScale + noiseOffset;";
+    }
+    if (noiseDisplacement) {
+        vertexSourceStr += "\n\tvec3 displaced = position + normal*(noiseAmplitude*(2.0*perlin(position*noiseScale + noiseOffset, noiseRepeat) - 1.0));";
+    }
+    vertexSourceStr += R"glsl(
+            gl_Position = proj * view *  model * vec4()glsl" + vertexPosition + R"glsl(, 1.0);)glsl";
     if (normalTextures > 0) {
         vertexSourceStr += R"glsl(
             vec3 T = normalize(vec3(normalMatrix * vec4(tangent, 0.0)));
@@ -53,7 +77,7 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
         )glsl";
     }
     vertexSourceStr += R"glsl(
-            worldPos = vec3(model * vec4(position, 1.0));
+            worldPos = vec3(model * vec4()glsl" + vertexPosition + R"glsl(, 1.0));
             TexCoord = texCoord;
         }
     )glsl";
@@ -85,12 +109,21 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
         in vec3 norm;
         )glsl";
     }
+    std::string diffuseColor = (diffuseTextures == 0) ? "colorDiffuse" : "texture(textureDiffuse, TexCoord).xyz";
+    if (noiseColor) {
+        fragmentSourceStr += R"glsl(
+        in vec3 noisePos;
+        uniform float noiseRepeat;
+        uniform vec3 noiseColor;
+        float noiseValue; // set once in main() for every light)glsl" + perlinShaderSource();
+        diffuseColor = "mix(noiseColor, " + diffuseColor + ", noiseValue)";
+    }
     fragmentSourceStr += R"glsl(
 
         out vec4 outColor;
 
         uniform vec3 viewPos;
-        uniform unsigned int specPower;
+        uniform uint specPower;
         uniform PointLight lights[)glsl" + std::to_string(numberLights) + R"glsl(];
 
         uniform )glsl" + (std::string)((diffuseTextures == 0) ? "vec3 colorDiffuse" : "sampler2D textureDiffuse") + R"glsl(;
@@ -109,8 +142,8 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
             float attenuation = 1.0 / (light.constant + light.linear * distance + 
                         light.quadratic * (distance * distance));   
             // combine results
-            vec3 ambient  = light.ambient  * )glsl" + (std::string)((diffuseTextures == 0) ? "colorDiffuse" : "texture(textureDiffuse, TexCoord).xyz") + R"glsl(;
-            vec3 diffuse  = light.diffuse  * diff * )glsl" + (std::string)((diffuseTextures == 0) ? "colorDiffuse" : "texture(textureDiffuse, TexCoord).xyz") + R"glsl(;
+            vec3 ambient  = light.ambient  * )glsl" + diffuseColor + R"glsl(;
+            vec3 diffuse  = light.diffuse  * diff * )glsl" + diffuseColor + R"glsl(;
             vec3 specular = light.specular * spec * )glsl" + (std::string)((specularTextures == 0) ? "colorSpecular" : "texture(textureSpecular, TexCoord).xyz") + R"glsl(;
             ambient  *= attenuation;
             diffuse  *= attenuation;
@@ -120,6 +153,9 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
 
         void main()
         {)glsl";
+    if (noiseColor) {
+        fragmentSourceStr += "\n\tnoiseValue = perlin(noisePos, noiseRepeat);";
+    }
     if (normalTextures > 0) {
         fragmentSourceStr += R"glsl(
             vec3 norm = texture(textureNormal, TexCoord).rgb;
@@ -144,6 +180,24 @@ GLuint sceneObjects::SO_ModelShader::generate(int numberLightsIn, int diffuseTex
     viewPositionLoc = glGetUniformLocation(this->getProgramID(), "viewPos");
     specularPowerLoc = glGetUniformLocation(this->getProgramID(), "specPower");
     setSpecularPower(32);
+    if (noiseColor || noiseDisplacement) {
+        noiseScaleLoc = glGetUniformLocation(this->getProgramID(), "noiseScale");
+        noiseOffsetLoc = glGetUniformLocation(this->getProgramID(), "noiseOffset");
+        noiseRepeatLoc = glGetUniformLocation(this->getProgramID(), "noiseRepeat");
+        noisePermsLoc = glGetUniformLocation(this->getProgramID(), "perlinPerms");
+        setNoiseScale(1.0f);
+        setNoiseOffset(glm::vec3(0.0f, 0.0f, 0.0f));
+        setNoiseRepeat(0.0f);
+        setNoiseTextureUnit(3);
+    }
+    if (noiseColor) {
+        noiseColorLoc = glGetUniformLocation(this->getProgramID(), "noiseColor");
+        setNoiseColor(glm::vec3(0.0f, 0.0f, 0.0f));
+    }
+    if (noiseDisplacement) {
+        noiseAmplitudeLoc = glGetUniformLocation(this->getProgramID(), "noiseAmplitude");
+        setNoiseAmplitude(0.1f);
+    }
 
     return this->getProgramID();
 }
@@ -256,4 +310,45 @@ void sceneObjects::SO_ModelShader::setLightSpecular(int index, glm::vec3 lightSp
 
 void sceneObjects::SO_ModelShader::setSpecularPower(unsigned int specPower) {
     glProgramUniform1ui(this->getProgramID(), specularPowerLoc, specPower);
-}
\ No newline at end of file
+}
+//set the scale from model space to noise space
+void sceneObjects::SO_ModelShader::setNoiseScale(float scale) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1f(this->getProgramID(), noiseScaleLoc, scale);
+    }
+}
+
+//set the offset in noise space - animating this moves the noise through the object
+void sceneObjects::SO_ModelShader::setNoiseOffset(glm::vec3 offset) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform3fv(this->getProgramID(), noiseOffsetLoc, 1, glm::value_ptr(offset));
+    }
+}
+
+//set the period of the noise, 0 for none
+void sceneObjects::SO_ModelShader::setNoiseRepeat(float repeat) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1f(this->getProgramID(), noiseRepeatLoc, repeat);
+    }
+}
+
+//set the colour mixed into the diffuse colour where the noise is low
+void sceneObjects::SO_ModelShader::setNoiseColor(glm::vec3 color) {
+    if ((options & SO_NOISE_COLOR) == SO_NOISE_COLOR) {
+        glProgramUniform3fv(this->getProgramID(), noiseColorLoc, 1, glm::value_ptr(color));
+    }
+}
+
+//set the largest displacement along the normals
+void sceneObjects::SO_ModelShader::setNoiseAmplitude(float amplitude) {
+    if ((options & SO_NOISE_DISPLACEMENT) == SO_NOISE_DISPLACEMENT) {
+        glProgramUniform1f(this->getProgramID(), noiseAmplitudeLoc, amplitude);
+    }
+}
+
+//set the texture unit the permutation table texture is bound to
+void sceneObjects::SO_ModelShader::setNoiseTextureUnit(unsigned int unit) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1i(this->getProgramID(), noisePermsLoc, unit);
+    }
+}
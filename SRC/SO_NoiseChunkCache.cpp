@@ -0,0 +1,161 @@
+/** \file SO_NoiseChunkCache.cpp */
+#include "sceneObjects.hpp"
+
+sceneObjects::SO_ChunkKey::SO_ChunkKey(int layerIn, int xIn, int yIn, int zIn, int lodIn) {
+    layer = layerIn;
+    x = xIn;
+    y = yIn;
+    z = zIn;
+    lod = lodIn;
+}
+
+bool sceneObjects::SO_ChunkKey::operator==(const SO_ChunkKey& other) const {
+    return layer == other.layer && x == other.x && y == other.y && z == other.z && lod == other.lod;
+}
+
+//combine the fields with large odd multipliers so neighbouring chunks land in different buckets
+size_t sceneObjects::SO_ChunkKeyHash::operator()(const SO_ChunkKey& key) const {
+    size_t hash = (unsigned int)key.layer;
+    hash = hash*0x9E3779B1u + (unsigned int)key.x;
+    hash = hash*0x85EBCA77u + (unsigned int)key.y;
+    hash = hash*0xC2B2AE3Du + (unsigned int)key.z;
+    hash = hash*0x27D4EB2Fu + (unsigned int)key.lod;
+    return hash ^ (hash >> 15);
+}
+
+sceneObjects::SO_NoiseChunkCache::SO_NoiseChunkCache(size_t byteBudgetIn, size_t maxPendingIn) {
+    state = std::make_shared<SO_ChunkCacheState>();
+    state->byteBudget = byteBudgetIn;
+    state->maxPending = maxPendingIn == 0 ? 1 : maxPendingIn;
+}
+
+int sceneObjects::SO_NoiseChunkCache::addLayer(size_t samplesPerChunk, SO_ChunkGenerator generator) {
+    if (!generator) {
+        throw std::invalid_argument("SO_NoiseChunkCache::addLayer() requires a generator function");
+    }
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->layers.push_back(std::make_pair(samplesPerChunk, std::move(generator)));
+    return state->layers.size() - 1;
+}
+
+void sceneObjects::SO_NoiseChunkCache::evict(SO_ChunkCacheState& cacheState) {
+    while (cacheState.bytesUsed > cacheState.byteBudget && cacheState.lru.size() > 1) { //the newest chunk is always kept so an oversized chunk can still be used
+        auto entry = cacheState.chunks.find(cacheState.lru.back());
+        cacheState.bytesUsed -= entry->second.samples->size()*sizeof(double);
+        cacheState.chunks.erase(entry);
+        cacheState.lru.pop_back();
+    }
+}
+
+sceneObjects::SO_NoiseChunkCache::SO_Chunk sceneObjects::SO_NoiseChunkCache::getChunk(const SO_ChunkKey& key) {
+    return lookup(key, true);
+}
+
+//find the chunk, queueing it if it's missing or failed - generator errors are only reported if rethrow is set
+sceneObjects::SO_NoiseChunkCache::SO_Chunk sceneObjects::SO_NoiseChunkCache::lookup(const SO_ChunkKey& key, bool rethrow) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    auto found = state->chunks.find(key);
+    if (found != state->chunks.end()) {
+        SO_ChunkEntry& entry = found->second;
+        if (entry.ready) {
+            state->lru.splice(state->lru.begin(), state->lru, entry.lruPosition);
+            return entry.samples;
+        }
+        if (!entry.error) {
+            return SO_Chunk(); //still being generated
+        }
+        //a failed chunk never stays in the cache - getChunk() reports the error, request() just queues the chunk again
+        std::exception_ptr error = entry.error;
+        state->chunks.erase(found);
+        if (rethrow) {
+            lock.unlock();
+            std::rethrow_exception(error);
+        }
+    }
+
+    if (key.layer < 0 || (size_t)key.layer >= state->layers.size()) {
+        std::string error = "SO_NoiseChunkCache has no layer " + std::to_string(key.layer);
+        throw std::invalid_argument(error.c_str());
+    }
+    if (state->pending >= state->maxPending) {
+        return SO_Chunk();
+    }
+    state->chunks[key];
+    state->pending++;
+    size_t samplesPerChunk = state->layers[key.layer].first;
+    SO_ChunkGenerator generator = state->layers[key.layer].second;
+    unsigned int generation = state->generation;
+    std::shared_ptr<SO_ChunkCacheState> taskState = state;
+    lock.unlock();
+
+    //generate outside the lock, then hand the samples over - unless clear() was called in the meantime
+    SO_ThreadPool::global().push([taskState, key, samplesPerChunk, generator, generation]() {
+        std::shared_ptr<std::vector<double>> samples;
+        std::exception_ptr error;
+        try {
+            samples = std::make_shared<std::vector<double>>(samplesPerChunk);
+            generator(key, samples->data());
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> taskLock(taskState->mutex);
+        taskState->pending--;
+        if (taskState->generation != generation) {
+            return;
+        }
+        auto entry = taskState->chunks.find(key);
+        if (entry == taskState->chunks.end()) {
+            return;
+        }
+        if (error) {
+            entry->second.error = error;
+            return;
+        }
+        entry->second.samples = samples;
+        entry->second.ready = true;
+        taskState->lru.push_front(key);
+        entry->second.lruPosition = taskState->lru.begin();
+        taskState->bytesUsed += samplesPerChunk*sizeof(double);
+        evict(*taskState);
+    });
+    return SO_Chunk();
+}
+
+void sceneObjects::SO_NoiseChunkCache::request(const SO_ChunkKey& key) {
+    lookup(key, false);
+}
+
+bool sceneObjects::SO_NoiseChunkCache::isReady(const SO_ChunkKey& key) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto found = state->chunks.find(key);
+    return found != state->chunks.end() && found->second.ready;
+}
+
+void sceneObjects::SO_NoiseChunkCache::clear(void) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->chunks.clear();
+    state->lru.clear();
+    state->bytesUsed = 0;
+    state->generation++;
+}
+
+void sceneObjects::SO_NoiseChunkCache::setByteBudget(size_t byteBudgetIn) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->byteBudget = byteBudgetIn;
+    evict(*state);
+}
+
+size_t sceneObjects::SO_NoiseChunkCache::getBytesUsed(void) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->bytesUsed;
+}
+
+size_t sceneObjects::SO_NoiseChunkCache::getChunkCount(void) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->lru.size();
+}
+
+size_t sceneObjects::SO_NoiseChunkCache::getPendingCount(void) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->pending;
+}
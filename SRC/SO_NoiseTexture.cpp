@@ -0,0 +1,246 @@
+/** \file SO_NoiseTexture.cpp */
+#include "sceneObjects.hpp"
+#include <cstring>
+#include <stdint.h>
+#include <stdexcept>
+
+namespace {
+//how long finish() waits for the GPU to release a pixel buffer - it is called at startup, so blocking here is the point
+const GLuint64 finishFenceTimeout = 1000000000ull;
+}
+
+sceneObjects::SO_NoiseTexture::SO_NoiseTexture(void) : readyFlag(false) {
+    readyFuture = readyPromise.get_future().share();
+}
+
+sceneObjects::SO_NoiseTexture::~SO_NoiseTexture(void) {
+    release();
+}
+
+//stop any generation in progress (queued tasks see the flag, running ones finish into the shared state and are discarded) and delete the GL objects
+void sceneObjects::SO_NoiseTexture::release(void) {
+    if (state) {
+        state->cancelled = true;
+        state.reset();
+    }
+    for (int i = 0; i < 4; i++) {
+        if (bufferFences[i]) {
+            glDeleteSync(bufferFences[i]);
+            bufferFences[i] = 0;
+        }
+    }
+    if (pixelBuffers[0]) {
+        glDeleteBuffers(4, pixelBuffers);
+        for (int i = 0; i < 4; i++) {
+            pixelBuffers[i] = 0;
+        }
+    }
+    if (textureID) {
+        glDeleteTextures(1, &textureID);
+        textureID = 0;
+    }
+}
+
+void sceneObjects::SO_NoiseTexture::generate(int widthIn, int heightIn, int depthIn, std::function<void(int, double*)> sliceFunction) {
+    if (widthIn <= 0 || heightIn <= 0 || depthIn <= 0) {
+        std::string error = "SO_NoiseTexture dimensions must be positive, got " + std::to_string(widthIn) + "x" + std::to_string(heightIn) + "x" + std::to_string(depthIn);
+        throw std::invalid_argument(error.c_str());
+    }
+    if (state && !ready && !failed) { //anyone waiting on the replaced generation's future is told it will never finish
+        readyPromise.set_exception(std::make_exception_ptr(std::runtime_error("SO_NoiseTexture generation was replaced by a later call to generate()")));
+    }
+    release();
+    width = widthIn;
+    height = heightIn;
+    depth = depthIn;
+    ready = false;
+    failed = false;
+    readyFlag = false;
+    readyPromise = std::promise<void>();
+    readyFuture = readyPromise.get_future().share();
+    sliceUploaded.assign(depth, false);
+    slicesUploaded = 0;
+    nextBuffer = 0;
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_3D, textureID);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, width, height, depth, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    size_t sliceSize = (size_t)width*height;
+    glGenBuffers(4, pixelBuffers);
+    for (int i = 0; i < 4; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, sliceSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    state = std::make_shared<SO_NoiseTextureState>();
+    state->voxels.resize(sliceSize*depth);
+    state->sliceReady.reset(new std::atomic<bool>[depth]);
+    for (int k = 0; k < depth; k++) {
+        state->sliceReady[k] = false;
+    }
+    state->cancelled = false;
+    state->slicesFinished = 0;
+
+    //one task per slice - the tasks hold the state (not this object) so they never outlive what they write into
+    std::shared_ptr<std::function<void(int, double*)>> function = std::make_shared<std::function<void(int, double*)>>(std::move(sliceFunction));
+    std::shared_ptr<SO_NoiseTextureState> taskState = state;
+    for (int k = 0; k < depth; k++) {
+        SO_ThreadPool::global().push([taskState, function, sliceSize, k]() {
+            std::exception_ptr error;
+            if (!taskState->cancelled) {
+                try {
+                    std::vector<double> values(sliceSize);
+                    (*function)(k, values.data());
+                    unsigned char* slice = taskState->voxels.data() + sliceSize*k;
+                    for (size_t i = 0; i < sliceSize; i++) {
+                        double value = values[i] < 0 ? 0 : (values[i] > 1 ? 1 : values[i]);
+                        slice[i] = (unsigned char)(value*255 + 0.5);
+                    }
+                    taskState->sliceReady[k] = true;
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            std::lock_guard<std::mutex> lock(taskState->mutex);
+            if (error && !taskState->error) {
+                taskState->error = error;
+            }
+            taskState->slicesFinished++;
+            taskState->finishedCondition.notify_all();
+        });
+    }
+}
+
+void sceneObjects::SO_NoiseTexture::generate(int widthIn, int heightIn, int depthIn, const SO_PerlinNoise& noise, double scale, double repeat) {
+    int rowWidth = widthIn;
+    int rows = heightIn;
+    generate(widthIn, heightIn, depthIn, [noise, scale, repeat, rowWidth, rows](int k, double* out) {
+        noise.noiseGrid2D(out, rowWidth, rows, 0, 0, scale, scale, k*scale, repeat);
+    });
+}
+
+void sceneObjects::SO_NoiseTexture::generate(int widthIn, int heightIn, int depthIn, const SO_FractalNoise& fractal, double scale) {
+    int rowWidth = widthIn;
+    int rows = heightIn;
+    generate(widthIn, heightIn, depthIn, [fractal, scale, rowWidth, rows](int k, double* out) {
+        size_t count = (size_t)rowWidth*rows;
+        std::vector<double> x(count), y(count), z(count, k*scale);
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < rowWidth; i++) {
+                x[i + j*rowWidth] = i*scale;
+                y[i + j*rowWidth] = j*scale;
+            }
+        }
+        fractal.noiseBatch(x.data(), y.data(), z.data(), out, count);
+    });
+}
+
+bool sceneObjects::SO_NoiseTexture::update(size_t byteBudget) {
+    return uploadSlices(byteBudget, 0);
+}
+
+//copy ready slices through the pixel buffer ring until the budget runs out or the next buffer is still being read by the GPU after `fenceTimeout` nanoseconds
+bool sceneObjects::SO_NoiseTexture::uploadSlices(size_t byteBudget, GLuint64 fenceTimeout) {
+    if (ready || failed || !state) {
+        return ready;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->error) {
+            failed = true;
+            state->cancelled = true;
+            readyPromise.set_exception(state->error);
+            return false;
+        }
+    }
+
+    size_t sliceSize = (size_t)width*height;
+    size_t bytesCopied = 0;
+    GLint unpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_3D, textureID);
+    for (int k = 0; k < depth; k++) {
+        if (sliceUploaded[k] || !state->sliceReady[k]) {
+            continue;
+        }
+        if (bytesCopied > 0 && bytesCopied + sliceSize > byteBudget) {
+            break;
+        }
+        GLsync& fence = bufferFences[nextBuffer];
+        if (fence) {
+            GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout);
+            if (waitResult == GL_TIMEOUT_EXPIRED || waitResult == GL_WAIT_FAILED) { //the GPU is behind - try again next frame rather than stalling
+                break;
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextBuffer]);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, sliceSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            break;
+        }
+        std::memcpy(mapped, state->voxels.data() + sliceSize*k, sliceSize);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, k, width, height, 1, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextBuffer = (nextBuffer + 1) % 4;
+        sliceUploaded[k] = true;
+        slicesUploaded++;
+        bytesCopied += sliceSize;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+    if (slicesUploaded == depth) {
+        ready = true;
+        readyFlag = true;
+        state.reset(); //every task has finished, so this frees the generated voxels
+        readyPromise.set_value();
+    }
+    return ready;
+}
+
+void sceneObjects::SO_NoiseTexture::finish(void) {
+    if (!state && !ready && !failed) {
+        throw std::runtime_error("SO_NoiseTexture::finish() called before generate()");
+    }
+    if (state && !ready && !failed) { //sleep until every generation task has finished, then upload the lot
+        std::shared_ptr<SO_NoiseTextureState> waitState = state;
+        std::unique_lock<std::mutex> lock(waitState->mutex);
+        waitState->finishedCondition.wait(lock, [this, &waitState]() { return waitState->slicesFinished == depth; });
+    }
+    bool uploaded = uploadSlices(SIZE_MAX, finishFenceTimeout);
+    while (!uploaded && !failed) { //the GPU was still reading from a pixel buffer when the wait timed out
+        uploaded = uploadSlices(SIZE_MAX, finishFenceTimeout);
+    }
+    readyFuture.get();
+}
+
+bool sceneObjects::SO_NoiseTexture::isReady(void) const {
+    return readyFlag;
+}
+
+std::shared_future<void> sceneObjects::SO_NoiseTexture::getFuture(void) const {
+    return readyFuture;
+}
+
+GLuint sceneObjects::SO_NoiseTexture::getTextureID(void) const {
+    return textureID;
+}
+
+void sceneObjects::SO_NoiseTexture::bind(unsigned int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_3D, textureID);
+}
@@ -0,0 +1,78 @@
+/** \file SO_PerlinNoise.cpp */
+#include "sceneObjects.hpp"
+#include "noiseKernels.hpp"
+#include <random>
+
+sceneObjects::SO_PerlinNoise::SO_PerlinNoise(unsigned int seedIn) {
+    seed = seedIn;
+    for (int i = 0; i < 256; i++) {
+        table[i] = (unsigned char)i;
+    }
+    //fisher-yates shuffle - the swaps are drawn directly from the generator so a seed gives the same table on every platform
+    std::mt19937 generator(seed);
+    for (int i = 255; i > 0; i--) {
+        int j = generator() % (i + 1);
+        unsigned char swap = table[i];
+        table[i] = table[j];
+        table[j] = swap;
+    }
+    for (int i = 0; i < 256; i++) {
+        table[i + 256] = table[i];
+    }
+    table[512] = table[513] = table[514] = 0;
+}
+
+unsigned int sceneObjects::SO_PerlinNoise::getSeed(void) const {
+    return seed;
+}
+
+const unsigned char* sceneObjects::SO_PerlinNoise::getPermutations(void) const {
+    return table;
+}
+
+double sceneObjects::SO_PerlinNoise::noise(double x, double y, double z, double repeat) const {
+    return noiseKernels::perlinTable<double, unsigned char>(table, x, y, z, repeat);
+}
+
+float sceneObjects::SO_PerlinNoise::noise(float x, float y, float z, float repeat) const {
+    return noiseKernels::perlinTable<float, unsigned char>(table, x, y, z, repeat);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat) const {
+    noiseKernels::perlinBatchTable<double, unsigned char>(table, x, y, z, out, count, repeat);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat) const {
+    noiseKernels::perlinBatchTable<float, unsigned char>(table, x, y, z, out, count, repeat);
+}
+
+double sceneObjects::SO_PerlinNoise::noiseDerivative(double x, double y, double z, glm::dvec3& gradient, double repeat) const {
+    double components[3];
+    double value = noiseKernels::perlinDerivativeTable<double, unsigned char>(table, x, y, z, repeat, components);
+    gradient = glm::dvec3(components[0], components[1], components[2]);
+    return value;
+}
+
+void sceneObjects::SO_PerlinNoise::noiseDerivativeBatch(const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat) const {
+    noiseKernels::perlinDerivativeBatchTable<double, unsigned char>(table, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseDerivativeBatch(const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat) const {
+    noiseKernels::perlinDerivativeBatchTable<float, unsigned char>(table, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseGrid2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat) const {
+    noiseKernels::perlinGridTable(table, out, width, height, 1, x0, y0, z, dx, dy, 0, repeat, 0);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseGrid3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat) const {
+    noiseKernels::perlinGridTable(table, out, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, 0);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseGridParallel2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat, size_t grainSize) const {
+    noiseKernels::perlinGridTable(table, out, width, height, 1, x0, y0, z, dx, dy, 0, repeat, grainSize == 0 ? 1 : grainSize);
+}
+
+void sceneObjects::SO_PerlinNoise::noiseGridParallel3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat, size_t grainSize) const {
+    noiseKernels::perlinGridTable(table, out, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, grainSize == 0 ? 1 : grainSize);
+}
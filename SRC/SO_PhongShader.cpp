@@ -3,11 +3,12 @@
 
 //numberLights gives number of point lights in the scene
 //optionsIn : binary flags given by enums SO_ShaderOptions
-// expects in: position, normal, (ambient/diffuse/specular/alpha)Attrib, color, instanceMatrix, normalInstMatrix
+// expects in: position, normal, (ambient/diffuse/specular/alpha)Attrib, color or scalar, instanceMatrix, normalInstMatrix
 //uniforms: set with SO_PhongShader::set_____ methods
 GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int optionsIn) {
     numberLights = numberLightsIn; //no. of point sources
     options = optionsIn;
+    bool scalarColor = (options & SO_MATERIAL) != SO_MATERIAL and (options & SO_SCALAR_ATTRIBUTE) == SO_SCALAR_ATTRIBUTE;
     // create shaders and link them - delete after
     std::string vertexSourceStr;
     vertexSourceStr = R"glsl(
@@ -28,6 +29,8 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) == SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             vertexSourceStr += "\nin float alphaAttrib;";
         }
+    } else if (scalarColor) {
+        vertexSourceStr += "\nin float scalar;";
     } else if ((options & SO_COLOR_ATTRIBUTE) == SO_COLOR_ATTRIBUTE) {
         vertexSourceStr += "\nin vec" + (std::string)(((options & SO_ALPHA) == SO_ALPHA) ? "4" : "3") + " color;";
     }
@@ -50,6 +53,8 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) == SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             vertexSourceStr += "\nout float AlphaMat;";
         }
+    } else if (scalarColor) {
+        vertexSourceStr += "\nout float Scalar;";
     } else if ((options & SO_COLOR_ATTRIBUTE) == SO_COLOR_ATTRIBUTE) {
         vertexSourceStr += "\nout vec" + (std::string)(((options & SO_ALPHA) == SO_ALPHA) ? "4" : "3") + " Color;";
     }
@@ -59,6 +64,21 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
 
         uniform mat4 normalMatrix;
         uniform mat4 model;)glsl";
+    bool noiseColor = (options & SO_NOISE_COLOR) == SO_NOISE_COLOR;
+    bool noiseDisplacement = (options & SO_NOISE_DISPLACEMENT) == SO_NOISE_DISPLACEMENT;
+    if (noiseColor) {
+        vertexSourceStr += "\nout vec3 noisePos;";
+    }
+    if (noiseColor || noiseDisplacement) {
+        vertexSourceStr += R"glsl(
+        uniform float noiseScale;
+        uniform vec3 noiseOffset;)glsl";
+    }
+    if (noiseDisplacement) {
+        vertexSourceStr += R"glsl(
+        uniform float noiseRepeat;
+        uniform float noiseAmplitude;)glsl" + perlinShaderSource();
+    }
     if ((options & SO_INSTANCED) == SO_INSTANCED) {
         vertexSourceStr += R"glsl(
         uniform mat4 postNormalMatrix;
@@ -83,13 +103,22 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) == SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             vertexSourceStr += "\n\tAlphaMat = alphaAttrib;";
         }
+    } else if (scalarColor) {
+        vertexSourceStr += "\n\tScalar = scalar;";
     } else if ((options & SO_COLOR_ATTRIBUTE) == SO_COLOR_ATTRIBUTE) {
         vertexSourceStr += "\n\tColor = color;";
     }
+    if (noiseColor) {
+        vertexSourceStr += "\n\tnoisePos = position*noiseScale + noiseOffset;";
+    }
+    if (noiseDisplacement) {
+        vertexSourceStr += "\n\tvec3 displaced = position + normal*(noiseAmplitude*(2.0*perlin(position*noiseScale + noiseOffset, noiseRepeat) - 1.0));";
+    }
+    std::string vertexPosition = noiseDisplacement ? "displaced" : "position";
     vertexSourceStr += R"glsl(
-            gl_Position = proj * view * )glsl" + (std::string)(((options & SO_INSTANCED) == SO_INSTANCED) ? "postModel * instanceMatrix *" : "") + R"glsl( model * vec4(position, 1.0);
+            gl_Position = proj * view * )glsl" + (std::string)(((options & SO_INSTANCED) == SO_INSTANCED) ? "postModel * instanceMatrix *" : "") + R"glsl( model * vec4()glsl" + vertexPosition + R"glsl(, 1.0);
             norm = normalize(vec3()glsl" + (std::string)(((options & SO_INSTANCED) == SO_INSTANCED) ? "postNormalMatrix * normalInstMatrix *" : "") + R"glsl( normalMatrix * vec4(normal, 0.0)));
-            worldPos = vec3()glsl" + (std::string)(((options & SO_INSTANCED) == SO_INSTANCED) ? "postModel * instanceMatrix *" : "") + R"glsl(model * vec4(position, 1.0));
+            worldPos = vec3()glsl" + (std::string)(((options & SO_INSTANCED) == SO_INSTANCED) ? "postModel * instanceMatrix *" : "") + R"glsl(model * vec4()glsl" + vertexPosition + R"glsl(, 1.0));
         }
     )glsl";
     const char* vertexSource = vertexSourceStr.c_str();
@@ -123,6 +152,15 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) == SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             fragmentSourceStr += "\nin float AlphaMat;";
         }
+    } else if (scalarColor) {
+        // the scalar is interpolated rather than the colour, so each fragment looks up its own colour
+        fragmentSourceStr += R"glsl(
+        in float Scalar;
+        uniform sampler1D colorMap;
+        uniform float scalarMin;
+        uniform float scalarMax;
+        uniform vec2 colorMapKeys; // the lowest key position and 1/(highest - lowest), or 0 for a single key
+        vec4 Color; // set once in main() for every light)glsl";
     } else if ((options & SO_COLOR_ATTRIBUTE) == SO_COLOR_ATTRIBUTE) {
         fragmentSourceStr += "\nin vec" + (std::string)(((options & SO_ALPHA) == SO_ALPHA) ? "4" : "3") + " Color;";
     }
@@ -145,12 +183,23 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) != SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             fragmentSourceStr += "\nuniform float AlphaMat;";
         }
-    } else if ((options & SO_COLOR_ATTRIBUTE) != SO_COLOR_ATTRIBUTE) {
+    } else if ((options & (SO_COLOR_ATTRIBUTE | SO_SCALAR_ATTRIBUTE)) == 0) {
         fragmentSourceStr += "\nuniform vec" + (std::string)(((options & SO_ALPHA) == SO_ALPHA) ? "4" : "3") + " Color;";
     }
+    std::string ambientColor = ((options & SO_MATERIAL) == SO_MATERIAL) ? "AmbientMat" : "Color.xyz";
+    std::string diffuseColor = ((options & SO_MATERIAL) == SO_MATERIAL) ? "DiffuseMat" : "Color.xyz";
+    if (noiseColor) {
+        fragmentSourceStr += R"glsl(
+        in vec3 noisePos;
+        uniform float noiseRepeat;
+        uniform vec3 noiseColor;
+        float noiseValue; // set once in main() for every light)glsl" + perlinShaderSource();
+        ambientColor = "mix(noiseColor, " + ambientColor + ", noiseValue)";
+        diffuseColor = "mix(noiseColor, " + diffuseColor + ", noiseValue)";
+    }
     fragmentSourceStr += R"glsl(
         uniform vec3 viewPos;
-        uniform unsigned int specPower;
+        uniform uint specPower;
         uniform PointLight lights[)glsl" + std::to_string(numberLights) + R"glsl(];
 
         vec3 CalcPointLight(PointLight light, vec3 normal, vec3 viewDir) {
@@ -165,8 +214,8 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
             float attenuation = 1.0 / (light.constant + light.linear * distance + 
                         light.quadratic * (distance * distance));   
             // combine results
-            vec3 ambient  = light.ambient  * )glsl" + (std::string)(((options & SO_MATERIAL) == SO_MATERIAL) ? "AmbientMat" : "Color.xyz") + R"glsl(;
-            vec3 diffuse  = light.diffuse  * diff * )glsl" + (std::string)(((options & SO_MATERIAL) == SO_MATERIAL) ? "DiffuseMat" : "Color.xyz") + R"glsl(;
+            vec3 ambient  = light.ambient  * )glsl" + ambientColor + R"glsl(;
+            vec3 diffuse  = light.diffuse  * diff * )glsl" + diffuseColor + R"glsl(;
             vec3 specular = light.specular * spec * )glsl" + (std::string)(((options & SO_MATERIAL) == SO_MATERIAL) ? "SpecularMat" : "Color.xyz") + R"glsl(;
             ambient  *= attenuation;
             diffuse  *= attenuation;
@@ -175,7 +224,18 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         }
 
         void main()
-        {
+        {)glsl";
+    if (noiseColor) {
+        fragmentSourceStr += "\n\tnoiseValue = perlin(noisePos, noiseRepeat);";
+    }
+    if (scalarColor) {
+        // normalise as SO_ColorMap::getLerpColor() does, then place the key range across the texel centres
+        fragmentSourceStr += R"glsl(
+            float keyPosition = clamp(((Scalar - scalarMin)/(scalarMax - scalarMin) - colorMapKeys.x)*colorMapKeys.y, 0.0, 1.0);
+            float texels = float(textureSize(colorMap, 0));
+            Color = texture(colorMap, (keyPosition*(texels - 1.0) + 0.5)/texels);)glsl";
+    }
+    fragmentSourceStr += R"glsl(
             vec3 viewDir = normalize(viewPos - worldPos); 
             vec3 result = vec3(0.0, 0.0, 0.0);
             for (int i = 0; i < )glsl" + std::to_string(numberLights) + R"glsl(; i++) {
@@ -219,9 +279,35 @@ GLuint sceneObjects::SO_PhongShader::generate(int numberLightsIn, unsigned int o
         if ((options & SO_ALPHA_ATTRIBUTE) != SO_ALPHA_ATTRIBUTE and (options & SO_ALPHA) == SO_ALPHA) {
             alphaMatLoc = glGetUniformLocation(this->getProgramID(), "AlphaMat");
         }
+    } else if (scalarColor) {
+        scalarMinLoc = glGetUniformLocation(this->getProgramID(), "scalarMin");
+        scalarMaxLoc = glGetUniformLocation(this->getProgramID(), "scalarMax");
+        colorMapKeysLoc = glGetUniformLocation(this->getProgramID(), "colorMapKeys");
+        colorMapLoc = glGetUniformLocation(this->getProgramID(), "colorMap");
+        setScalarRange(0.0f, 1.0f);
+        glProgramUniform2f(this->getProgramID(), colorMapKeysLoc, 0.0f, 1.0f);
+        setColorMapTextureUnit(4);
     } else if ((options & SO_COLOR_ATTRIBUTE) != SO_COLOR_ATTRIBUTE) {
         colorLoc = glGetUniformLocation(this->getProgramID(), "Color");
     }
+    if (noiseColor || noiseDisplacement) {
+        noiseScaleLoc = glGetUniformLocation(this->getProgramID(), "noiseScale");
+        noiseOffsetLoc = glGetUniformLocation(this->getProgramID(), "noiseOffset");
+        noiseRepeatLoc = glGetUniformLocation(this->getProgramID(), "noiseRepeat");
+        noisePermsLoc = glGetUniformLocation(this->getProgramID(), "perlinPerms");
+        setNoiseScale(1.0f);
+        setNoiseOffset(glm::vec3(0.0f, 0.0f, 0.0f));
+        setNoiseRepeat(0.0f);
+        setNoiseTextureUnit(3);
+    }
+    if (noiseColor) {
+        noiseColorLoc = glGetUniformLocation(this->getProgramID(), "noiseColor");
+        setNoiseColor(glm::vec3(0.0f, 0.0f, 0.0f));
+    }
+    if (noiseDisplacement) {
+        noiseAmplitudeLoc = glGetUniformLocation(this->getProgramID(), "noiseAmplitude");
+        setNoiseAmplitude(0.1f);
+    }
 
     return this->getProgramID();
 }
@@ -392,4 +478,70 @@ void sceneObjects::SO_PhongShader::setColor(glm::vec4 color) {
 
 void sceneObjects::SO_PhongShader::setSpecularPower(unsigned int specPower) {
     glProgramUniform1ui(this->getProgramID(), specularPowerLoc, specPower);
-}
\ No newline at end of file
+}
+//set the scale from model space to noise space
+void sceneObjects::SO_PhongShader::setNoiseScale(float scale) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1f(this->getProgramID(), noiseScaleLoc, scale);
+    }
+}
+
+//set the offset in noise space - animating this moves the noise through the object
+void sceneObjects::SO_PhongShader::setNoiseOffset(glm::vec3 offset) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform3fv(this->getProgramID(), noiseOffsetLoc, 1, glm::value_ptr(offset));
+    }
+}
+
+//set the period of the noise, 0 for none
+void sceneObjects::SO_PhongShader::setNoiseRepeat(float repeat) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1f(this->getProgramID(), noiseRepeatLoc, repeat);
+    }
+}
+
+//set the colour mixed in where the noise is low
+void sceneObjects::SO_PhongShader::setNoiseColor(glm::vec3 color) {
+    if ((options & SO_NOISE_COLOR) == SO_NOISE_COLOR) {
+        glProgramUniform3fv(this->getProgramID(), noiseColorLoc, 1, glm::value_ptr(color));
+    }
+}
+
+//set the largest displacement along the normals
+void sceneObjects::SO_PhongShader::setNoiseAmplitude(float amplitude) {
+    if ((options & SO_NOISE_DISPLACEMENT) == SO_NOISE_DISPLACEMENT) {
+        glProgramUniform1f(this->getProgramID(), noiseAmplitudeLoc, amplitude);
+    }
+}
+
+//set the texture unit the permutation table texture is bound to
+void sceneObjects::SO_PhongShader::setNoiseTextureUnit(unsigned int unit) {
+    if ((options & (SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT)) != 0) {
+        glProgramUniform1i(this->getProgramID(), noisePermsLoc, unit);
+    }
+}
+
+//set the scalar values mapped to normalised positions 0 and 1 of the colormap
+void sceneObjects::SO_PhongShader::setScalarRange(float min, float max) {
+    if ((options & SO_MATERIAL) != SO_MATERIAL and (options & SO_SCALAR_ATTRIBUTE) == SO_SCALAR_ATTRIBUTE) {
+        glProgramUniform1f(this->getProgramID(), scalarMinLoc, min);
+        glProgramUniform1f(this->getProgramID(), scalarMaxLoc, max);
+    }
+}
+
+//set the lowest key position and the inverse of the key span, which place normalised values along the colormap texture
+void sceneObjects::SO_PhongShader::setColorMap(const SO_ColorMap& colorMap) {
+    if ((options & SO_MATERIAL) != SO_MATERIAL and (options & SO_SCALAR_ATTRIBUTE) == SO_SCALAR_ATTRIBUTE) {
+        const std::vector<float>& positions = colorMap.getPositions();
+        float first = positions.empty() ? 0.0f : positions.front();
+        float last = positions.empty() ? 0.0f : positions.back();
+        glProgramUniform2f(this->getProgramID(), colorMapKeysLoc, first, last > first ? 1.0f/(last - first) : 0.0f);
+    }
+}
+
+//set the texture unit the colormap texture is bound to
+void sceneObjects::SO_PhongShader::setColorMapTextureUnit(unsigned int unit) {
+    if ((options & SO_MATERIAL) != SO_MATERIAL and (options & SO_SCALAR_ATTRIBUTE) == SO_SCALAR_ATTRIBUTE) {
+        glProgramUniform1i(this->getProgramID(), colorMapLoc, unit);
+    }
+}
@@ -0,0 +1,324 @@
+/** \file SO_Terrain.cpp */
+#include "sceneObjects.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+//the fraction of a level (in log2 distance) the camera must move past a boundary before a chunk changes level
+const float terrainLodHysteresis = 0.1f;
+
+//the key of an element buffer in SO_Terrain::elementBuffers - the cell count and the 4 level differences
+unsigned long long elementKey(int cells, const int lodSteps[4]) {
+    unsigned long long key = (unsigned long long)cells;
+    for (int side = 0; side < 4; side++) {
+        key = key << 8 | (unsigned long long)lodSteps[side];
+    }
+    return key;
+}
+
+//the distance from `position` to the box of a chunk - y is ignored until the chunk has a mesh to give its heights
+float chunkDistance(const glm::vec3& position, float xMin, float xMax, float zMin, float zMax, bool hasHeights, float yMin, float yMax) {
+    float dx = std::max(std::max(xMin - position.x, 0.0f), position.x - xMax);
+    float dz = std::max(std::max(zMin - position.z, 0.0f), position.z - zMax);
+    float dy = hasHeights ? std::max(std::max(yMin - position.y, 0.0f), position.y - yMax) : 0.0f;
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+}
+
+sceneObjects::SO_Terrain::SO_Terrain(std::function<float(float, float)> heightFunctionIn, int chunksXIn, int chunksZIn, int chunkCellsIn, float spacingIn,
+                                     float x0In, float z0In, float lodDistanceIn, GLint positionAttribIn, GLint normalAttribIn) {
+    if (chunksXIn <= 0 || chunksZIn <= 0) {
+        throw std::invalid_argument("SO_Terrain requires at least one chunk along each axis");
+    }
+    if (chunkCellsIn < 2 || (chunkCellsIn & (chunkCellsIn - 1)) != 0) {
+        throw std::invalid_argument("SO_Terrain chunkCells must be a power of 2 of at least 2, got " + std::to_string(chunkCellsIn));
+    }
+    if (!heightFunctionIn) {
+        throw std::invalid_argument("SO_Terrain requires a height function");
+    }
+    state = std::make_shared<SO_TerrainState>();
+    state->heightFunction = std::move(heightFunctionIn);
+    state->cancelled = false;
+    chunksX = chunksXIn;
+    chunksZ = chunksZIn;
+    chunkCells = chunkCellsIn;
+    maxLod = 0;
+    while ((chunkCells >> (maxLod + 1)) >= 2) {
+        maxLod++;
+    }
+    spacing = spacingIn;
+    x0 = x0In;
+    z0 = z0In;
+    lodDistance = lodDistanceIn;
+    positionAttrib = positionAttribIn;
+    normalAttrib = normalAttribIn;
+    maxPending = 2*(size_t)SO_ThreadPool::global().getThreadCount() + 2;
+    chunks.resize((size_t)chunksX*chunksZ);
+}
+
+sceneObjects::SO_Terrain::~SO_Terrain(void) {
+    state->cancelled = true;
+    for (SO_TerrainChunk& chunk : chunks) {
+        glDeleteVertexArrays(1, &chunk.vao);
+        glDeleteBuffers(1, &chunk.vbo);
+    }
+    for (auto& buffer : elementBuffers) {
+        glDeleteBuffers(1, &buffer.second.ebo);
+    }
+}
+
+//sample the chunk's heights with a one sample border on a worker, pack the vertices and leave them for update() to upload
+void sceneObjects::SO_Terrain::queueChunk(int chunk, int lod) {
+    chunks[chunk].pendingLod = lod;
+    pending++;
+    std::shared_ptr<SO_TerrainState> taskState = state;
+    int step = 1 << lod;
+    int cells = chunkCells >> lod;
+    int firstX = (chunk % chunksX)*chunkCells;
+    int firstZ = (chunk/chunksX)*chunkCells;
+    float spacingIn = spacing;
+    float x0In = x0;
+    float z0In = z0;
+    SO_ThreadPool::global().push([taskState, chunk, lod, step, cells, firstX, firstZ, spacingIn, x0In, z0In]() {
+        SO_TerrainMesh mesh;
+        mesh.chunk = chunk;
+        mesh.lod = lod;
+        if (!taskState->cancelled) {
+            try {
+                //every sample's position comes from its index on the full detail grid, so neighbouring chunks sample shared points identically
+                int size = cells + 1;
+                std::vector<float> heights((size_t)(size + 2)*(size + 2));
+                for (int j = -1; j <= size; j++) {
+                    float z = z0In + (firstZ + j*step)*spacingIn;
+                    for (int i = -1; i <= size; i++) {
+                        heights[(i + 1) + (j + 1)*(size + 2)] = taskState->heightFunction(x0In + (firstX + i*step)*spacingIn, z);
+                    }
+                }
+                mesh.vertices.resize((size_t)size*size*6);
+                SO_Heightfield::packVertices(heights.data(), size, size, x0In + firstX*spacingIn, z0In + firstZ*spacingIn,
+                                             step*spacingIn, step*spacingIn, mesh.vertices.data());
+                mesh.minHeight = mesh.vertices[1];
+                mesh.maxHeight = mesh.vertices[1];
+                for (size_t v = 1; v < mesh.vertices.size(); v += 6) {
+                    mesh.minHeight = std::min(mesh.minHeight, mesh.vertices[v]);
+                    mesh.maxHeight = std::max(mesh.maxHeight, mesh.vertices[v]);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(taskState->mutex);
+                if (!taskState->error) {
+                    taskState->error = std::current_exception();
+                }
+                mesh.vertices.clear();
+            }
+        }
+        std::lock_guard<std::mutex> lock(taskState->mutex);
+        taskState->finished.push_back(std::move(mesh));
+    });
+}
+
+void sceneObjects::SO_Terrain::update(const SO_Camera& camera, size_t byteBudget) {
+    //collect finished meshes, uploading them while the budget lasts - the rest wait for the next frame
+    std::vector<SO_TerrainMesh> finished;
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        size_t bytes = 0;
+        size_t taken = 0;
+        while (taken < state->finished.size() && (taken == 0 || bytes + state->finished[taken].vertices.size()*sizeof(float) <= byteBudget)) {
+            bytes += state->finished[taken].vertices.size()*sizeof(float);
+            taken++;
+        }
+        std::move(state->finished.begin(), state->finished.begin() + taken, std::back_inserter(finished));
+        state->finished.erase(state->finished.begin(), state->finished.begin() + taken);
+        std::swap(error, state->error);
+    }
+    for (SO_TerrainMesh& mesh : finished) {
+        SO_TerrainChunk& chunk = chunks[mesh.chunk];
+        chunk.pendingLod = -1;
+        pending--;
+        if (mesh.vertices.empty()) { //the height function threw - the chunk is queued again below
+            continue;
+        }
+        if (!chunk.vao) {
+            glGenVertexArrays(1, &chunk.vao);
+            glGenBuffers(1, &chunk.vbo);
+            glBindVertexArray(chunk.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            glEnableVertexAttribArray(positionAttrib);
+            glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)0);
+            glEnableVertexAttribArray(normalAttrib);
+            glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size()*sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+        chunk.lod = mesh.lod;
+        chunk.minHeight = mesh.minHeight;
+        chunk.maxHeight = mesh.maxHeight;
+    }
+
+    //choose each chunk's level, keeping the current one until the camera is clearly past the boundary
+    std::vector<std::pair<float, int>> wanted;
+    float chunkSize = chunkCells*spacing;
+    for (int chunkZ = 0; chunkZ < chunksZ; chunkZ++) {
+        for (int chunkX = 0; chunkX < chunksX; chunkX++) {
+            int index = chunkX + chunkZ*chunksX;
+            SO_TerrainChunk& chunk = chunks[index];
+            float xMin = x0 + chunkX*chunkSize;
+            float zMin = z0 + chunkZ*chunkSize;
+            float distance = chunkDistance(camera.position, xMin, xMin + chunkSize, zMin, zMin + chunkSize, chunk.lod >= 0, chunk.minHeight, chunk.maxHeight);
+            float level = distance > 0 ? std::log2(distance/lodDistance) + 1.0f : -1.0f;
+            int current = chunk.targetLod;
+            if (current < 0 || level < current - terrainLodHysteresis || (level > current + 1 + terrainLodHysteresis && current < maxLod)) {
+                chunk.targetLod = std::min(std::max((int)std::floor(level), 0), maxLod);
+            }
+            if (chunk.lod != chunk.targetLod && chunk.pendingLod < 0) {
+                //chunks with nothing to draw go first, then the nearest
+                wanted.push_back(std::make_pair(chunk.lod < 0 ? -1.0f : distance, index));
+            }
+        }
+    }
+    size_t slots = pending < maxPending ? maxPending - pending : 0;
+    if (wanted.size() > slots) {
+        std::partial_sort(wanted.begin(), wanted.begin() + slots, wanted.end());
+        wanted.resize(slots);
+    }
+    for (const std::pair<float, int>& request : wanted) {
+        queueChunk(request.second, chunks[request.second].targetLod);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void sceneObjects::SO_Terrain::finish(const SO_Camera& camera) {
+    while (true) {
+        update(camera, (size_t)-1);
+        bool done = pending == 0;
+        for (const SO_TerrainChunk& chunk : chunks) {
+            done = done && chunk.lod == chunk.targetLod;
+        }
+        if (done) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+//each side is stitched to the level of the neighbour if it is coarser - finer neighbours stitch themselves to this chunk
+void sceneObjects::SO_Terrain::render(void) {
+    for (int chunkZ = 0; chunkZ < chunksZ; chunkZ++) {
+        for (int chunkX = 0; chunkX < chunksX; chunkX++) {
+            const SO_TerrainChunk& chunk = chunks[chunkX + chunkZ*chunksX];
+            if (chunk.lod < 0) {
+                continue;
+            }
+            int neighbourLods[4] = {
+                chunkZ > 0 ? chunks[chunkX + (chunkZ - 1)*chunksX].lod : -1,
+                chunkX + 1 < chunksX ? chunks[chunkX + 1 + chunkZ*chunksX].lod : -1,
+                chunkZ + 1 < chunksZ ? chunks[chunkX + (chunkZ + 1)*chunksX].lod : -1,
+                chunkX > 0 ? chunks[chunkX - 1 + chunkZ*chunksX].lod : -1
+            };
+            int lodSteps[4];
+            for (int side = 0; side < 4; side++) {
+                lodSteps[side] = std::max(neighbourLods[side] - chunk.lod, 0);
+            }
+            const SO_TerrainElements& elements = elementBuffer(chunkCells >> chunk.lod, lodSteps);
+            glBindVertexArray(chunk.vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements.ebo);
+            glDrawElements(GL_TRIANGLES, elements.count, GL_UNSIGNED_INT, 0);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+const sceneObjects::SO_Terrain::SO_TerrainElements& sceneObjects::SO_Terrain::elementBuffer(int cells, const int lodSteps[4]) {
+    unsigned long long key = elementKey(cells, lodSteps);
+    auto found = elementBuffers.find(key);
+    if (found != elementBuffers.end()) {
+        return found->second;
+    }
+    std::vector<unsigned int> elements = chunkElements(cells, lodSteps);
+    SO_TerrainElements buffer;
+    glGenBuffers(1, &buffer.ebo);
+    //bound with no VAO bound so no chunk's VAO is changed
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(unsigned int), elements.data(), GL_STATIC_DRAW);
+    buffer.count = (GLsizei)elements.size();
+    return elementBuffers[key] = buffer;
+}
+
+int sceneObjects::SO_Terrain::getMaxLod(void) const {
+    return maxLod;
+}
+
+int sceneObjects::SO_Terrain::getChunkLod(int chunkX, int chunkZ) const {
+    return chunks[chunkX + chunkZ*chunksX].lod;
+}
+
+size_t sceneObjects::SO_Terrain::getPendingCount(void) const {
+    return pending;
+}
+
+//the inner cells are a plain grid, and the ring of cells round them is made of 4 strips, each zipped between the inner row
+//and the edge vertices that side uses - the strips meet on the diagonals at the corners
+std::vector<unsigned int> sceneObjects::SO_Terrain::chunkElements(int cells, const int lodSteps[4]) {
+    std::vector<unsigned int> elements;
+    int size = cells + 1;
+    auto addTriangle = [&](int ai, int aj, int bi, int bj, int ci, int cj) {
+        //counter-clockwise seen from +y is a positive (B-A).z*(C-A).x - (B-A).x*(C-A).z
+        int winding = (bj - aj)*(ci - ai) - (bi - ai)*(cj - aj);
+        if (winding == 0) {
+            return;
+        }
+        if (winding < 0) {
+            std::swap(bi, ci);
+            std::swap(bj, cj);
+        }
+        elements.push_back(ai + aj*size);
+        elements.push_back(bi + bj*size);
+        elements.push_back(ci + cj*size);
+    };
+    for (int j = 1; j < cells - 1; j++) {
+        for (int i = 1; i < cells - 1; i++) {
+            addTriangle(i, j, i, j + 1, i + 1, j);
+            addTriangle(i + 1, j, i, j + 1, i + 1, j + 1);
+        }
+    }
+    for (int side = 0; side < 4; side++) {
+        int step = 1;
+        for (int d = 0; d < lodSteps[side] && step*2 <= cells; d++) {
+            step *= 2;
+        }
+        //grid coordinates of the point `t` along the side, `inset` rows in from the edge
+        auto point = [&](int t, int inset, int& i, int& j) {
+            switch (side) {
+                case 0: i = t; j = inset; break;
+                case 1: i = cells - inset; j = t; break;
+                case 2: i = t; j = cells - inset; break;
+                default: i = inset; j = t; break;
+            }
+        };
+        int inner = 1;
+        int outer = 0;
+        while (inner < cells - 1 || outer < cells) {
+            int ai, aj, bi, bj, ci, cj;
+            point(inner, 1, ai, aj);
+            point(outer, 0, bi, bj);
+            //advance along whichever row's next vertex comes first
+            if (outer < cells && (inner >= cells - 1 || outer + step <= inner + 1)) {
+                point(outer + step, 0, ci, cj);
+                outer += step;
+            } else {
+                point(inner + 1, 1, ci, cj);
+                inner++;
+            }
+            addTriangle(ai, aj, bi, bj, ci, cj);
+        }
+    }
+    return elements;
+}
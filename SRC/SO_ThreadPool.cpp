@@ -0,0 +1,157 @@
+/** \file SO_ThreadPool.cpp */
+#include "sceneObjects.hpp"
+#include <algorithm>
+
+namespace {
+//the pool and queue index of the worker running on this thread, so tasks submitted from a worker stay on its own queue
+thread_local sceneObjects::SO_ThreadPool* currentPool = nullptr;
+thread_local unsigned int currentQueue = 0;
+}
+
+sceneObjects::SO_ThreadPool::SO_ParallelForState::SO_ParallelForState(size_t countIn, size_t grainSizeIn, size_t rangesIn, const std::function<void(size_t, size_t)>& bodyIn)
+    : count(countIn), grainSize(grainSizeIn), ranges(rangesIn), body(&bodyIn), nextRange(0), finishedRanges(0) {
+}
+
+//claim ranges of this loop until there are none left, then wake the caller if they were the last to finish
+void sceneObjects::SO_ThreadPool::SO_ParallelForState::runRanges(void) {
+    size_t finished = 0;
+    for (size_t r = nextRange++; r < ranges; r = nextRange++) {
+        size_t begin = r*grainSize;
+        size_t end = begin + grainSize < count ? begin + grainSize : count;
+        try {
+            (*body)(begin, end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        finished++;
+    }
+    if (finished > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedRanges += finished;
+        if (finishedRanges == ranges) {
+            finishedCondition.notify_all();
+        }
+    }
+}
+
+sceneObjects::SO_ThreadPool::SO_ThreadPool(unsigned int threadCount) : queuedTasks(0), nextQueue(0) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) { //hardware_concurrency() may not be able to tell
+            threadCount = 1;
+        }
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        queues.push_back(std::unique_ptr<SO_TaskQueue>(new SO_TaskQueue()));
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&SO_ThreadPool::workerLoop, this, i));
+    }
+}
+
+//finish the queued tasks then stop the workers
+sceneObjects::SO_ThreadPool::~SO_ThreadPool(void) {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+unsigned int sceneObjects::SO_ThreadPool::getThreadCount(void) {
+    return workers.size();
+}
+
+//add a task to the current worker's queue, or spread tasks from other threads around the queues
+void sceneObjects::SO_ThreadPool::push(std::function<void()> task) {
+    unsigned int index = currentPool == this ? currentQueue : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+        queuedTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); //taken so that a worker can't miss the wake up between checking queuedTasks and waiting
+    }
+    wakeCondition.notify_one();
+}
+
+//take a task from the back of our own queue, or from the front of another queue, and run it
+bool sceneObjects::SO_ThreadPool::runQueuedTask(unsigned int preferredQueue) {
+    std::function<void()> task;
+    for (unsigned int i = 0; i < queues.size() && !task; i++) {
+        unsigned int index = (preferredQueue + i) % queues.size();
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        if (!queues[index]->tasks.empty()) {
+            if (i == 0) {
+                task = std::move(queues[index]->tasks.back());
+                queues[index]->tasks.pop_back();
+            } else {
+                task = std::move(queues[index]->tasks.front());
+                queues[index]->tasks.pop_front();
+            }
+            queuedTasks--;
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void sceneObjects::SO_ThreadPool::workerLoop(unsigned int index) {
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        if (runQueuedTask(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
+
+//split [0, count) into ranges of grainSize and run them on the pool, with the calling thread taking ranges too
+void sceneObjects::SO_ThreadPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (grainSize == 0) {
+        grainSize = 1;
+    }
+    size_t ranges = (count + grainSize - 1)/grainSize;
+    if (ranges == 1) {
+        body(0, count);
+        return;
+    }
+
+    //the helpers may still be queued after this call returns, so they share the state - but they only touch `body` once they have
+    //claimed a range, and this call cannot return while a claimed range is unfinished
+    std::shared_ptr<SO_ParallelForState> state = std::make_shared<SO_ParallelForState>(count, grainSize, ranges, body);
+    size_t helpers = std::min<size_t>(ranges - 1, workers.size());
+    for (size_t i = 0; i < helpers; i++) {
+        push([state]() { state->runRanges(); });
+    }
+    state->runRanges();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finishedCondition.wait(lock, [&state]() { return state->finishedRanges == state->ranges; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+//the pool shared by all parallel functions in the library
+sceneObjects::SO_ThreadPool& sceneObjects::SO_ThreadPool::global(void) {
+    static SO_ThreadPool pool;
+    return pool;
+}
@@ -2,6 +2,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "sceneObjects.hpp"
+#include "noiseKernels.hpp"
+#include <cmath>
 
 
 //create vector at a ratio of division/subdivisions from vector1 to vector2
@@ -10,7 +12,7 @@ glm::vec3 sceneObjects::createRatioVector(int subdivisions, int division, glm::v
 }
 
 //a gradual step function between (0,0) and (1,1)
-double sceneObjects::fade(double x) {
+template <typename T> T sceneObjects::fade(T x) {
     if (x <= 0) {
         return 0;
     } else if (x >= 1) {
@@ -19,6 +21,10 @@ double sceneObjects::fade(double x) {
     return x*x*x*(x*(x*6 - 15) + 10); //return 6t^5-15t^4+10t^3 smooth between (0,0) and (1,1)
 }
 
+double sceneObjects::fade(double x) {
+    return fade<double>(x);
+}
+
 //increments around a loop
 int sceneObjects::inc(int num, int repeat) {
     num++;
@@ -29,7 +35,7 @@ int sceneObjects::inc(int num, int repeat) {
 }
 
 //get gradient of perlin corner
-double sceneObjects::grad(int hash, double x, double y, double z) {
+template <typename T> T sceneObjects::grad(int hash, T x, T y, T z) {
      switch(hash & 0xF) {
         case 0x0: return  x + y;
         case 0x1: return -x + y;
@@ -51,9 +57,17 @@ double sceneObjects::grad(int hash, double x, double y, double z) {
     }
 }
 
+double sceneObjects::grad(int hash, double x, double y, double z) {
+    return grad<double>(hash, x, y, z);
+}
+
 //modulus function without negatives
+template <typename T> T sceneObjects::modulus(T x, T y) {
+    return x - y*std::floor(x/y);
+}
+
 double sceneObjects::modulus(double x, double y) {
-    return x - y*floor(x/y);
+    return modulus<double>(x, y);
 }
 
 int sceneObjects::perlinPerms[512] = { 151,160,137,91,90,15,                 // Hash lookup table as defined by Ken Perlin.  This is a randomly
@@ -85,59 +99,289 @@ int sceneObjects::perlinPerms[512] = { 151,160,137,91,90,15,                 //
                         138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
                     };
 
-//get perlin noise at coords (x,y,z)
-double sceneObjects::perlin(double x, double y, double z, double repeat) { //https://adrianb.io/2014/08/09/perlinnoise.html
-    if (repeat > 0) {
-        x = modulus(x, repeat);
-        y = modulus(y, repeat);
-        z = modulus(z, repeat);
+namespace {
+
+/// perlin() lattice wrapping with no repeat - the lattice only wraps at the 256 entries of the permutation table
+template <typename T> struct UnboundedLattice {
+    T wrap(T x) const { return sceneObjects::modulus<T>(x, 256); }
+    int index(int whole) const { return whole & 255; }
+    int inc(int num) const { return num + 1; }
+};
+
+/// perlin() lattice wrapping every `repeat` units, chosen at runtime - the wrapping perlin() uses when repeat > 0
+template <typename T> struct RepeatLattice {
+    T repeat; ///< the period of the coordinates
+    int period; ///< (int)repeat, the period of the lattice indices
+
+    RepeatLattice(T repeatIn) : repeat(repeatIn), period((int)repeatIn) {}
+    T wrap(T x) const { return sceneObjects::modulus<T>(sceneObjects::modulus<T>(x, repeat), 256); }
+    int index(int whole) const { return whole & 255; }
+    //inc(num, period) without its branch and division - the wrapped indices are at most period, so two subtractions always suffice
+    int inc(int num) const {
+        num++;
+        num = num >= period ? num - period : num;
+        return num >= period ? num - period : num;
+    }
+};
+
+/// perlin() lattice wrapping every `Period` units, a power of 2 fixed at compile time - the index wrapping is a mask
+template <typename T, int Period> struct FixedLattice {
+    //modulus() inlined - dividing by a power of 2 is an exact multiply, and truncating gives the floor without a library call
+    T wrap(T x) const {
+        T cells = x*((T)1/Period);
+        T whole = (T)(long long)cells;
+        whole = whole > cells ? whole - 1 : whole;
+        return x - Period*whole;
     }
+    int index(int whole) const { return whole & (Period - 1); }
+    int inc(int num) const { return (num + 1) & (Period - 1); }
+};
+
+/// the lattice wrapping for each sceneObjects::perlin<Wrap> policy
+template <typename Wrap, typename T> struct LatticeFor;
+template <typename T, int Period> struct LatticeFor<sceneObjects::SO_FixedPeriod<Period>, T> { typedef FixedLattice<T, Period> Type; };
 
-    x = modulus(x, 256);
-    y = modulus(y, 256);
-    z = modulus(z, 256);
+//get perlin noise at coords (x,y,z) using the permutation table perms (512 entries), with the coordinates wrapped by lattice
+template <typename T, typename P, class L> T perlinLattice(const P* perms, T x, T y, T z, const L& lattice) { //https://adrianb.io/2014/08/09/perlinnoise.html
+    using namespace sceneObjects;
+    x = lattice.wrap(x);
+    y = lattice.wrap(y);
+    z = lattice.wrap(z);
 
-    int xi = (int)x & 255;                           // Calculate the "unit cube" that the point asked will be located in
-    int yi = (int)y & 255;                              // The left bound is ( |_x_|,|_y_|,|_z_| ) and the right bound is that
-    int zi = (int)z & 255;                              // plus 1.  Next we calculate the location (from 0.0 to 1.0) in that cube.
-    double xf = x-(int)x;
-    double yf = y-(int)y;
-    double zf = z-(int)z;
+    int xi = lattice.index((int)x);                  // Calculate the "unit cube" that the point asked will be located in
+    int yi = lattice.index((int)y);                     // The left bound is ( |_x_|,|_y_|,|_z_| ) and the right bound is that
+    int zi = lattice.index((int)z);                     // plus 1.  Next we calculate the location (from 0.0 to 1.0) in that cube.
+    int xi1 = lattice.inc(xi);
+    int yi1 = lattice.inc(yi);
+    int zi1 = lattice.inc(zi);
+    T xf = x-(int)x;
+    T yf = y-(int)y;
+    T zf = z-(int)z;
 
-    double u = fade(xf);
-    double v = fade(yf);
-    double w = fade(zf);
+    T u = fade<T>(xf);
+    T v = fade<T>(yf);
+    T w = fade<T>(zf);
 
     int aaa, aba, aab, abb, baa, bba, bab, bbb;
-    aaa = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[    xi ]        +    yi ]           +    zi ];
-    aba = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[    xi ]        +inc(yi, repeat)]   +    zi ];
-    aab = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[    xi ]        +    yi ]           +inc(zi, repeat)];
-    abb = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[    xi ]        +inc(yi, repeat)]   +inc(zi, repeat)];
-    baa = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[inc(xi, repeat)]+    yi ]           +    zi ];
-    bba = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[inc(xi, repeat)]+inc(yi, repeat)]   +    zi ];
-    bab = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[inc(xi, repeat)]+    yi ]           +inc(zi, repeat)];
-    bbb = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[inc(xi, repeat)]+inc(yi, repeat)]   +inc(zi, repeat)];
-
-    double x1, x2, y1, y2;
-    x1 = lerp(    grad (aaa, xf  , yf  , zf),           // The gradient function calculates the dot product between a pseudorandom
-                grad (baa, xf-1, yf  , zf),             // gradient vector and the vector from the input coordinate to the 8
+    aaa = perms[perms[perms[xi ]+yi ]+zi ];
+    aba = perms[perms[perms[xi ]+yi1]+zi ];
+    aab = perms[perms[perms[xi ]+yi ]+zi1];
+    abb = perms[perms[perms[xi ]+yi1]+zi1];
+    baa = perms[perms[perms[xi1]+yi ]+zi ];
+    bba = perms[perms[perms[xi1]+yi1]+zi ];
+    bab = perms[perms[perms[xi1]+yi ]+zi1];
+    bbb = perms[perms[perms[xi1]+yi1]+zi1];
+
+    T x1, x2, y1, y2;
+    x1 = lerp(    grad<T>(aaa, xf  , yf  , zf),           // The gradient function calculates the dot product between a pseudorandom
+                grad<T>(baa, xf-1, yf  , zf),             // gradient vector and the vector from the input coordinate to the 8
                 u);                                     // surrounding points in its unit cube.
-    x2 = lerp(    grad (aba, xf  , yf-1, zf),           // This is all then lerped together as a sort of weighted average based on the faded (u,v,w)
-                grad (bba, xf-1, yf-1, zf),             // values we made earlier.
+    x2 = lerp(    grad<T>(aba, xf  , yf-1, zf),           // This is all then lerped together as a sort of weighted average based on the faded (u,v,w)
+                grad<T>(bba, xf-1, yf-1, zf),             // values we made earlier.
                   u);
     y1 = lerp(x1, x2, v);
 
-    x1 = lerp(    grad (aab, xf  , yf  , zf-1),
-                grad (bab, xf-1, yf  , zf-1),
+    x1 = lerp(    grad<T>(aab, xf  , yf  , zf-1),
+                grad<T>(bab, xf-1, yf  , zf-1),
                 u);
-    x2 = lerp(    grad (abb, xf  , yf-1, zf-1),
-                  grad (bbb, xf-1, yf-1, zf-1),
+    x2 = lerp(    grad<T>(abb, xf  , yf-1, zf-1),
+                  grad<T>(bbb, xf-1, yf-1, zf-1),
                   u);
     y2 = lerp (x1, x2, v);
 
     return (lerp (y1, y2, w)+1)/2;
 }
 
+//get 2D perlin noise at coords (x,y) from the 4 corners of its lattice square, with the coordinates wrapped by lattice
+template <typename T, typename P, class L> T perlin2DLattice(const P* perms, T x, T y, const L& lattice) {
+    using namespace sceneObjects;
+    x = lattice.wrap(x);
+    y = lattice.wrap(y);
+
+    int xi = lattice.index((int)x);
+    int yi = lattice.index((int)y);
+    int xi1 = lattice.inc(xi);
+    int yi1 = lattice.inc(yi);
+    T xf = x-(int)x;
+    T yf = y-(int)y;
+
+    T u = fade<T>(xf);
+    T v = fade<T>(yf);
+
+    int aa = perms[perms[xi ]+yi ];
+    int ab = perms[perms[xi ]+yi1];
+    int ba = perms[perms[xi1]+yi ];
+    int bb = perms[perms[xi1]+yi1];
+
+    T x1 = lerp(noiseKernels::grad2<T>(aa, xf, yf), noiseKernels::grad2<T>(ba, xf-1, yf), u);
+    T x2 = lerp(noiseKernels::grad2<T>(ab, xf, yf-1), noiseKernels::grad2<T>(bb, xf-1, yf-1), u);
+    return (lerp(x1, x2, v)+1)/2;
+}
+
+//lerp() with the weight kept in the precision T - for the gradient terms, which needn't match the value's float weights
+template <typename T> inline T lerpPrecise(T a, T b, T x) {
+    return a + x*(b - a);
+}
+
+//get perlin noise at coords (x,y,z) and its gradient from the same corner hashes - the value matches perlinLattice
+template <typename T, typename P, class L> T perlinDerivativeLattice(const P* perms, T x, T y, T z, const L& lattice, T* gradient) {
+    using namespace sceneObjects;
+    x = lattice.wrap(x);
+    y = lattice.wrap(y);
+    z = lattice.wrap(z);
+
+    int xi = lattice.index((int)x);
+    int yi = lattice.index((int)y);
+    int zi = lattice.index((int)z);
+    int xi1 = lattice.inc(xi);
+    int yi1 = lattice.inc(yi);
+    int zi1 = lattice.inc(zi);
+    T xf = x-(int)x;
+    T yf = y-(int)y;
+    T zf = z-(int)z;
+
+    //kept in the precision T for the gradient - lerp() rounds them to float for the value, as perlinLattice does
+    T u = fade<T>(xf);
+    T v = fade<T>(yf);
+    T w = fade<T>(zf);
+
+    //the corners are indexed by their x, y, z offsets as bits 2, 1, 0
+    int hashes[8];
+    hashes[0] = perms[perms[perms[xi ]+yi ]+zi ];
+    hashes[1] = perms[perms[perms[xi ]+yi ]+zi1];
+    hashes[2] = perms[perms[perms[xi ]+yi1]+zi ];
+    hashes[3] = perms[perms[perms[xi ]+yi1]+zi1];
+    hashes[4] = perms[perms[perms[xi1]+yi ]+zi ];
+    hashes[5] = perms[perms[perms[xi1]+yi ]+zi1];
+    hashes[6] = perms[perms[perms[xi1]+yi1]+zi ];
+    hashes[7] = perms[perms[perms[xi1]+yi1]+zi1];
+
+    //the dot product with each corner's gradient, and the gradient vectors themselves
+    T n[8], dirs[3][8];
+    for (int i = 0; i < 8; i++) {
+        n[i] = grad<T>(hashes[i], (i & 4) ? xf-1 : xf, (i & 2) ? yf-1 : yf, (i & 1) ? zf-1 : zf);
+        dirs[0][i] = grad<T>(hashes[i], 1, 0, 0);
+        dirs[1][i] = grad<T>(hashes[i], 0, 1, 0);
+        dirs[2][i] = grad<T>(hashes[i], 0, 0, 1);
+    }
+
+    T x1 = lerp(n[0], n[4], u);
+    T x2 = lerp(n[2], n[6], u);
+    T y1 = lerp(x1, x2, v);
+    T x3 = lerp(n[1], n[5], u);
+    T x4 = lerp(n[3], n[7], u);
+    T y2 = lerp(x3, x4, v);
+
+    //d/dx of the interpolation is the interpolated gradient vectors plus the change in weights times the difference across the cell
+    T dLdu = lerpPrecise(lerpPrecise(n[4]-n[0], n[6]-n[2], v), lerpPrecise(n[5]-n[1], n[7]-n[3], v), w);
+    T dLdv = lerpPrecise(x2-x1, x4-x3, w);
+    T dLdw = y2-y1;
+    T fracs[3] = {xf, yf, zf};
+    T partials[3] = {dLdu, dLdv, dLdw};
+    for (int axis = 0; axis < 3; axis++) {
+        const T* d = dirs[axis];
+        T interpolated = lerpPrecise(lerpPrecise(lerpPrecise(d[0], d[4], u), lerpPrecise(d[2], d[6], u), v),
+                                     lerpPrecise(lerpPrecise(d[1], d[5], u), lerpPrecise(d[3], d[7], u), v), w);
+        T t = fracs[axis];
+        T fadeDerivative = 30*((t*t)*((t-1)*(t-1)));
+        gradient[axis] = (interpolated + fadeDerivative*partials[axis])/2;
+    }
+
+    return (lerp(y1, y2, w)+1)/2;
+}
+
+}
+
+//get perlin noise at coords (x,y,z) using the permutation table perms - the repeat test is made once, outside the lattice code
+template <typename T, typename P> T sceneObjects::noiseKernels::perlinTable(const P* perms, T x, T y, T z, T repeat) {
+    if (repeat > 0) {
+        return perlinLattice<T, P>(perms, x, y, z, RepeatLattice<T>(repeat));
+    }
+    return perlinLattice<T, P>(perms, x, y, z, UnboundedLattice<T>());
+}
+
+//get 2D perlin noise at coords (x,y) using the permutation table perms
+template <typename T, typename P> T sceneObjects::noiseKernels::perlin2DTable(const P* perms, T x, T y, T repeat) {
+    if (repeat > 0) {
+        return perlin2DLattice<T, P>(perms, x, y, RepeatLattice<T>(repeat));
+    }
+    return perlin2DLattice<T, P>(perms, x, y, UnboundedLattice<T>());
+}
+
+//get perlin noise at coords (x,y,z) and its gradient using the permutation table perms
+template <typename T, typename P> T sceneObjects::noiseKernels::perlinDerivativeTable(const P* perms, T x, T y, T z, T repeat, T* gradient) {
+    if (repeat > 0) {
+        return perlinDerivativeLattice<T, P>(perms, x, y, z, RepeatLattice<T>(repeat), gradient);
+    }
+    return perlinDerivativeLattice<T, P>(perms, x, y, z, UnboundedLattice<T>(), gradient);
+}
+
+//get perlin noise at coords (x,y,z)
+template <typename T> T sceneObjects::perlin(T x, T y, T z, T repeat) {
+    return noiseKernels::perlinTable<T, int>(perlinPerms, x, y, z, repeat);
+}
+
+double sceneObjects::perlin(double x, double y, double z, double repeat) {
+    return perlin<double>(x, y, z, repeat);
+}
+
+//get perlin noise at coords (x,y,z) with the lattice wrapping chosen at compile time
+template <typename Wrap> double sceneObjects::perlin(double x, double y, double z) {
+    return perlinLattice<double, int>(perlinPerms, x, y, z, typename LatticeFor<Wrap, double>::Type());
+}
+
+template <typename Wrap> float sceneObjects::perlin(float x, float y, float z) {
+    return perlinLattice<float, int>(perlinPerms, x, y, z, typename LatticeFor<Wrap, float>::Type());
+}
+
+//get 2D perlin noise at coords (x,y)
+double sceneObjects::perlin2D(double x, double y, double repeat) {
+    return noiseKernels::perlin2DTable<double, int>(perlinPerms, x, y, repeat);
+}
+
+float sceneObjects::perlin2D(float x, float y, float repeat) {
+    return noiseKernels::perlin2DTable<float, int>(perlinPerms, x, y, repeat);
+}
+
+//get perlin noise at coords (x,y,z) along with its gradient
+double sceneObjects::perlinDerivative(double x, double y, double z, double repeat, glm::dvec3& gradient) {
+    double components[3];
+    double value = noiseKernels::perlinDerivativeTable<double, int>(perlinPerms, x, y, z, repeat, components);
+    gradient = glm::dvec3(components[0], components[1], components[2]);
+    return value;
+}
+
+//the precisions the templated noise functions are provided for
+template float sceneObjects::fade<float>(float x);
+template double sceneObjects::fade<double>(double x);
+template float sceneObjects::grad<float>(int hash, float x, float y, float z);
+template double sceneObjects::grad<double>(int hash, double x, double y, double z);
+template float sceneObjects::modulus<float>(float x, float y);
+template double sceneObjects::modulus<double>(double x, double y);
+template float sceneObjects::perlin<float>(float x, float y, float z, float repeat);
+template double sceneObjects::perlin<double>(double x, double y, double z, double repeat);
+template double sceneObjects::perlin<sceneObjects::SO_FixedPeriod<16> >(double x, double y, double z);
+template double sceneObjects::perlin<sceneObjects::SO_FixedPeriod<32> >(double x, double y, double z);
+template double sceneObjects::perlin<sceneObjects::SO_FixedPeriod<64> >(double x, double y, double z);
+template double sceneObjects::perlin<sceneObjects::SO_FixedPeriod<128> >(double x, double y, double z);
+template double sceneObjects::perlin<sceneObjects::SO_FixedPeriod<256> >(double x, double y, double z);
+template float sceneObjects::perlin<sceneObjects::SO_FixedPeriod<16> >(float x, float y, float z);
+template float sceneObjects::perlin<sceneObjects::SO_FixedPeriod<32> >(float x, float y, float z);
+template float sceneObjects::perlin<sceneObjects::SO_FixedPeriod<64> >(float x, float y, float z);
+template float sceneObjects::perlin<sceneObjects::SO_FixedPeriod<128> >(float x, float y, float z);
+template float sceneObjects::perlin<sceneObjects::SO_FixedPeriod<256> >(float x, float y, float z);
+template float sceneObjects::noiseKernels::perlinTable<float, int>(const int* perms, float x, float y, float z, float repeat);
+template double sceneObjects::noiseKernels::perlinTable<double, int>(const int* perms, double x, double y, double z, double repeat);
+template float sceneObjects::noiseKernels::perlinTable<float, unsigned char>(const unsigned char* perms, float x, float y, float z, float repeat);
+template double sceneObjects::noiseKernels::perlinTable<double, unsigned char>(const unsigned char* perms, double x, double y, double z, double repeat);
+template float sceneObjects::noiseKernels::perlin2DTable<float, int>(const int* perms, float x, float y, float repeat);
+template double sceneObjects::noiseKernels::perlin2DTable<double, int>(const int* perms, double x, double y, double repeat);
+template float sceneObjects::noiseKernels::perlinDerivativeTable<float, int>(const int* perms, float x, float y, float z, float repeat, float* gradient);
+template double sceneObjects::noiseKernels::perlinDerivativeTable<double, int>(const int* perms, double x, double y, double z, double repeat, double* gradient);
+template float sceneObjects::noiseKernels::perlinDerivativeTable<float, unsigned char>(const unsigned char* perms, float x, float y, float z, float repeat, float* gradient);
+template double sceneObjects::noiseKernels::perlinDerivativeTable<double, unsigned char>(const unsigned char* perms, double x, double y, double z, double repeat, double* gradient);
+
+
 //loads texture files into openGL
 GLuint sceneObjects::loadTextureFromFile(std::string path) {
     std::string filename = path;
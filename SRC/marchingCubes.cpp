@@ -0,0 +1,379 @@
+/** \file marchingCubes.cpp */
+#include "sceneObjects.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+//cube corner c is at (c & 1, (c >> 1) & 1, (c >> 2) & 1) and cube edge e runs along axis e/4 from the corner made by inserting a 0 bit for that axis into e % 4
+inline int cubeEdge(int cornerA, int cornerB) {
+    int lower = cornerA < cornerB ? cornerA : cornerB;
+    int axis = (cornerA ^ cornerB) == 1 ? 0 : ((cornerA ^ cornerB) == 2 ? 1 : 2);
+    return axis*4 + ((lower & ((1 << axis) - 1)) | ((lower >> (axis + 1)) << axis));
+}
+
+//the lower corner of cube edge `edge` - see cubeEdge()
+inline int cubeEdgeCorner(int edge) {
+    int axis = edge/4;
+    int bits = edge % 4;
+    return (bits & ((1 << axis) - 1)) | ((bits >> axis) << (axis + 1));
+}
+
+/// The triangles of each of the 256 marching cubes cases, as triples of cube edges
+/**
+ * Built once from the faces of the cube rather than written out as a table: on each face the crossed edges are joined in pairs around each run of
+ * inside corners, the pairs are chained into closed loops and each loop is split into a fan of triangles. A face's pairing depends only on its 4
+ * corners, so the two cubes sharing a face always agree and the surface has no cracks. A loop through an ambiguous face crosses it twice, and a
+ * fan diagonal between two edges of one face would lie in the face, where the next cube can use the same two vertices - so each fan starts from
+ * a corner of the loop whose diagonals all pass through the inside of the cube, which every one of the 256 cases has.
+**/
+struct SO_CubeCases {
+    int triangleCounts[256]; ///< the number of triangles in each case
+    unsigned char edges[256][30]; ///< the cube edges of each triangle in each case - at most 10 triangles as 12 edges make at least one loop
+    SO_CubeCases(void);
+};
+
+SO_CubeCases::SO_CubeCases(void) {
+    //the corners of each face, counter-clockwise seen from outside the cube
+    const int faces[6][4] = {{0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+    //the faces each edge lies on, as bits
+    int edgeFaces[12] = {};
+    for (int face = 0; face < 6; face++) {
+        for (int k = 0; k < 4; k++) {
+            edgeFaces[cubeEdge(faces[face][k], faces[face][(k + 1) % 4])] |= 1 << face;
+        }
+    }
+    for (int cubeCase = 0; cubeCase < 256; cubeCase++) {
+        //walking counter-clockwise round each face, join the edge leaving each run of inside corners to the edge entering it
+        int next[12];
+        for (int edge = 0; edge < 12; edge++) {
+            next[edge] = -1;
+        }
+        for (int face = 0; face < 6; face++) {
+            for (int k = 0; k < 4; k++) {
+                int corner = faces[face][k];
+                int following = faces[face][(k + 1) % 4];
+                if ((cubeCase >> corner & 1) || !(cubeCase >> following & 1)) {
+                    continue;
+                }
+                int last = (k + 1) % 4;
+                while (cubeCase >> faces[face][(last + 1) % 4] & 1) {
+                    last = (last + 1) % 4;
+                }
+                next[cubeEdge(faces[face][last], faces[face][(last + 1) % 4])] = cubeEdge(corner, following);
+            }
+        }
+        //every crossed edge is left on one of its faces and entered on the other, so next[] forms closed loops
+        triangleCounts[cubeCase] = 0;
+        bool visited[12] = {};
+        for (int start = 0; start < 12; start++) {
+            if (next[start] < 0 || visited[start]) {
+                continue;
+            }
+            int loop[12];
+            int length = 0;
+            for (int edge = start; !visited[edge]; edge = next[edge]) {
+                visited[edge] = true;
+                loop[length++] = edge;
+            }
+            //fan from the first corner none of whose diagonals join two edges of the same face
+            auto diagonalInFace = [&](int first) {
+                for (int i = 2; i + 1 < length; i++) {
+                    if (edgeFaces[loop[first]] & edgeFaces[loop[(first + i) % length]]) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            int apex = 0;
+            while (diagonalInFace(apex)) {
+                apex++;
+            }
+            //the loops run clockwise seen from outside the surface, so the fans are taken in reverse
+            for (int i = 1; i + 1 < length; i++) {
+                unsigned char* triangle = edges[cubeCase] + 3*triangleCounts[cubeCase]++;
+                triangle[0] = (unsigned char)loop[apex];
+                triangle[1] = (unsigned char)loop[(apex + i + 1) % length];
+                triangle[2] = (unsigned char)loop[(apex + i) % length];
+            }
+        }
+    }
+}
+
+const SO_CubeCases& cubeCases(void) {
+    static const SO_CubeCases cases;
+    return cases;
+}
+
+/// The sampled field being meshed by marchingCubes()
+template <typename T> struct SO_IsoGrid {
+    const T* samples; ///< the samples, x fastest
+    int size[3]; ///< the number of samples along each axis
+    double origin[3]; ///< the position of the first sample
+    double spacing[3]; ///< the distance between samples along each axis
+    T isoLevel; ///< the level of the surface
+
+    size_t index(int i, int j, int k) const {
+        return (size_t)i + (size_t)size[0]*((size_t)j + (size_t)size[1]*k);
+    }
+    //the gradient at a sample by central differences, one-sided at the edges of the grid
+    glm::dvec3 gradient(const int point[3]) const {
+        glm::dvec3 result;
+        for (int axis = 0; axis < 3; axis++) {
+            int low[3] = {point[0], point[1], point[2]};
+            int high[3] = {point[0], point[1], point[2]};
+            low[axis] = point[axis] > 0 ? point[axis] - 1 : 0;
+            high[axis] = point[axis] + 1 < size[axis] ? point[axis] + 1 : point[axis];
+            double difference = (double)samples[index(high[0], high[1], high[2])] - (double)samples[index(low[0], low[1], low[2])];
+            result[axis] = difference/((high[axis] - low[axis])*spacing[axis]);
+        }
+        return result;
+    }
+};
+
+/// The work of one block of cells
+struct SO_IsoBlock {
+    int begin[3]; ///< the first cell of the block
+    int end[3]; ///< one past the last cell of the block
+    int pointEnd[3]; ///< one past the last sample whose edges the block owns - the same as `end` except in the last block along an axis
+    std::vector<glm::vec3> vertices; ///< the vertices on the block's edges
+    std::vector<glm::vec3> normals; ///< the normals of `vertices`
+    std::vector<size_t> edgeSlots; ///< the edge each vertex lies on, as 3 times the grid index of its lower sample plus its axis
+    std::vector<int> boundaryVertices; ///< the vertices on edges from the block's lower faces, which the blocks below it also use
+    std::vector<int> faceElements; ///< the block's triangles, as global vertex indices
+    size_t vertexOffset = 0; ///< the index of the block's first vertex in the mesh
+    size_t elementOffset = 0; ///< the index of the block's first element in the mesh
+};
+
+//add the vertex where the surface crosses the edge from sample `point` along `axis`, interpolated between the samples at its ends
+template <typename T> void isoEdgeVertex(const SO_IsoGrid<T>& grid, SO_IsoBlock& block, const int point[3], int axis, size_t index, size_t otherIndex) {
+    int other[3] = {point[0], point[1], point[2]};
+    other[axis]++;
+    double value = grid.samples[index];
+    double t = ((double)grid.isoLevel - value)/((double)grid.samples[otherIndex] - value);
+    glm::vec3 vertex;
+    for (int c = 0; c < 3; c++) {
+        vertex[c] = (float)(grid.origin[c] + (point[c] + (c == axis ? t : 0.0))*grid.spacing[c]);
+    }
+    glm::dvec3 gradient = grid.gradient(point);
+    gradient += t*(grid.gradient(other) - gradient);
+    double length = glm::length(gradient);
+    if ((point[0] == block.begin[0] && point[0] > 0) || (point[1] == block.begin[1] && point[1] > 0) || (point[2] == block.begin[2] && point[2] > 0)) {
+        block.boundaryVertices.push_back((int)block.vertices.size());
+    }
+    block.vertices.push_back(vertex);
+    block.normals.push_back(length > 0 ? glm::vec3(-gradient/length) : glm::vec3(0.0f));
+    block.edgeSlots.push_back(3*index + axis);
+}
+
+//give every crossed edge owned by the block a vertex
+template <typename T> void isoBlockVertices(const SO_IsoGrid<T>& grid, SO_IsoBlock& block) {
+    size_t rowStride = grid.size[0];
+    size_t sliceStride = rowStride*grid.size[1];
+    for (int k = block.begin[2]; k < block.pointEnd[2]; k++) {
+        bool zEdges = k + 1 < grid.size[2];
+        for (int j = block.begin[1]; j < block.pointEnd[1]; j++) {
+            bool yEdges = j + 1 < grid.size[1];
+            size_t index = grid.index(block.begin[0], j, k);
+            for (int i = block.begin[0]; i < block.pointEnd[0]; i++, index++) {
+                int point[3] = {i, j, k};
+                bool inside = grid.samples[index] > grid.isoLevel;
+                if (i + 1 < grid.size[0] && (grid.samples[index + 1] > grid.isoLevel) != inside) {
+                    isoEdgeVertex(grid, block, point, 0, index, index + 1);
+                }
+                if (yEdges && (grid.samples[index + rowStride] > grid.isoLevel) != inside) {
+                    isoEdgeVertex(grid, block, point, 1, index, index + rowStride);
+                }
+                if (zEdges && (grid.samples[index + sliceStride] > grid.isoLevel) != inside) {
+                    isoEdgeVertex(grid, block, point, 2, index, index + sliceStride);
+                }
+            }
+        }
+    }
+}
+
+//look up the triangles of each cell in the block - every block's vertexOffset must already be set
+//`edgeVertices` is scratch space for the global vertex index on each edge of the block's samples, including those on its upper faces, which
+//come from the `neighbours` above it along x, y and z (neighbour n is offset by bit 0, 1 and 2 of n + 1 along x, y and z - null past the grid)
+//the inside flags of the 4 samples at the cell's upper x are carried along the row to be the next cell's lower x
+template <typename T> void isoBlockTriangles(const SO_IsoGrid<T>& grid, const SO_CubeCases& cases, SO_IsoBlock& block, const SO_IsoBlock* const neighbours[7],
+                                             std::vector<int>& edgeVertices) {
+    size_t rowStride = grid.size[0];
+    size_t sliceStride = rowStride*grid.size[1];
+    size_t localSize[3];
+    for (int axis = 0; axis < 3; axis++) {
+        localSize[axis] = block.end[axis] - block.begin[axis] + 1;
+    }
+    edgeVertices.resize(3*localSize[0]*localSize[1]*localSize[2]);
+    //the slot in edgeVertices of a grid edge slot inside the block's samples - returns false for one outside them
+    auto localSlot = [&](size_t slot, size_t& local) {
+        size_t index = slot/3;
+        size_t point[3] = {index % rowStride, index/rowStride % grid.size[1], index/sliceStride};
+        for (int axis = 0; axis < 3; axis++) {
+            if (point[axis] > (size_t)block.end[axis]) {
+                return false;
+            }
+            point[axis] -= block.begin[axis];
+        }
+        local = 3*(point[0] + localSize[0]*(point[1] + localSize[1]*point[2])) + slot % 3;
+        return true;
+    };
+    size_t local = 0;
+    for (size_t v = 0; v < block.edgeSlots.size(); v++) {
+        localSlot(block.edgeSlots[v], local);
+        edgeVertices[local] = (int)(block.vertexOffset + v);
+    }
+    for (int n = 0; n < 7; n++) {
+        if (!neighbours[n]) {
+            continue;
+        }
+        for (int v : neighbours[n]->boundaryVertices) {
+            if (localSlot(neighbours[n]->edgeSlots[v], local)) {
+                edgeVertices[local] = (int)(neighbours[n]->vertexOffset + v);
+            }
+        }
+    }
+
+    size_t edgeSlotOffsets[12];
+    for (int edge = 0; edge < 12; edge++) {
+        int corner = cubeEdgeCorner(edge);
+        edgeSlotOffsets[edge] = 3*((corner & 1) + localSize[0]*((corner >> 1 & 1) + localSize[1]*(corner >> 2 & 1))) + edge/4;
+    }
+    for (int k = block.begin[2]; k < block.end[2]; k++) {
+        for (int j = block.begin[1]; j < block.end[1]; j++) {
+            size_t localIndex = localSize[0]*((j - block.begin[1]) + localSize[1]*(k - block.begin[2]));
+            const T* row = grid.samples + grid.index(block.begin[0], j, k);
+            auto insideFlags = [&](int i) {
+                return (row[i] > grid.isoLevel) | (row[i + rowStride] > grid.isoLevel) << 2 |
+                       (row[i + sliceStride] > grid.isoLevel) << 4 | (row[i + rowStride + sliceStride] > grid.isoLevel) << 6;
+            };
+            int lower = insideFlags(0);
+            for (int i = 0; i < block.end[0] - block.begin[0]; i++, localIndex++) {
+                int upper = insideFlags(i + 1);
+                int cubeCase = lower | upper << 1;
+                lower = upper;
+                int count = cases.triangleCounts[cubeCase];
+                for (int n = 0; n < 3*count; n++) {
+                    int edge = cases.edges[cubeCase][n];
+                    block.faceElements.push_back(edgeVertices[3*localIndex + edgeSlotOffsets[edge]]);
+                }
+            }
+        }
+    }
+}
+
+}
+
+//mesh blocks of cells in parallel: place the vertices on each block's own edges, number them across the blocks, then emit each block's triangles
+//every edge belongs to the block holding its lower sample, so a vertex on a block boundary is made once and used from both sides
+//the edge to vertex lookup only ever covers one block at a time, so memory grows with the surface and the block size rather than the grid
+template <typename T> sceneObjects::SO_MeshData sceneObjects::marchingCubes(const T* samples, int width, int height, int depth, double x0, double y0, double z0,
+                                                                           double dx, double dy, double dz, T isoLevel, int blockSize) {
+    if (blockSize < 1) {
+        throw std::invalid_argument("marchingCubes() requires a blockSize of at least 1");
+    }
+    SO_MeshData mesh;
+    if (width < 2 || height < 2 || depth < 2) {
+        return mesh;
+    }
+    SO_IsoGrid<T> grid = {samples, {width, height, depth}, {x0, y0, z0}, {dx, dy, dz}, isoLevel};
+    const SO_CubeCases& cases = cubeCases();
+
+    int blockCounts[3];
+    for (int axis = 0; axis < 3; axis++) {
+        blockCounts[axis] = (grid.size[axis] - 1 + blockSize - 1)/blockSize;
+    }
+    std::vector<SO_IsoBlock> blocks((size_t)blockCounts[0]*blockCounts[1]*blockCounts[2]);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        size_t position[3] = {b % blockCounts[0], b/blockCounts[0] % blockCounts[1], b/blockCounts[0]/blockCounts[1]};
+        for (int axis = 0; axis < 3; axis++) {
+            int cells = grid.size[axis] - 1;
+            blocks[b].begin[axis] = (int)position[axis]*blockSize;
+            blocks[b].end[axis] = blocks[b].begin[axis] + blockSize < cells ? blocks[b].begin[axis] + blockSize : cells;
+            blocks[b].pointEnd[axis] = blocks[b].end[axis] == cells ? grid.size[axis] : blocks[b].end[axis];
+        }
+    }
+
+    SO_ThreadPool& pool = SO_ThreadPool::global();
+    pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            isoBlockVertices(grid, blocks[b]);
+        }
+    });
+
+    size_t vertexCount = 0;
+    for (SO_IsoBlock& block : blocks) {
+        block.vertexOffset = vertexCount;
+        vertexCount += block.vertices.size();
+    }
+    mesh.vertices.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            SO_IsoBlock& block = blocks[b];
+            std::copy(block.vertices.begin(), block.vertices.end(), mesh.vertices.begin() + block.vertexOffset);
+            std::copy(block.normals.begin(), block.normals.end(), mesh.normals.begin() + block.vertexOffset);
+            std::vector<glm::vec3>().swap(block.vertices);
+            std::vector<glm::vec3>().swap(block.normals);
+        }
+    });
+
+    pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<int> edgeVertices;
+        for (size_t b = begin; b < end; b++) {
+            size_t position[3] = {b % blockCounts[0], b/blockCounts[0] % blockCounts[1], b/blockCounts[0]/blockCounts[1]};
+            const SO_IsoBlock* neighbours[7];
+            for (int n = 0; n < 7; n++) {
+                size_t offset[3] = {(size_t)((n + 1) & 1), (size_t)((n + 1) >> 1 & 1), (size_t)((n + 1) >> 2 & 1)};
+                bool inside = true;
+                for (int axis = 0; axis < 3; axis++) {
+                    inside = inside && position[axis] + offset[axis] < (size_t)blockCounts[axis];
+                }
+                neighbours[n] = inside ? &blocks[b + offset[0] + blockCounts[0]*(offset[1] + blockCounts[1]*offset[2])] : nullptr;
+            }
+            isoBlockTriangles(grid, cases, blocks[b], neighbours, edgeVertices);
+        }
+    });
+
+    size_t elementCount = 0;
+    for (SO_IsoBlock& block : blocks) {
+        block.elementOffset = elementCount;
+        elementCount += block.faceElements.size();
+    }
+    mesh.faceElements.resize(elementCount);
+    pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            std::copy(blocks[b].faceElements.begin(), blocks[b].faceElements.end(), mesh.faceElements.begin() + blocks[b].elementOffset);
+            std::vector<size_t>().swap(blocks[b].edgeSlots);
+            std::vector<int>().swap(blocks[b].boundaryVertices);
+        }
+    });
+    return mesh;
+}
+
+//sample the field a few rows at a time on the thread pool, then mesh the samples
+sceneObjects::SO_MeshData sceneObjects::marchingCubes(const std::function<double(double, double, double)>& field, int width, int height, int depth,
+                                                      double x0, double y0, double z0, double dx, double dy, double dz, double isoLevel, int blockSize) {
+    if (width < 2 || height < 2 || depth < 2) {
+        return marchingCubes<double>(nullptr, 0, 0, 0, x0, y0, z0, dx, dy, dz, isoLevel, blockSize);
+    }
+    std::vector<double> samples((size_t)width*height*depth);
+    size_t rowsPerTask = width < 4096 ? 4096/width : 1;
+    SO_ThreadPool::global().parallelFor((size_t)height*depth, rowsPerTask, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            double y = y0 + (row % height)*dy;
+            double z = z0 + (row/height)*dz;
+            double* out = samples.data() + row*width;
+            for (int i = 0; i < width; i++) {
+                out[i] = field(x0 + i*dx, y, z);
+            }
+        }
+    });
+    return marchingCubes<double>(samples.data(), width, height, depth, x0, y0, z0, dx, dy, dz, isoLevel, blockSize);
+}
+
+template sceneObjects::SO_MeshData sceneObjects::marchingCubes<float>(const float* samples, int width, int height, int depth, double x0, double y0, double z0,
+                                                                     double dx, double dy, double dz, float isoLevel, int blockSize);
+template sceneObjects::SO_MeshData sceneObjects::marchingCubes<double>(const double* samples, int width, int height, int depth, double x0, double y0, double z0,
+                                                                      double dx, double dy, double dz, double isoLevel, int blockSize);
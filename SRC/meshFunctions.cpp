@@ -1,142 +1,245 @@
 /** \file meshFunctions.cpp */
 #include "sceneObjects.hpp"
+#include <limits>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//the end vertices of the icosahedron's edges, smallest index first - https://en.wikipedia.org/wiki/Regular_icosahedron#/media/File:Icosahedron-golden-rectangles.svg
+const int icosahedronEdges[30][2] = {
+    //edges across short edges
+    {0, 2}, {1, 3}, {4, 6}, {5, 7}, {8, 10}, {9, 11},
+    //edges across gaps - each +-1.0 goes to the vertex with a corresponding +-phi coordinate
+    {0, 8}, {0, 10}, {1, 8}, {1, 10}, {2, 9}, {2, 11}, {3, 9}, {3, 11},
+    {0, 4}, {2, 4}, {0, 5}, {2, 5}, {1, 6}, {3, 6}, {1, 7}, {3, 7},
+    {4, 8}, {6, 8}, {4, 9}, {6, 9}, {5, 10}, {7, 10}, {5, 11}, {7, 11}
+};
+
+//the faces as edges in order so edge: 0: (a, b)
+//                                     1: (a, c)
+//                                     2: (b, c)     with a < b < c
+//faces with a short rectangle edge, if one edge is the short one - the others must be one that connects to the same vertex
+// eg edges[0] contains 0,2 : and only vertices 4,5 connect to both via an edge eg. edges 0, 14, 15
+//final 8 faces - consider 1 rectange in image above, in direction of +-1, point 2 has +-phi in same coord and +-1 in other,
+//final point has +-phi in same coord as 2nd's +-1 and +-1 in same coord as 1sts +-phi. All +-s must match per coord
+const int icosahedronFaces[20][3] = {
+    {0, 14, 15}, {0, 16, 17}, {1, 18, 19}, {1, 20, 21}, {2, 22, 23}, {2, 24, 25}, {3, 26, 27}, {3, 28, 29},
+    {6, 7, 4}, {8, 9, 4}, {10, 11, 5}, {12, 13, 5},
+    {14, 6, 22}, {16, 7, 26}, {18, 8, 23}, {20, 9, 27}, {15, 10, 24}, {17, 11, 28}, {19, 12, 25}, {21, 13, 29}
+};
+
+//the vertex indices of an icosphere, all in closed form so every part of the mesh can be written independently
+//the layout is the 12 icosahedron vertices, then the edge vertices division by division, then the inner vertices face by face and row by row
+struct IcosphereLayout {
+    int subdivisions;
+    size_t innerStart; ///< The index of the first inner vertex
+    size_t innerPerFace; ///< The number of inner vertices on each face
+
+    //vertex `division` of the way along `edge` from its smaller end
+    int edgeVertex(int edge, int division) const {
+        if (division == 0) {
+            return icosahedronEdges[edge][0];
+        }
+        if (division == subdivisions) {
+            return icosahedronEdges[edge][1];
+        }
+        return 12 + (division - 1)*30 + edge;
+    }
+
+    //vertex `slice` along row `row` of `face` - row 0 is vertex a and row `subdivisions` is edge (b, c)
+    int rowVertex(int face, int row, int slice) const {
+        if (row == subdivisions) {
+            return edgeVertex(icosahedronFaces[face][2], slice);
+        }
+        if (slice == 0) {
+            return edgeVertex(icosahedronFaces[face][0], row);
+        }
+        if (slice == row) {
+            return edgeVertex(icosahedronFaces[face][1], row);
+        }
+        return (int)(innerStart + face*innerPerFace + (size_t)(row - 1)*(row - 2)/2 + slice - 1);
+    }
+};
+
+//the number of rows of faces each task works through - enough that a task has a few thousand triangles
+int icosphereRowsPerTask(int subdivisions) {
+    return subdivisions < 4096 ? 4096/subdivisions : 1;
+}
+
+}
 
 //create a sphere mesh starting with an icosohedron base (an icosphere)
 //subdivisions is the number of divisions along each edge of the starting icosahedron
+//every vertex and triangle has a closed form index, so the arrays are sized once and the edges, rows of faces and normalisation each run in parallel
 sceneObjects::SO_MeshData sceneObjects::createIcosphere(int subdivisions) {
+    if (subdivisions < 1) {
+        throw std::invalid_argument("createIcosphere() requires at least 1 subdivision, got " + std::to_string(subdivisions));
+    }
+    if (10*(size_t)subdivisions*subdivisions + 2 > (size_t)std::numeric_limits<int>::max()) {
+        throw std::invalid_argument("createIcosphere() has too many vertices for int elements with " + std::to_string(subdivisions) + " subdivisions");
+    }
+    IcosphereLayout layout = {subdivisions, 12 + 30*(size_t)(subdivisions - 1), (size_t)(subdivisions - 1)*(subdivisions - 2)/2};
+    sceneObjects::SO_MeshData icosphereData;
+    std::vector<glm::vec3>& vertices = icosphereData.vertices;
+    std::vector<int>& faceElements = icosphereData.faceElements;
+    vertices.resize(10*(size_t)subdivisions*subdivisions + 2);
+    faceElements.resize(60*(size_t)subdivisions*subdivisions);
+
     // create icosahedron https://en.wikipedia.org/wiki/Regular_icosahedron, https://en.wikipedia.org/wiki/Regular_icosahedron#/media/File:Icosahedron-golden-rectangles.svg
     float phi = (1.0f + sqrt(5.0f))/2;
-    std::vector<glm::vec3> vertices; //vector because more vertices will be added when the mesh is created
-    vertices.push_back(glm::vec3(0.0f,  1.0f,   phi));  //0
-    vertices.push_back(glm::vec3(0.0f,  1.0f,   -phi)); //1
-    vertices.push_back(glm::vec3(0.0f,  -1.0f,  phi));  //2
-    vertices.push_back(glm::vec3(0.0f,  -1.0f,  -phi)); //3
-    vertices.push_back(glm::vec3(phi,   0.0f,   1.0f)); //4
-    vertices.push_back(glm::vec3(-phi,   0.0f,   1.0f));//5
-    vertices.push_back(glm::vec3(phi,  0.0f,   -1.0f)); //6
-    vertices.push_back(glm::vec3(-phi,  0.0f,   -1.0f));//7
-    vertices.push_back(glm::vec3(1.0f,  phi,    0.0f)); //8
-    vertices.push_back(glm::vec3(1.0f,  -phi,   0.0f)); //9
-    vertices.push_back(glm::vec3(-1.0f, phi,    0.0f)); //10
-    vertices.push_back(glm::vec3(-1.0f, -phi,   0.0f)); //11
-    int edges[30][subdivisions+1]; //https://en.wikipedia.org/wiki/Regular_icosahedron#/media/File:Icosahedron-golden-rectangles.svg
-    //edges in order with smallest indexed vertex first - use indicesnnot ponters so can construct an elements array for OpenGL with them
-    //edges across short edges
-    edges[0][0] = 0;    edges[0][subdivisions] = 2;
-    edges[1][0] = 1;    edges[1][subdivisions] = 3;
-    edges[2][0] = 4;    edges[2][subdivisions] = 6;
-    edges[3][0] = 5;    edges[3][subdivisions] = 7;
-    edges[4][0] = 8;    edges[4][subdivisions] = 10;
-    edges[5][0] = 9;    edges[5][subdivisions] = 11;
-    //edges across gaps - each +-1.0 goes to the vertex with a corresponding +-phi coordinate
-    edges[6][0] = 0;    edges[6][subdivisions] = 8;
-    edges[7][0] = 0;    edges[7][subdivisions] = 10;
-    edges[8][0] = 1;    edges[8][subdivisions] = 8;
-    edges[9][0] = 1;    edges[9][subdivisions] = 10;
-    edges[10][0] = 2;   edges[10][subdivisions] = 9;
-    edges[11][0] = 2;   edges[11][subdivisions] = 11;
-    edges[12][0] = 3;   edges[12][subdivisions] = 9;
-    edges[13][0] = 3;   edges[13][subdivisions] = 11;
-    edges[14][0] = 0;   edges[14][subdivisions] = 4;
-    edges[15][0] = 2;   edges[15][subdivisions] = 4;
-    edges[16][0] = 0;   edges[16][subdivisions] = 5;
-    edges[17][0] = 2;   edges[17][subdivisions] = 5;
-    edges[18][0] = 1;   edges[18][subdivisions] = 6;
-    edges[19][0] = 3;   edges[19][subdivisions] = 6;
-    edges[20][0] = 1;   edges[20][subdivisions] = 7;
-    edges[21][0] = 3;   edges[21][subdivisions] = 7;
-    edges[22][0] = 4;   edges[22][subdivisions] = 8;
-    edges[23][0] = 6;   edges[23][subdivisions] = 8;
-    edges[24][0] = 4;   edges[24][subdivisions] = 9;
-    edges[25][0] = 6;   edges[25][subdivisions] = 9;
-    edges[26][0] = 5;   edges[26][subdivisions] = 10;
-    edges[27][0] = 7;   edges[27][subdivisions] = 10;
-    edges[28][0] = 5;   edges[28][subdivisions] = 11;
-    edges[29][0] = 7;   edges[29][subdivisions] = 11;
-    int faces[20][3];
-    //faces in order so edge: 0: (a, b)
-    //                        1: (a, c)
-    //                        2: (b, c)     with a < b < c
-    //faces with a short rectangle edge, if one edge is the short one - the others must be one that connects to the same vertex
-    // eg edges[0] contains 0,2 : and only vertices 4,5 connect to both via an edge eg. edges 0, 14, 15
-    faces[0][0] = 0;    faces[0][1] = 14,   faces[0][2] = 15;
-    faces[1][0] = 0;    faces[1][1] = 16;   faces[1][2] = 17;
-    faces[2][0] = 1;    faces[2][1] = 18;   faces[2][2] = 19;
-    faces[3][0] = 1;    faces[3][1] = 20;   faces[3][2] = 21;
-    faces[4][0] = 2;    faces[4][1] = 22;   faces[4][2] = 23;
-    faces[5][0] = 2;    faces[5][1] = 24;   faces[5][2] = 25;
-    faces[6][0] = 3;    faces[6][1] = 26;   faces[6][2] = 27;
-    faces[7][0] = 3;    faces[7][1] = 28;   faces[7][2] = 29;
-    faces[8][0] = 6;    faces[8][1] = 7;    faces[8][2] = 4;
-    faces[9][0] = 8;    faces[9][1] = 9;    faces[9][2] = 4;
-    faces[10][0] = 10;  faces[10][1] = 11;  faces[10][2] = 5;
-    faces[11][0] = 12;  faces[11][1] = 13;  faces[11][2] = 5;
-    //final 8 faces - consider 1 rectange in image above, in direction of +-1, point 2 has +-phi in same coord and +-1 in other, 
-    //final point has +-phi in same coord as 2nd's +-1 and +-1 in same coord as 1sts +-phi. All +-s must match per coord
-    faces[12][0] = 14; faces[12][1] = 6; faces[12][2] = 22;
-    faces[13][0] = 16; faces[13][1] = 7; faces[13][2] = 26;
-    faces[14][0] = 18; faces[14][1] = 8; faces[14][2] = 23;
-    faces[15][0] = 20; faces[15][1] = 9; faces[15][2] = 27;
-    faces[16][0] = 15; faces[16][1] = 10; faces[16][2] = 24;
-    faces[17][0] = 17; faces[17][1] = 11; faces[17][2] = 28;
-    faces[18][0] = 19; faces[18][1] = 12; faces[18][2] = 25;
-    faces[19][0] = 21; faces[19][1] = 13; faces[19][2] = 29;
+    vertices[0] = glm::vec3(0.0f,  1.0f,   phi);
+    vertices[1] = glm::vec3(0.0f,  1.0f,   -phi);
+    vertices[2] = glm::vec3(0.0f,  -1.0f,  phi);
+    vertices[3] = glm::vec3(0.0f,  -1.0f,  -phi);
+    vertices[4] = glm::vec3(phi,   0.0f,   1.0f);
+    vertices[5] = glm::vec3(-phi,   0.0f,   1.0f);
+    vertices[6] = glm::vec3(phi,  0.0f,   -1.0f);
+    vertices[7] = glm::vec3(-phi,  0.0f,   -1.0f);
+    vertices[8] = glm::vec3(1.0f,  phi,    0.0f);
+    vertices[9] = glm::vec3(1.0f,  -phi,   0.0f);
+    vertices[10] = glm::vec3(-1.0f, phi,    0.0f);
+    vertices[11] = glm::vec3(-1.0f, -phi,   0.0f);
 
     //subdivide each icosohedron edge
-    for (int division = 1; division < subdivisions; division++) {
-        for (int edge = 0; edge < 30; edge++) {
-            glm::vec3 newVector = sceneObjects::createRatioVector(subdivisions, division, vertices[edges[edge][0]], vertices[edges[edge][subdivisions]]);;
-            vertices.push_back(newVector);
-            edges[edge][division] = vertices.size() - 1;
+    SO_ThreadPool& pool = SO_ThreadPool::global();
+    pool.parallelFor(subdivisions - 1, 1024, [&](size_t begin, size_t end) {
+        for (int division = (int)begin + 1; division < (int)end + 1; division++) {
+            for (int edge = 0; edge < 30; edge++) {
+                vertices[layout.edgeVertex(edge, division)] = createRatioVector(subdivisions, division, vertices[icosahedronEdges[edge][0]], vertices[icosahedronEdges[edge][1]]);
+            }
         }
-    }
+    });
 
-    //create inner points on each face
+    //create inner points on each face along with its triangles, a row of faces at a time
     //face has vertices a,b,c a<b<c and edges (a,b), (a,c), (b,c). rows start at row[0] = vertex a and move towards row[subdivision] = edge (b, c)
-    std::vector<int> faceElements;
-    for (int face = 0; face < 20; face++) {
-        std::vector<int> currentRow; // current row of vertices being added
-        std::vector<int> nextRow; // next row of vertices - being created to provide end vertices for faces on currentrow
-        currentRow.push_back(edges[faces[face][0]][0]); // start with current row being just vertex a
-        for (int row = 0; row < subdivisions; row++) { // last row of faces is row[subdivision-1]
-            if (row == subdivisions - 1) { // if final row then should be set equal to the edge (b,c)
-                nextRow.clear();
-                for (int j = 0; j <= subdivisions; j++) {
-                    nextRow.push_back(edges[faces[face][2]][j]);
-                }
-            } else { // if not final row
-                nextRow.clear();
-                nextRow.push_back(edges[faces[face][0]][row+1]); // add first vector from edge (a,b)
-                //add intervening vertices
-                for (int slice = 1; slice < row+1; slice++) { //add subdvision vectors
-                    glm::vec3 newVector = sceneObjects::createRatioVector(row+1, slice, vertices[edges[faces[face][0]][row+1]], vertices[edges[faces[face][1]][row+1]]);
-                    vertices.push_back(newVector);
-                    nextRow.push_back(vertices.size() - 1);
+    //the row-th row of a face holds 2*row + 1 triangles, so the face's triangles before it number row^2
+    pool.parallelFor(20*(size_t)subdivisions, icosphereRowsPerTask(subdivisions), [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++) {
+            int face = (int)(task/subdivisions);
+            int row = (int)(task%subdivisions);
+            int next = row + 1;
+            if (next < subdivisions) { //add subdvision vectors between edges (a,b) and (a,c)
+                const glm::vec3& start = vertices[layout.edgeVertex(icosahedronFaces[face][0], next)];
+                const glm::vec3& finish = vertices[layout.edgeVertex(icosahedronFaces[face][1], next)];
+                for (int slice = 1; slice < next; slice++) {
+                    vertices[layout.rowVertex(face, next, slice)] = createRatioVector(next, slice, start, finish);
                 }
-                nextRow.push_back(edges[faces[face][1]][row+1]); //add final vector from edge (a,c)
             }
-            // add faces to the list
+            int* element = faceElements.data() + 3*((size_t)face*subdivisions*subdivisions + (size_t)row*row);
             for (int j = 0; j <= row; j++) { //add faces with point on currentRow
-                faceElements.push_back(currentRow[j]);
-                faceElements.push_back(nextRow[j]);
-                faceElements.push_back(nextRow[j+1]);
+                element[0] = layout.rowVertex(face, row, j);
+                element[1] = layout.rowVertex(face, next, j);
+                element[2] = layout.rowVertex(face, next, j + 1);
+                element += 3;
             }
             for (int j = 0; j < row; j++) { //add faces with edge on currentRow
-                faceElements.push_back(currentRow[j]);
-                faceElements.push_back(currentRow[j+1]);
-                faceElements.push_back(nextRow[j+1]);
+                element[0] = layout.rowVertex(face, row, j);
+                element[1] = layout.rowVertex(face, row, j + 1);
+                element[2] = layout.rowVertex(face, next, j + 1);
+                element += 3;
             }
-            currentRow = nextRow;
         }
-    }
+    });
 
-    for (unsigned int i =0; i < vertices.size(); i++) {
-        vertices[i] = glm::normalize(vertices[i]);
-    }
+    //normalise - v*(1/sqrt(dot(v, v))) as glm::normalize() computes it, 4 vertices at a time with SSE2
+    pool.parallelFor(vertices.size(), 65536, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#ifdef __SSE2__
+        for (; i + 4 <= end; i += 4) {
+            float* xyz = &vertices[i].x;
+            __m128 a = _mm_loadu_ps(xyz); //x0 y0 z0 x1
+            __m128 b = _mm_loadu_ps(xyz + 4); //y1 z1 x2 y2
+            __m128 c = _mm_loadu_ps(xyz + 8); //z2 x3 y3 z3
+            __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+            __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+            //spread each vertex's factor over its 3 lanes rather than transposing back
+            _mm_storeu_ps(xyz, _mm_mul_ps(a, _mm_shuffle_ps(inverse, inverse, _MM_SHUFFLE(1, 0, 0, 0))));
+            _mm_storeu_ps(xyz + 4, _mm_mul_ps(b, _mm_shuffle_ps(inverse, inverse, _MM_SHUFFLE(2, 2, 1, 1))));
+            _mm_storeu_ps(xyz + 8, _mm_mul_ps(c, _mm_shuffle_ps(inverse, inverse, _MM_SHUFFLE(3, 3, 3, 2))));
+        }
+#endif
+        for (; i < end; i++) {
+            vertices[i] = glm::normalize(vertices[i]);
+        }
+    });
 
-    sceneObjects::SO_MeshData icosphereData;
-    icosphereData.vertices = vertices;
-    icosphereData.faceElements = faceElements;
     return icosphereData;
+}
 
-}
\ No newline at end of file
+//the meshes are held by weak pointer, so a level is freed once nothing uses it - as SO_Heightfield::gridElements() does for its lists
+//a level is built outside the lock, as createIcosphere() runs on the thread pool: the first caller leaves a future in the level's slot,
+//which other callers for that level wait on, so callers for other levels are never held up and a level is never built twice at once
+std::shared_ptr<const sceneObjects::SO_MeshData> sceneObjects::cachedIcosphere(int subdivisions) {
+    if (subdivisions < 1) {
+        throw std::invalid_argument("cachedIcosphere() requires at least 1 subdivision, got " + std::to_string(subdivisions));
+    }
+    typedef std::shared_future<std::shared_ptr<const SO_MeshData>> MeshFuture;
+    struct SO_IcosphereSlot {
+        std::weak_ptr<const SO_MeshData> mesh; ///< The finished mesh
+        MeshFuture building; ///< The mesh while it is being built - invalid otherwise
+    };
+    static std::mutex cacheMutex;
+    static std::map<int, SO_IcosphereSlot> cache;
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    SO_IcosphereSlot& slot = cache[subdivisions];
+    std::shared_ptr<const SO_MeshData> cached = slot.mesh.lock();
+    if (cached) {
+        return cached;
+    }
+    if (slot.building.valid()) {
+        MeshFuture building = slot.building;
+        lock.unlock();
+        return building.get();
+    }
+    std::promise<std::shared_ptr<const SO_MeshData>> built;
+    slot.building = built.get_future().share();
+    lock.unlock();
+
+    //map entries are never erased, so `slot` stays valid while the lock is released
+    try {
+        cached = std::make_shared<const SO_MeshData>(createIcosphere(subdivisions));
+    } catch (...) {
+        built.set_exception(std::current_exception());
+        lock.lock();
+        slot.building = MeshFuture();
+        throw;
+    }
+    built.set_value(cached);
+    lock.lock();
+    slot.mesh = cached;
+    slot.building = MeshFuture();
+    return cached;
+}
+
+//one pair of buffers per level - only touched on the OpenGL thread, so needs no lock
+std::shared_ptr<const sceneObjects::SO_IcosphereBuffers> sceneObjects::icosphereBuffers(int subdivisions) {
+    static std::map<int, std::weak_ptr<const SO_IcosphereBuffers>> buffers;
+    std::shared_ptr<const SO_IcosphereBuffers> cached = buffers[subdivisions].lock();
+    if (cached) {
+        return cached;
+    }
+    std::shared_ptr<const SO_MeshData> mesh = cachedIcosphere(subdivisions);
+    SO_IcosphereBuffers* created = new SO_IcosphereBuffers;
+    created->mesh = mesh;
+    created->elementCount = (GLsizei)created->mesh->faceElements.size();
+    glGenBuffers(1, &created->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, created->vbo);
+    glBufferData(GL_ARRAY_BUFFER, created->mesh->vertices.size()*sizeof(glm::vec3), created->mesh->vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &created->ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, created->ebo); //not the element binding, which would attach it to whichever VAO is bound
+    glBufferData(GL_COPY_WRITE_BUFFER, created->mesh->faceElements.size()*sizeof(int), created->mesh->faceElements.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    cached = std::shared_ptr<const SO_IcosphereBuffers>(created, [](const SO_IcosphereBuffers* deleted) {
+        glDeleteBuffers(1, &deleted->vbo);
+        glDeleteBuffers(1, &deleted->ebo);
+        delete deleted;
+    });
+    buffers[subdivisions] = cached;
+    return cached;
+}
@@ -0,0 +1,880 @@
+/** \file noiseFunctions.cpp */
+#include "sceneObjects.hpp"
+#include "noiseKernels.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+/// The instruction sets the noise kernels are built for, best last
+enum SO_NoiseISA {
+    SO_NOISE_SCALAR,
+    SO_NOISE_SSE42,
+    SO_NOISE_AVX2
+};
+
+//detect the best kernel the CPU can run - checked once and cached
+SO_NoiseISA noiseISA(void) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    static const SO_NoiseISA isa = __builtin_cpu_supports("avx2") ? SO_NOISE_AVX2 :
+                                   __builtin_cpu_supports("sse4.2") ? SO_NOISE_SSE42 : SO_NOISE_SCALAR;
+    return isa;
+#else
+    return SO_NOISE_SCALAR;
+#endif
+}
+
+/// single lane "vector" traits, so the scalar noise functions share the lane kernels' code and give the same results
+template <typename T> struct ScalarLanes {
+    static const int width = 1;
+    typedef T Scalar;
+    typedef T Real;
+    typedef int Int;
+
+    static Real load(const T* p) { return *p; }
+    static void store(T* p, Real a) { *p = a; }
+    static Real set1(T a) { return a; }
+    static Real add(Real a, Real b) { return a + b; }
+    static Real sub(Real a, Real b) { return a - b; }
+    static Real mul(Real a, Real b) { return a * b; }
+    static Real div(Real a, Real b) { return a / b; }
+    static Real floor(Real a) { return std::floor(a); }
+    /// goes through memory since some optimisers vectorise neighbouring lattice axes together and drop a plain (T)(float) round trip
+    static Real roundToFloat(Real a) {
+        volatile float rounded = (float)a;
+        return rounded;
+    }
+    static Int truncToInt(Real a) { return (int)a; }
+    static Real toReal(Int a) { return (T)a; }
+    static Real min(Real a, Real b) { return b < a ? b : a; }
+    static Real max(Real a, Real b) { return a < b ? b : a; }
+    static Real sqrt(Real a) { return std::sqrt(a); }
+    static Real step(Real edge, Real a) { return (T)(a >= edge); }
+
+    static Int set1i(int a) { return a; }
+    static Int addi(Int a, Int b) { return a + b; }
+    static Int andi(Int a, Int b) { return a & b; }
+    template <typename P> static Int gather(const P* table, Int index) { return table[index]; }
+
+    static Real grad(Int hash, Real x, Real y, Real z) { return sceneObjects::grad<T>(hash, x, y, z); }
+    /// the gradients of the 4D simplex noise - three of x/y/z/w with the signs given by the low bits of the hash
+    static Real grad4(Int hash, Real x, Real y, Real z, Real w) {
+        int h = hash & 0x1F;
+        T a = h < 24 ? x : y;
+        T b = h < 16 ? y : z;
+        T c = h < 8 ? z : w;
+        return ((h & 1) ? -a : a) + ((h & 2) ? -b : b) + ((h & 4) ? -c : c);
+    }
+};
+
+}
+
+//get perlin noise at count coords (x[i],y[i],z[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            perlinBatchAVX2<T, P>(perms, x, y, z, out, count, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            perlinBatchSSE42<T, P>(perms, x, y, z, out, count, repeat);
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = perlinTable<T, P>(perms, x[i], y[i], z[i], repeat);
+            }
+    }
+}
+
+template void sceneObjects::noiseKernels::perlinBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+template void sceneObjects::noiseKernels::perlinBatchTable<double, unsigned char>(const unsigned char* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinBatchTable<float, unsigned char>(const unsigned char* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+
+void sceneObjects::perlinBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat) {
+    noiseKernels::perlinBatchTable<double, int>(perlinPerms, x, y, z, out, count, repeat);
+}
+
+void sceneObjects::perlinBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat) {
+    noiseKernels::perlinBatchTable<float, int>(perlinPerms, x, y, z, out, count, repeat);
+}
+
+//get perlin noise and its gradient at count coords (x[i],y[i],z[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinDerivativeBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out,
+                                                                                             T* gradX, T* gradY, T* gradZ, size_t count, T repeat) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            perlinDerivativeBatchAVX2<T, P>(perms, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            perlinDerivativeBatchSSE42<T, P>(perms, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < count; i++) {
+                T gradient[3];
+                out[i] = perlinDerivativeTable<T, P>(perms, x[i], y[i], z[i], repeat, gradient);
+                gradX[i] = gradient[0];
+                gradY[i] = gradient[1];
+                gradZ[i] = gradient[2];
+            }
+    }
+}
+
+template void sceneObjects::noiseKernels::perlinDerivativeBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out,
+                                                                                 double* gradX, double* gradY, double* gradZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out,
+                                                                                float* gradX, float* gradY, float* gradZ, size_t count, float repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchTable<double, unsigned char>(const unsigned char* perms, const double* x, const double* y, const double* z, double* out,
+                                                                                           double* gradX, double* gradY, double* gradZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchTable<float, unsigned char>(const unsigned char* perms, const float* x, const float* y, const float* z, float* out,
+                                                                                          float* gradX, float* gradY, float* gradZ, size_t count, float repeat);
+
+void sceneObjects::perlinDerivativeBatch(const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat) {
+    noiseKernels::perlinDerivativeBatchTable<double, int>(perlinPerms, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+}
+
+void sceneObjects::perlinDerivativeBatch(const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat) {
+    noiseKernels::perlinDerivativeBatchTable<float, int>(perlinPerms, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+}
+
+//get channels channels of perlin noise at count coords (x[i],y[i],z[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinChannelsBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, int channels, T repeat) {
+    if (channels < 1 || channels > 256) {
+        throw std::invalid_argument("perlinChannels can produce between 1 and 256 channels");
+    }
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            perlinChannelsBatchAVX2<T, P>(perms, x, y, z, out, count, channels, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            perlinChannelsBatchSSE42<T, P>(perms, x, y, z, out, count, channels, repeat);
+            return;
+#endif
+        default:
+            perlinChannelsBatchKernel<ScalarLanes<T> >(perms, x, y, z, out, count, channels, repeat);
+    }
+}
+
+//get curl noise at count coords (x[i],y[i],z[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::curlNoiseBatchTable(const P* perms, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, T repeat) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            curlNoiseBatchAVX2<T, P>(perms, x, y, z, outX, outY, outZ, count, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            curlNoiseBatchSSE42<T, P>(perms, x, y, z, outX, outY, outZ, count, repeat);
+            return;
+#endif
+        default:
+            curlNoiseBatchKernel<ScalarLanes<T> >(perms, x, y, z, outX, outY, outZ, count, repeat);
+    }
+}
+
+template void sceneObjects::noiseKernels::perlinChannelsBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, int channels, double repeat);
+template void sceneObjects::noiseKernels::perlinChannelsBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, int channels, float repeat);
+template void sceneObjects::noiseKernels::curlNoiseBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, double* outX, double* outY, double* outZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::curlNoiseBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count, float repeat);
+
+//get channels channels of perlin noise at coords (x,y,z) from one walk of the lattice
+void sceneObjects::perlinChannels(double x, double y, double z, double repeat, double* out, int channels) {
+    if (channels < 1 || channels > 256) {
+        throw std::invalid_argument("perlinChannels can produce between 1 and 256 channels");
+    }
+    noiseKernels::perlinChannelsBatchKernel<ScalarLanes<double> >(perlinPerms, &x, &y, &z, out, 1, channels, repeat);
+}
+
+void sceneObjects::perlinChannelsBatch(const double* x, const double* y, const double* z, double* out, size_t count, int channels, double repeat) {
+    noiseKernels::perlinChannelsBatchTable<double, int>(perlinPerms, x, y, z, out, count, channels, repeat);
+}
+
+void sceneObjects::perlinChannelsBatch(const float* x, const float* y, const float* z, float* out, size_t count, int channels, float repeat) {
+    noiseKernels::perlinChannelsBatchTable<float, int>(perlinPerms, x, y, z, out, count, channels, repeat);
+}
+
+//get the curl of the vector potential made of perlin noise channels 0, 1 and 2 at coords (x,y,z)
+glm::dvec3 sceneObjects::curlNoise(double x, double y, double z, double repeat) {
+    glm::dvec3 curl;
+    noiseKernels::curlNoiseBatchKernel<ScalarLanes<double> >(perlinPerms, &x, &y, &z, &curl.x, &curl.y, &curl.z, 1, repeat);
+    return curl;
+}
+
+void sceneObjects::curlNoiseBatch(const double* x, const double* y, const double* z, double* outX, double* outY, double* outZ, size_t count, double repeat) {
+    noiseKernels::curlNoiseBatchTable<double, int>(perlinPerms, x, y, z, outX, outY, outZ, count, repeat);
+}
+
+void sceneObjects::curlNoiseBatch(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count, float repeat) {
+    noiseKernels::curlNoiseBatchTable<float, int>(perlinPerms, x, y, z, outX, outY, outZ, count, repeat);
+}
+
+//get 2D perlin noise at count coords (x[i],y[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::perlin2DBatchTable(const P* perms, const T* x, const T* y, T* out, size_t count, T repeat) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            perlin2DBatchAVX2<T, P>(perms, x, y, out, count, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            perlin2DBatchSSE42<T, P>(perms, x, y, out, count, repeat);
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = perlin2DTable<T, P>(perms, x[i], y[i], repeat);
+            }
+    }
+}
+
+template void sceneObjects::noiseKernels::perlin2DBatchTable<double, int>(const int* perms, const double* x, const double* y, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlin2DBatchTable<float, int>(const int* perms, const float* x, const float* y, float* out, size_t count, float repeat);
+
+void sceneObjects::perlin2DBatch(const double* x, const double* y, double* out, size_t count, double repeat) {
+    noiseKernels::perlin2DBatchTable<double, int>(perlinPerms, x, y, out, count, repeat);
+}
+
+void sceneObjects::perlin2DBatch(const float* x, const float* y, float* out, size_t count, float repeat) {
+    noiseKernels::perlin2DBatchTable<float, int>(perlinPerms, x, y, out, count, repeat);
+}
+
+//get 3D simplex noise at count coords (x[i],y[i],z[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::simplexBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            simplexBatchAVX2<T, P>(perms, x, y, z, out, count, repeat);
+            return;
+        case SO_NOISE_SSE42:
+            simplexBatchSSE42<T, P>(perms, x, y, z, out, count, repeat);
+            return;
+#endif
+        default:
+            simplex3BatchKernel<ScalarLanes<T> >(perms, x, y, z, out, count, repeat);
+    }
+}
+
+//get 4D simplex noise at count coords (x[i],y[i],z[i],w[i]) with the best kernel the CPU supports
+template <typename T, typename P> void sceneObjects::noiseKernels::simplex4DBatchTable(const P* perms, const T* x, const T* y, const T* z, const T* w, T* out, size_t count) {
+    switch (noiseISA()) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        case SO_NOISE_AVX2:
+            simplex4DBatchAVX2<T, P>(perms, x, y, z, w, out, count);
+            return;
+        case SO_NOISE_SSE42:
+            simplex4DBatchSSE42<T, P>(perms, x, y, z, w, out, count);
+            return;
+#endif
+        default:
+            simplex4BatchKernel<ScalarLanes<T> >(perms, x, y, z, w, out, count);
+    }
+}
+
+template void sceneObjects::noiseKernels::simplexBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::simplexBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+template void sceneObjects::noiseKernels::simplex4DBatchTable<double, int>(const int* perms, const double* x, const double* y, const double* z, const double* w, double* out, size_t count);
+template void sceneObjects::noiseKernels::simplex4DBatchTable<float, int>(const int* perms, const float* x, const float* y, const float* z, const float* w, float* out, size_t count);
+
+namespace {
+
+//gradient directions of sceneObjects::grad() as coefficients of x, y and z - lets simplex() and the grid loops avoid grad()'s unpredictable switch
+const double gradX[16] = { 1, -1,  1, -1,  1, -1,  1, -1,  0,  0,  0,  0,  1,  0, -1,  0};
+const double gradY[16] = { 1,  1, -1, -1,  0,  0,  0,  0,  1, -1,  1, -1,  1, -1,  1, -1};
+const double gradZ[16] = { 0,  0,  0,  0,  1,  1, -1, -1,  1,  1, -1, -1,  0,  1,  0, -1};
+
+//floor() without the library call - exact for any value an int can hold, which the lattice coordinates already need to be
+inline double simplexFloor(double a) {
+    double truncated = (double)(long long)a;
+    return truncated > a ? truncated - 1 : truncated;
+}
+
+//the contribution of the scalar simplex() corner with lattice coordinates a, b, c and position vx, vy, vz to the point at offset x, y, z from it
+//the same sum as simplexVertex3Lanes, but corners too far away to contribute return before touching the permutation table
+inline double simplexVertex3(double a, double b, double c, double vx, double vy, double vz, double x, double y, double z, double repeat) {
+    double t = 0.5 - (x*x + y*y + z*z);
+    if (t <= 0) {
+        return 0;
+    }
+    if (repeat > 0) { // hash the copy of the corner inside [0, repeat), as simplexVertex3Lanes does
+        double shiftX = (vx < 0) - (vx >= repeat);
+        double shiftY = (vy < 0) - (vy >= repeat);
+        double shiftZ = (vz < 0) - (vz >= repeat);
+        a += repeat*(shiftY + shiftZ);
+        b += repeat*(shiftX + shiftZ);
+        c += repeat*(shiftX + shiftY);
+    }
+    int hash = sceneObjects::perlinPerms[sceneObjects::perlinPerms[sceneObjects::perlinPerms[(int)a & 255] + ((int)b & 255)] + ((int)c & 255)] & 15;
+    return t*t*t*(gradX[hash]*x + gradY[hash]*y + gradZ[hash]*z);
+}
+
+//gradient directions of ScalarLanes::grad4() as coefficients of x, y, z and w
+const double grad4X[32] = { 1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  0,  0,  0,  0,  0,  0,  0,  0};
+const double grad4Y[32] = { 1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  1, -1,  1, -1,  1, -1,  1, -1};
+const double grad4Z[32] = { 1,  1,  1,  1, -1, -1, -1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1};
+const double grad4W[32] = { 0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1, -1, -1, -1, -1,  1,  1,  1,  1, -1, -1, -1, -1,  1,  1,  1,  1, -1, -1, -1, -1};
+
+//the contribution of the scalar simplex4D() corner with wrapped lattice coordinates a, b, c, d at offset x, y, z, w from the point
+//the same sum as simplexCorner4Lanes, but corners too far away to contribute return before touching the permutation table
+inline double simplexVertex4(int a, int b, int c, int d, double x, double y, double z, double w) {
+    double t = 0.5 - ((x*x + y*y) + (z*z + w*w));
+    if (t <= 0) {
+        return 0;
+    }
+    t *= t;
+    const int* perms = sceneObjects::perlinPerms;
+    int hash = perms[a + perms[b + perms[c + perms[d]]]] & 0x1F;
+    return t*t*(((grad4X[hash]*x + grad4Y[hash]*y) + grad4Z[hash]*z) + grad4W[hash]*w);
+}
+
+}
+
+//get 3D simplex noise at coords (x,y,z) - a branching scalar form of simplex3Lanes, which gives the same results
+double sceneObjects::simplex(double x, double y, double z, double repeat) {
+    if (repeat > 0) { // modulus(), inlined
+        x -= repeat*simplexFloor(x/repeat);
+        y -= repeat*simplexFloor(y/repeat);
+        z -= repeat*simplexFloor(z/repeat);
+    }
+
+    double u = y + z;
+    double v = x + z;
+    double w = x + y;
+    double iu = simplexFloor(u);
+    double iv = simplexFloor(v);
+    double iw = simplexFloor(w);
+    double fu = u - iu;
+    double fv = v - iv;
+    double fw = w - iw;
+
+    // which of the 6 tetrahedra in the cell the point is in, as the lattice offsets of its second and third corners
+    bool g1 = fu > fw, g2 = fv >= fu, g3 = fw >= fv;
+    bool l1 = fu > fv, l2 = fv > fw, l3 = fw >= fu;
+    double o1u = g1 && l1, o1v = g2 && l2, o1w = g3 && l3;
+    double o2u = g1 || l1, o2v = g2 || l2, o2w = g3 || l3;
+
+    // the corners' positions - the lattice point (a, b, c) is at ((b+c-a)/2, (a+c-b)/2, (a+b-c)/2)
+    double x0 = (iv + iw - iu)*0.5;
+    double y0 = (iu + iw - iv)*0.5;
+    double z0 = (iu + iv - iw)*0.5;
+    double x1 = x0 + (o1v + o1w - o1u)*0.5;
+    double y1 = y0 + (o1u + o1w - o1v)*0.5;
+    double z1 = z0 + (o1u + o1v - o1w)*0.5;
+    double x2 = x0 + (o2v + o2w - o2u)*0.5;
+    double y2 = y0 + (o2u + o2w - o2v)*0.5;
+    double z2 = z0 + (o2u + o2v - o2w)*0.5;
+    double x3 = x0 + 0.5;
+    double y3 = y0 + 0.5;
+    double z3 = z0 + 0.5;
+
+    double n = simplexVertex3(iu, iv, iw, x0, y0, z0, x - x0, y - y0, z - z0, repeat);
+    n += simplexVertex3(iu + o1u, iv + o1v, iw + o1w, x1, y1, z1, x - x1, y - y1, z - z1, repeat);
+    n += simplexVertex3(iu + o2u, iv + o2v, iw + o2w, x2, y2, z2, x - x2, y - y2, z - z2, repeat);
+    n += simplexVertex3(iu + 1, iv + 1, iw + 1, x3, y3, z3, x - x3, y - y3, z - z3, repeat);
+
+    // scaled so the result spans [0, 1] like perlin()
+    return (n*noiseKernels::simplex3Scale + 1)*0.5;
+}
+
+//get 4D simplex noise at coords (x,y,z,w) - a branching scalar form of simplex4Lanes, which gives the same results
+double sceneObjects::simplex4D(double x, double y, double z, double w) {
+    double s = ((x + y) + (z + w))*noiseKernels::simplex4Skew;
+    double i = simplexFloor(x + s);
+    double j = simplexFloor(y + s);
+    double k = simplexFloor(z + s);
+    double l = simplexFloor(w + s);
+    double t = ((i + j) + (k + l))*noiseKernels::simplex4Unskew;
+    double x0 = x - (i - t);
+    double y0 = y - (j - t);
+    double z0 = z - (k - t);
+    double w0 = w - (l - t);
+
+    // rank each axis by how far the point is along it - the simplex steps along the highest ranked axis first
+    int rankX = 0, rankY = 0, rankZ = 0, rankW = 0;
+    (x0 >= y0 ? rankX : rankY)++;
+    (x0 >= z0 ? rankX : rankZ)++;
+    (x0 >= w0 ? rankX : rankW)++;
+    (y0 >= z0 ? rankY : rankZ)++;
+    (y0 >= w0 ? rankY : rankW)++;
+    (z0 >= w0 ? rankZ : rankW)++;
+
+    int ii = (int)i & 255;
+    int jj = (int)j & 255;
+    int kk = (int)k & 255;
+    int ll = (int)l & 255;
+    double n = 0;
+    for (int corner = 0; corner < 5; corner++) {
+        // corner c steps along the axes ranked at least 4-c, and is c*unskew further from the skewed origin
+        int oi = rankX >= 4 - corner, oj = rankY >= 4 - corner, ok = rankZ >= 4 - corner, ol = rankW >= 4 - corner;
+        double shift = corner*noiseKernels::simplex4Unskew;
+        n += simplexVertex4(ii + oi, jj + oj, kk + ok, ll + ol, (x0 - oi) + shift, (y0 - oj) + shift, (z0 - ok) + shift, (w0 - ol) + shift);
+    }
+
+    // scaled so the result spans [0, 1] like perlin()
+    return (n*noiseKernels::simplex4Scale + 1)*0.5;
+}
+
+void sceneObjects::simplexBatch(const double* x, const double* y, const double* z, double* out, size_t count, double repeat) {
+    noiseKernels::simplexBatchTable<double, int>(perlinPerms, x, y, z, out, count, repeat);
+}
+
+void sceneObjects::simplexBatch(const float* x, const float* y, const float* z, float* out, size_t count, float repeat) {
+    noiseKernels::simplexBatchTable<float, int>(perlinPerms, x, y, z, out, count, repeat);
+}
+
+void sceneObjects::simplex4DBatch(const double* x, const double* y, const double* z, const double* w, double* out, size_t count) {
+    noiseKernels::simplex4DBatchTable<double, int>(perlinPerms, x, y, z, w, out, count);
+}
+
+void sceneObjects::simplex4DBatch(const float* x, const float* y, const float* z, const float* w, float* out, size_t count) {
+    noiseKernels::simplex4DBatchTable<float, int>(perlinPerms, x, y, z, w, out, count);
+}
+
+namespace {
+
+//the same for noiseKernels::grad2()
+const double grad2X[8] = { 1, -1,  1, -1,  1, -1,  0,  0};
+const double grad2Y[8] = { 1,  1, -1, -1,  0,  0,  1, -1};
+
+/// The lattice data for every sample along one axis of a grid - the part of perlin() which only depends on that coordinate
+struct SO_PerlinAxis {
+    std::vector<int> index; ///< the lattice cell of each sample
+    std::vector<int> indexInc; ///< inc() of the lattice cell
+    std::vector<double> frac; ///< the position of each sample within its cell
+    std::vector<float> weight; ///< the faded position, rounded to float as lerp() would
+};
+
+//fill in the lattice data for coordinates origin + i*step, i = 0..count-1, exactly as perlin() computes them
+SO_PerlinAxis perlinAxis(double origin, double step, int count, double repeat) {
+    SO_PerlinAxis axis;
+    axis.index.resize(count);
+    axis.indexInc.resize(count);
+    axis.frac.resize(count);
+    axis.weight.resize(count);
+    for (int i = 0; i < count; i++) {
+        double coord = origin + i*step;
+        if (repeat > 0) {
+            coord = sceneObjects::modulus(coord, repeat);
+        }
+        coord = sceneObjects::modulus(coord, 256);
+        axis.index[i] = (int)coord & 255;
+        axis.indexInc[i] = sceneObjects::inc(axis.index[i], repeat);
+        axis.frac[i] = coord - (int)coord;
+        axis.weight[i] = (float)sceneObjects::fade(axis.frac[i]);
+    }
+    return axis;
+}
+
+//fill out[i + j*width + k*width*height] for i in [iStart, iEnd), j in [jStart, jEnd), k in [kStart, kEnd)
+//the 8 corner hashes and the y/z part of each corner gradient are only recomputed when a row crosses into a new lattice cell
+template <typename P> void perlinGridBlock(const P* perms, const SO_PerlinAxis& xAxis, const SO_PerlinAxis& yAxis, const SO_PerlinAxis& zAxis, double* out, int width, int height,
+                     int iStart, int iEnd, int jStart, int jEnd, int kStart, int kEnd) {
+    for (int k = kStart; k < kEnd; k++) {
+        int zi = zAxis.index[k], zi1 = zAxis.indexInc[k];
+        double zf = zAxis.frac[k];
+        float w = zAxis.weight[k];
+        for (int j = jStart; j < jEnd; j++) {
+            int yi = yAxis.index[j], yi1 = yAxis.indexInc[j];
+            double yf = yAxis.frac[j];
+            float v = yAxis.weight[j];
+            double* row = out + (size_t)k*width*height + (size_t)j*width;
+
+            int cell = -1;
+            int hashes[8];
+            double partials[8]; //the y and z terms of each corner's gradient dot product
+            for (int i = iStart; i < iEnd; i++) {
+                if (xAxis.index[i] != cell) {
+                    cell = xAxis.index[i];
+                    int a = perms[cell], b = perms[xAxis.indexInc[i]];
+                    int aa = perms[a + yi], ab = perms[a + yi1], ba = perms[b + yi], bb = perms[b + yi1];
+                    hashes[0] = perms[aa + zi] & 0xF; //aaa
+                    hashes[1] = perms[ba + zi] & 0xF; //baa
+                    hashes[2] = perms[ab + zi] & 0xF; //aba
+                    hashes[3] = perms[bb + zi] & 0xF; //bba
+                    hashes[4] = perms[aa + zi1] & 0xF; //aab
+                    hashes[5] = perms[ba + zi1] & 0xF; //bab
+                    hashes[6] = perms[ab + zi1] & 0xF; //abb
+                    hashes[7] = perms[bb + zi1] & 0xF; //bbb
+                    for (int c = 0; c < 8; c++) { //corner c is offset by (c&1, (c>>1)&1, (c>>2)&1)
+                        partials[c] = gradY[hashes[c]]*(c & 2 ? yf - 1 : yf) + gradZ[hashes[c]]*(c & 4 ? zf - 1 : zf);
+                    }
+                }
+                double xf = xAxis.frac[i];
+                double xf1 = xf - 1;
+                float u = xAxis.weight[i];
+                //at most two of the gradient coefficients are non-zero so adding the x term last gives the same result as grad()
+                double x1 = sceneObjects::lerp(gradX[hashes[0]]*xf + partials[0], gradX[hashes[1]]*xf1 + partials[1], u);
+                double x2 = sceneObjects::lerp(gradX[hashes[2]]*xf + partials[2], gradX[hashes[3]]*xf1 + partials[3], u);
+                double y1 = sceneObjects::lerp(x1, x2, v);
+                x1 = sceneObjects::lerp(gradX[hashes[4]]*xf + partials[4], gradX[hashes[5]]*xf1 + partials[5], u);
+                x2 = sceneObjects::lerp(gradX[hashes[6]]*xf + partials[6], gradX[hashes[7]]*xf1 + partials[7], u);
+                double y2 = sceneObjects::lerp(x1, x2, v);
+                row[i] = (sceneObjects::lerp(y1, y2, w) + 1)/2;
+            }
+        }
+    }
+}
+
+//fill out[i + j*width] for i in [iStart, iEnd), j in [jStart, jEnd) with 2D perlin noise
+//the 4 corner hashes and the y part of each corner gradient are only recomputed when a row crosses into a new lattice cell
+template <typename P> void perlin2DGridBlock(const P* perms, const SO_PerlinAxis& xAxis, const SO_PerlinAxis& yAxis, double* out, int width,
+                                             int iStart, int iEnd, int jStart, int jEnd) {
+    for (int j = jStart; j < jEnd; j++) {
+        int yi = yAxis.index[j], yi1 = yAxis.indexInc[j];
+        double yf = yAxis.frac[j];
+        float v = yAxis.weight[j];
+        double* row = out + (size_t)j*width;
+
+        int cell = -1;
+        int hashes[4];
+        double partials[4]; //the y term of each corner's gradient dot product
+        for (int i = iStart; i < iEnd; i++) {
+            if (xAxis.index[i] != cell) {
+                cell = xAxis.index[i];
+                int a = perms[cell], b = perms[xAxis.indexInc[i]];
+                hashes[0] = perms[a + yi] & 0x7; //aa
+                hashes[1] = perms[b + yi] & 0x7; //ba
+                hashes[2] = perms[a + yi1] & 0x7; //ab
+                hashes[3] = perms[b + yi1] & 0x7; //bb
+                for (int c = 0; c < 4; c++) { //corner c is offset by (c&1, (c>>1)&1)
+                    partials[c] = grad2Y[hashes[c]]*(c & 2 ? yf - 1 : yf);
+                }
+            }
+            double xf = xAxis.frac[i];
+            double xf1 = xf - 1;
+            float u = xAxis.weight[i];
+            double x1 = sceneObjects::lerp(grad2X[hashes[0]]*xf + partials[0], grad2X[hashes[1]]*xf1 + partials[1], u);
+            double x2 = sceneObjects::lerp(grad2X[hashes[2]]*xf + partials[2], grad2X[hashes[3]]*xf1 + partials[3], u);
+            row[i] = (sceneObjects::lerp(x1, x2, v) + 1)/2;
+        }
+    }
+}
+
+}
+
+//fill a width x height x depth grid of perlin noise - either directly or cut into tiles of about grainSize samples (whole rows where possible)
+//which are run on the library thread pool and share the precomputed axes
+template <typename P> void sceneObjects::noiseKernels::perlinGridTable(const P* perms, double* out, int width, int height, int depth, double x0, double y0, double z0,
+                                                                      double dx, double dy, double dz, double repeat, size_t grainSize) {
+    if (width <= 0 || height <= 0 || depth <= 0) {
+        return;
+    }
+    SO_PerlinAxis xAxis = perlinAxis(x0, dx, width, repeat);
+    SO_PerlinAxis yAxis = perlinAxis(y0, dy, height, repeat);
+    SO_PerlinAxis zAxis = perlinAxis(z0, dz, depth, repeat);
+    if (grainSize == 0) {
+        perlinGridBlock(perms, xAxis, yAxis, zAxis, out, width, height, 0, width, 0, height, 0, depth);
+        return;
+    }
+
+    int tileWidth = grainSize < (size_t)width ? (int)grainSize : width;
+    int tileHeight = grainSize/tileWidth < (size_t)height ? (int)(grainSize/tileWidth) : height;
+    int tilesX = (width + tileWidth - 1)/tileWidth;
+    int tilesY = (height + tileHeight - 1)/tileHeight;
+    SO_ThreadPool::global().parallelFor((size_t)tilesX*tilesY*depth, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++) {
+            int i = (tile % tilesX)*tileWidth;
+            int j = ((tile/tilesX) % tilesY)*tileHeight;
+            int k = tile/((size_t)tilesX*tilesY);
+            int iEnd = i + tileWidth < width ? i + tileWidth : width;
+            int jEnd = j + tileHeight < height ? j + tileHeight : height;
+            perlinGridBlock(perms, xAxis, yAxis, zAxis, out, width, height, i, iEnd, j, jEnd, k, k + 1);
+        }
+    });
+}
+
+template void sceneObjects::noiseKernels::perlinGridTable<int>(const int* perms, double* out, int width, int height, int depth, double x0, double y0, double z0,
+                                                              double dx, double dy, double dz, double repeat, size_t grainSize);
+template void sceneObjects::noiseKernels::perlinGridTable<unsigned char>(const unsigned char* perms, double* out, int width, int height, int depth, double x0, double y0, double z0,
+                                                                        double dx, double dy, double dz, double repeat, size_t grainSize);
+
+//fill a width x height grid of perlin noise on the plane at z
+void sceneObjects::perlinGrid2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat) {
+    noiseKernels::perlinGridTable(perlinPerms, out, width, height, 1, x0, y0, z, dx, dy, 0, repeat, 0);
+}
+
+//fill a width x height x depth grid of perlin noise
+void sceneObjects::perlinGrid3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat) {
+    noiseKernels::perlinGridTable(perlinPerms, out, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, 0);
+}
+
+//fill a width x height grid of perlin noise on the plane at z using the library thread pool
+void sceneObjects::perlinGridParallel2D(double* out, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat, size_t grainSize) {
+    noiseKernels::perlinGridTable(perlinPerms, out, width, height, 1, x0, y0, z, dx, dy, 0, repeat, grainSize == 0 ? 1 : grainSize);
+}
+
+//fill a width x height x depth grid of perlin noise using the library thread pool
+void sceneObjects::perlinGridParallel3D(double* out, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat, size_t grainSize) {
+    noiseKernels::perlinGridTable(perlinPerms, out, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, grainSize == 0 ? 1 : grainSize);
+}
+
+//fill a width x height grid of 2D perlin noise - either directly or in tiles of about grainSize samples on the library thread pool, as perlinGridTable
+template <typename P> void sceneObjects::noiseKernels::perlin2DGridTable(const P* perms, double* out, int width, int height, double x0, double y0,
+                                                                        double dx, double dy, double repeat, size_t grainSize) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    SO_PerlinAxis xAxis = perlinAxis(x0, dx, width, repeat);
+    SO_PerlinAxis yAxis = perlinAxis(y0, dy, height, repeat);
+    if (grainSize == 0) {
+        perlin2DGridBlock(perms, xAxis, yAxis, out, width, 0, width, 0, height);
+        return;
+    }
+
+    int tileWidth = grainSize < (size_t)width ? (int)grainSize : width;
+    int tileHeight = grainSize/tileWidth < (size_t)height ? (int)(grainSize/tileWidth) : height;
+    int tilesX = (width + tileWidth - 1)/tileWidth;
+    int tilesY = (height + tileHeight - 1)/tileHeight;
+    SO_ThreadPool::global().parallelFor((size_t)tilesX*tilesY, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++) {
+            int i = (tile % tilesX)*tileWidth;
+            int j = (tile/tilesX)*tileHeight;
+            int iEnd = i + tileWidth < width ? i + tileWidth : width;
+            int jEnd = j + tileHeight < height ? j + tileHeight : height;
+            perlin2DGridBlock(perms, xAxis, yAxis, out, width, i, iEnd, j, jEnd);
+        }
+    });
+}
+
+template void sceneObjects::noiseKernels::perlin2DGridTable<int>(const int* perms, double* out, int width, int height, double x0, double y0,
+                                                                double dx, double dy, double repeat, size_t grainSize);
+
+//fill a width x height grid of 2D perlin noise
+void sceneObjects::perlin2DGrid(double* out, int width, int height, double x0, double y0, double dx, double dy, double repeat) {
+    noiseKernels::perlin2DGridTable(perlinPerms, out, width, height, x0, y0, dx, dy, repeat, 0);
+}
+
+//fill a width x height grid of 2D perlin noise using the library thread pool
+void sceneObjects::perlin2DGridParallel(double* out, int width, int height, double x0, double y0, double dx, double dy, double repeat, size_t grainSize) {
+    noiseKernels::perlin2DGridTable(perlinPerms, out, width, height, x0, y0, dx, dy, repeat, grainSize == 0 ? 1 : grainSize);
+}
+
+namespace {
+
+//the offset of the feature point of the cell with hash `hash` from the cell's corner along `axis` - (perms[hash + axis] + 0.5)/256
+template <typename T, typename P> inline T worleyJitter(const P* perms, int hash, int axis) {
+    return ((T)perms[hash + axis] + (T)0.5)*(T)(1.0/256);
+}
+
+//fold the squared distance of one feature point into the nearest and second nearest
+template <typename T> inline void worleyInsert(T distance, T& nearest, T& second) {
+    second = std::min(second, std::max(nearest, distance));
+    nearest = std::min(nearest, distance);
+}
+
+//get the distances to the nearest and second nearest feature points. Each cell holds one feature point, placed by the same nested
+//table lookups that hash perlin()'s corners, so only the 27 cells around the point's own cell are visited and the lookups of the
+//x and y prefixes are shared between them.
+template <typename T, class W, typename P> void worleyDistances(const P* perms, T x, T y, T z, const W& wrap, T& f1, T& f2) {
+    typedef ScalarLanes<T> V;
+    int xi[3], yi[3], zi[3];
+    T xf, yf, zf;
+    sceneObjects::noiseKernels::cellLanes<V>(x, wrap, xi[1], xf);
+    sceneObjects::noiseKernels::cellLanes<V>(y, wrap, yi[1], yf);
+    sceneObjects::noiseKernels::cellLanes<V>(z, wrap, zi[1], zf);
+    xi[0] = wrap.dec(xi[1]) & 255;
+    yi[0] = wrap.dec(yi[1]) & 255;
+    zi[0] = wrap.dec(zi[1]) & 255;
+    xi[2] = wrap.inc(xi[1]) & 255;
+    yi[2] = wrap.inc(yi[1]) & 255;
+    zi[2] = wrap.inc(zi[1]) & 255;
+
+    //squared distances - the nearest point is less than sqrt(3) away, so 4 is further than any point which matters
+    T nearest = 4, second = 4;
+    for (int a = 0; a < 3; a++) {
+        int hashX = perms[xi[a]];
+        T cellX = (T)(a - 1.0) - xf;
+        for (int b = 0; b < 3; b++) {
+            int hashXY = perms[hashX + yi[b]];
+            T cellY = (T)(b - 1.0) - yf;
+            for (int c = 0; c < 3; c++) {
+                int hash = perms[hashXY + zi[c]];
+                T cellZ = (T)(c - 1.0) - zf;
+                T dx = cellX + worleyJitter<T>(perms, hash, 0);
+                T dy = cellY + worleyJitter<T>(perms, hash, 1);
+                T dz = cellZ + worleyJitter<T>(perms, hash, 2);
+                worleyInsert((dx*dx + dy*dy) + dz*dz, nearest, second);
+            }
+        }
+    }
+    f1 = std::sqrt(nearest);
+    f2 = std::sqrt(second);
+}
+
+//run worleyDistances over arrays with the lattice wrapping for `repeat`
+template <typename T, typename P> void worleyDistancesBatch(const P* perms, const T* x, const T* y, const T* z, T* outF1, T* outF2, size_t count, T repeat) {
+    if (repeat > 0) {
+        sceneObjects::noiseKernels::PerlinRepeatLanes<ScalarLanes<T> > wrap = sceneObjects::noiseKernels::perlinRepeatLanes<ScalarLanes<T> >(repeat);
+        for (size_t i = 0; i < count; i++) {
+            worleyDistances(perms, x[i], y[i], z[i], wrap, outF1[i], outF2[i]);
+        }
+    } else {
+        sceneObjects::noiseKernels::PerlinUnboundedLanes<ScalarLanes<T> > wrap;
+        for (size_t i = 0; i < count; i++) {
+            worleyDistances(perms, x[i], y[i], z[i], wrap, outF1[i], outF2[i]);
+        }
+    }
+}
+
+}
+
+//get the distances from coords (x,y,z) to the nearest and second nearest worley feature points
+glm::dvec2 sceneObjects::worley(double x, double y, double z, double repeat) {
+    glm::dvec2 distances;
+    worleyDistancesBatch<double, int>(perlinPerms, &x, &y, &z, &distances.x, &distances.y, 1, repeat);
+    return distances;
+}
+
+void sceneObjects::worleyBatch(const double* x, const double* y, const double* z, double* outF1, double* outF2, size_t count, double repeat) {
+    worleyDistancesBatch<double, int>(perlinPerms, x, y, z, outF1, outF2, count, repeat);
+}
+
+void sceneObjects::worleyBatch(const float* x, const float* y, const float* z, float* outF1, float* outF2, size_t count, float repeat) {
+    worleyDistancesBatch<float, int>(perlinPerms, x, y, z, outF1, outF2, count, repeat);
+}
+
+namespace {
+
+/// The lattice data for every sample along one axis of a worley grid - the part of worley() which only depends on that coordinate
+struct SO_WorleyAxis {
+    std::vector<int> cells; ///< the wrapped lattice cells before, of and after each sample - 3 per sample
+    std::vector<double> frac; ///< the position of each sample within its cell
+};
+
+//fill in the lattice data for coordinates origin + i*step, i = 0..count-1, exactly as worleyDistances() computes them
+template <class W> void fillWorleyAxis(SO_WorleyAxis& axis, double origin, double step, int count, const W& wrap) {
+    axis.cells.resize(3*(size_t)count);
+    axis.frac.resize(count);
+    for (int i = 0; i < count; i++) {
+        int cell;
+        sceneObjects::noiseKernels::cellLanes<ScalarLanes<double> >(origin + i*step, wrap, cell, axis.frac[i]);
+        axis.cells[3*i] = wrap.dec(cell) & 255;
+        axis.cells[3*i + 1] = cell;
+        axis.cells[3*i + 2] = wrap.inc(cell) & 255;
+    }
+}
+
+SO_WorleyAxis worleyAxis(double origin, double step, int count, double repeat) {
+    SO_WorleyAxis axis;
+    if (repeat > 0) {
+        fillWorleyAxis(axis, origin, step, count, sceneObjects::noiseKernels::perlinRepeatLanes<ScalarLanes<double> >(repeat));
+    } else {
+        fillWorleyAxis(axis, origin, step, count, sceneObjects::noiseKernels::PerlinUnboundedLanes<ScalarLanes<double> >());
+    }
+    return axis;
+}
+
+//fill outF1/outF2[i + j*width + k*width*height] for i in [iStart, iEnd), j in [jStart, jEnd), k in [kStart, kEnd)
+//along a row only x changes, so the 9 feature points in each column of cells (the 3x3 cells around the row in y and z) are worked out
+//once per row and kept in `columns`, indexed by the column's x cell - the samples then only compute distances. `columns` and `columnRows`
+//(the row each column was last filled for) are passed in so a tile reuses them for all of its rows.
+template <typename P> void worleyGridBlock(const P* perms, const SO_WorleyAxis& xAxis, const SO_WorleyAxis& yAxis, const SO_WorleyAxis& zAxis,
+                                           double* outF1, double* outF2, int width, int height, int iStart, int iEnd, int jStart, int jEnd, int kStart, int kEnd,
+                                           std::vector<double>& columns, std::vector<long long>& columnRows) {
+    columns.resize(256*27);
+    columnRows.assign(256, -1);
+    for (int k = kStart; k < kEnd; k++) {
+        const int* zi = &zAxis.cells[3*(size_t)k];
+        double zf = zAxis.frac[k];
+        double cellZ[3] = {-1.0 - zf, 0.0 - zf, 1.0 - zf};
+        for (int j = jStart; j < jEnd; j++) {
+            const int* yi = &yAxis.cells[3*(size_t)j];
+            double yf = yAxis.frac[j];
+            double cellY[3] = {-1.0 - yf, 0.0 - yf, 1.0 - yf};
+            long long rowID = (long long)k*height + j;
+            size_t row = (size_t)k*width*height + (size_t)j*width;
+            for (int i = iStart; i < iEnd; i++) {
+                const int* xi = &xAxis.cells[3*(size_t)i];
+                const double* column[3];
+                for (int a = 0; a < 3; a++) {
+                    double* points = &columns[27*xi[a]];
+                    if (columnRows[xi[a]] != rowID) {
+                        columnRows[xi[a]] = rowID;
+                        int hashX = perms[xi[a]];
+                        for (int bc = 0; bc < 9; bc++) {
+                            int hash = perms[perms[hashX + yi[bc/3]] + zi[bc % 3]];
+                            points[3*bc] = worleyJitter<double>(perms, hash, 0);
+                            points[3*bc + 1] = worleyJitter<double>(perms, hash, 1);
+                            points[3*bc + 2] = worleyJitter<double>(perms, hash, 2);
+                        }
+                    }
+                    column[a] = points;
+                }
+                double xf = xAxis.frac[i];
+                double cellX[3] = {-1.0 - xf, 0.0 - xf, 1.0 - xf};
+                double nearest = 4, second = 4;
+                for (int a = 0; a < 3; a++) {
+                    for (int bc = 0; bc < 9; bc++) {
+                        const double* point = column[a] + 3*bc;
+                        double dx = cellX[a] + point[0];
+                        double dy = cellY[bc/3] + point[1];
+                        double dz = cellZ[bc % 3] + point[2];
+                        worleyInsert((dx*dx + dy*dy) + dz*dz, nearest, second);
+                    }
+                }
+                outF1[row + i] = std::sqrt(nearest);
+                outF2[row + i] = std::sqrt(second);
+            }
+        }
+    }
+}
+
+}
+
+//fill a width x height x depth grid of worley noise - either directly or in tiles of about grainSize samples on the library thread pool, as perlinGridTable
+template <typename P> void sceneObjects::noiseKernels::worleyGridTable(const P* perms, double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0,
+                                                                      double dx, double dy, double dz, double repeat, size_t grainSize) {
+    if (width <= 0 || height <= 0 || depth <= 0) {
+        return;
+    }
+    SO_WorleyAxis xAxis = worleyAxis(x0, dx, width, repeat);
+    SO_WorleyAxis yAxis = worleyAxis(y0, dy, height, repeat);
+    SO_WorleyAxis zAxis = worleyAxis(z0, dz, depth, repeat);
+    if (grainSize == 0) {
+        std::vector<double> columns;
+        std::vector<long long> columnRows;
+        worleyGridBlock(perms, xAxis, yAxis, zAxis, outF1, outF2, width, height, 0, width, 0, height, 0, depth, columns, columnRows);
+        return;
+    }
+
+    int tileWidth = grainSize < (size_t)width ? (int)grainSize : width;
+    int tileHeight = grainSize/tileWidth < (size_t)height ? (int)(grainSize/tileWidth) : height;
+    int tilesX = (width + tileWidth - 1)/tileWidth;
+    int tilesY = (height + tileHeight - 1)/tileHeight;
+    SO_ThreadPool::global().parallelFor((size_t)tilesX*tilesY*depth, 1, [&](size_t begin, size_t end) {
+        std::vector<double> columns;
+        std::vector<long long> columnRows;
+        for (size_t tile = begin; tile < end; tile++) {
+            int i = (tile % tilesX)*tileWidth;
+            int j = ((tile/tilesX) % tilesY)*tileHeight;
+            int k = tile/((size_t)tilesX*tilesY);
+            int iEnd = i + tileWidth < width ? i + tileWidth : width;
+            int jEnd = j + tileHeight < height ? j + tileHeight : height;
+            worleyGridBlock(perms, xAxis, yAxis, zAxis, outF1, outF2, width, height, i, iEnd, j, jEnd, k, k + 1, columns, columnRows);
+        }
+    });
+}
+
+template void sceneObjects::noiseKernels::worleyGridTable<int>(const int* perms, double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0,
+                                                              double dx, double dy, double dz, double repeat, size_t grainSize);
+
+//fill a width x height grid of worley noise on the plane at z
+void sceneObjects::worleyGrid2D(double* outF1, double* outF2, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat) {
+    noiseKernels::worleyGridTable(perlinPerms, outF1, outF2, width, height, 1, x0, y0, z, dx, dy, 0, repeat, 0);
+}
+
+//fill a width x height x depth grid of worley noise
+void sceneObjects::worleyGrid3D(double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat) {
+    noiseKernels::worleyGridTable(perlinPerms, outF1, outF2, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, 0);
+}
+
+//fill a width x height grid of worley noise on the plane at z using the library thread pool
+void sceneObjects::worleyGridParallel2D(double* outF1, double* outF2, int width, int height, double x0, double y0, double dx, double dy, double z, double repeat, size_t grainSize) {
+    noiseKernels::worleyGridTable(perlinPerms, outF1, outF2, width, height, 1, x0, y0, z, dx, dy, 0, repeat, grainSize == 0 ? 1 : grainSize);
+}
+
+//fill a width x height x depth grid of worley noise using the library thread pool
+void sceneObjects::worleyGridParallel3D(double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0, double dx, double dy, double dz, double repeat, size_t grainSize) {
+    noiseKernels::worleyGridTable(perlinPerms, outF1, outF2, width, height, depth, x0, y0, z0, dx, dy, dz, repeat, grainSize == 0 ? 1 : grainSize);
+}
@@ -0,0 +1,790 @@
+/** \file noiseKernels.hpp
+ * \brief Internal header for the SIMD noise kernels - not part of the public sceneObjects interface
+ *
+ * The kernels are written once as templates over a small "lane traits" struct (see noiseKernelsSSE42.cpp and noiseKernelsAVX2.cpp),
+ * which supplies the lane type (V::Scalar is float or double) and the vector operations,
+ * and each instruction set is compiled in its own translation unit with its own -m flags. The public entry points in noiseFunctions.cpp
+ * pick one at runtime. It also declares the permutation-table-generic forms of the noise functions used by the noise classes.
+ * This header must stay free of glm/std templates so that no AVX2 code ends up in inline functions shared with the rest of the library.
+*/
+
+#ifndef SCENEOBJECTS_NOISEKERNELS_H_
+#define SCENEOBJECTS_NOISEKERNELS_H_
+
+#include <stddef.h>
+
+namespace sceneObjects {
+namespace noiseKernels {
+
+/// perlin() using the permutation table `perms` - instantiated for float/double and int (perlinPerms) or unsigned char (SO_PerlinNoise) tables
+template <typename T, typename P> T perlinTable(const P* perms, T x, T y, T z, T repeat);
+/// perlinBatch() using the permutation table `perms` - picks the best kernel for the CPU. Byte tables must be readable for 3 bytes past their 512 entries
+template <typename T, typename P> void perlinBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+/// perlinGrid3D() using the permutation table `perms` - a `grainSize` of 0 fills the grid on the calling thread, otherwise as perlinGridParallel3D()
+template <typename P> void perlinGridTable(const P* perms, double* out, int width, int height, int depth, double x0, double y0, double z0,
+                                           double dx, double dy, double dz, double repeat, size_t grainSize);
+
+/// perlinDerivative() using the permutation table `perms` - the gradient is written to gradient[0..2]
+template <typename T, typename P> T perlinDerivativeTable(const P* perms, T x, T y, T z, T repeat, T* gradient);
+/// perlinDerivativeBatch() using the permutation table `perms` - picks the best kernel for the CPU
+template <typename T, typename P> void perlinDerivativeBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, T* gradX, T* gradY, T* gradZ, size_t count, T repeat);
+
+/// perlin2D() using the permutation table `perms` - instantiated for float/double and int (perlinPerms) tables
+template <typename T, typename P> T perlin2DTable(const P* perms, T x, T y, T repeat);
+/// perlin2DBatch() using the permutation table `perms` - picks the best kernel for the CPU
+template <typename T, typename P> void perlin2DBatchTable(const P* perms, const T* x, const T* y, T* out, size_t count, T repeat);
+/// perlin2DGrid() using the permutation table `perms` - a `grainSize` of 0 fills the grid on the calling thread, otherwise as perlin2DGridParallel()
+template <typename P> void perlin2DGridTable(const P* perms, double* out, int width, int height, double x0, double y0, double dx, double dy, double repeat, size_t grainSize);
+
+/// perlinChannelsBatch() using the permutation table `perms` - picks the best kernel for the CPU. `channels` must be in [1, 256]
+template <typename T, typename P> void perlinChannelsBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, int channels, T repeat);
+/// curlNoiseBatch() using the permutation table `perms` - picks the best kernel for the CPU
+template <typename T, typename P> void curlNoiseBatchTable(const P* perms, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, T repeat);
+
+/// worleyGrid3D() using the permutation table `perms` - a `grainSize` of 0 fills the grid on the calling thread, otherwise as worleyGridParallel3D()
+template <typename P> void worleyGridTable(const P* perms, double* outF1, double* outF2, int width, int height, int depth, double x0, double y0, double z0,
+                                           double dx, double dy, double dz, double repeat, size_t grainSize);
+
+/// simplexBatch() using the permutation table `perms` - picks the best kernel for the CPU
+template <typename T, typename P> void simplexBatchTable(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+/// simplex4DBatch() using the permutation table `perms` - picks the best kernel for the CPU
+template <typename T, typename P> void simplex4DBatchTable(const P* perms, const T* x, const T* y, const T* z, const T* w, T* out, size_t count);
+
+/// the batch kernels for each instruction set, instantiated for the same types as perlinTable()
+template <typename T, typename P> void perlinBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+template <typename T, typename P> void perlinBatchAVX2(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+template <typename T, typename P> void perlinDerivativeBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, T* gradX, T* gradY, T* gradZ, size_t count, T repeat);
+template <typename T, typename P> void perlinDerivativeBatchAVX2(const P* perms, const T* x, const T* y, const T* z, T* out, T* gradX, T* gradY, T* gradZ, size_t count, T repeat);
+template <typename T, typename P> void perlin2DBatchSSE42(const P* perms, const T* x, const T* y, T* out, size_t count, T repeat);
+template <typename T, typename P> void perlin2DBatchAVX2(const P* perms, const T* x, const T* y, T* out, size_t count, T repeat);
+template <typename T, typename P> void perlinChannelsBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, int channels, T repeat);
+template <typename T, typename P> void perlinChannelsBatchAVX2(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, int channels, T repeat);
+template <typename T, typename P> void curlNoiseBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, T repeat);
+template <typename T, typename P> void curlNoiseBatchAVX2(const P* perms, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, T repeat);
+template <typename T, typename P> void simplexBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+template <typename T, typename P> void simplexBatchAVX2(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat);
+template <typename T, typename P> void simplex4DBatchSSE42(const P* perms, const T* x, const T* y, const T* z, const T* w, T* out, size_t count);
+template <typename T, typename P> void simplex4DBatchAVX2(const P* perms, const T* x, const T* y, const T* z, const T* w, T* out, size_t count);
+
+/// the 4D simplex skew factor (sqrt(5)-1)/4
+const double simplex4Skew = 0.30901699437494742;
+/// the 4D simplex unskew factor (5-sqrt(5))/20
+const double simplex4Unskew = 0.13819660112501051;
+/// the factor which scales the sum of the 3D simplex corner contributions to [-1, 1]
+const double simplex3Scale = 31.0;
+/// the factor which scales the sum of the 4D simplex corner contributions to [-1, 1]
+const double simplex4Scale = 62.0;
+
+/// the gradients of the 2D perlin noise - x+y, x or y with the signs given by the low bits of the hash
+/**
+ * The lane traits' grad2 make the same choices without branches: hashes 0-3 are the diagonals (+-1, +-1), 4-5 are (+-1, 0) and 6-7 are (0, +-1).
+**/
+template <typename T> inline T grad2(int hash, T x, T y) {
+    int h = hash & 0x7;
+    T u = h < 6 ? x : y;
+    T v = h < 4 ? y : 0;
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+/// x - y*floor(x/y) in the same order of operations as sceneObjects::modulus
+template <class V> inline typename V::Real modulusLanes(typename V::Real x, typename V::Real y) {
+    return V::sub(x, V::mul(y, V::floor(V::div(x, y))));
+}
+
+/// The lattice wrapping of perlinLanes for repeat <= 0 - the coordinates only wrap at the 256 entries of the permutation table
+/**
+ * The wrapping is a template parameter of the perlin kernels, picked once per batch call, so none of the per-lane code tests `repeat`.
+**/
+template <class V> struct PerlinUnboundedLanes {
+    typename V::Real wrap(typename V::Real coord) const { return modulusLanes<V>(coord, V::set1(256.0)); }
+    typename V::Int inc(typename V::Int num) const { return V::addi(num, V::set1i(1)); }
+    /// the index before `num` - -1 for 0, so callers indexing the 256 cells must mask it
+    typename V::Int dec(typename V::Int num) const { return V::addi(num, V::set1i(-1)); }
+};
+
+/// The lattice wrapping of perlinLanes for repeat > 0, with the constants which depend only on `repeat` hoisted out of the per-lane code
+template <class V> struct PerlinRepeatLanes {
+    typename V::Real repeat; ///< repeat as passed in
+    typename V::Real period; ///< (int)repeat, the period of the lattice indices
+
+    typename V::Real wrap(typename V::Real coord) const { return modulusLanes<V>(modulusLanes<V>(coord, repeat), V::set1(256.0)); }
+    /// the lanewise equivalent of sceneObjects::inc - the wrapped indices are at most `period` so two conditional subtractions replace the modulus
+    typename V::Int inc(typename V::Int num) const {
+        typename V::Real n = V::toReal(V::addi(num, V::set1i(1)));
+        n = V::sub(n, V::mul(period, V::step(period, n)));
+        n = V::sub(n, V::mul(period, V::step(period, n)));
+        return V::truncToInt(n);
+    }
+    /// the index before `num`, wrapping 0 round to `period` - 1
+    typename V::Int dec(typename V::Int num) const {
+        typename V::Real n = V::toReal(V::addi(num, V::set1i(-1)));
+        n = V::add(n, V::mul(period, V::sub(V::set1(1.0), V::step(V::set1(0.0), n))));
+        return V::truncToInt(n);
+    }
+};
+
+/// sets up the PerlinRepeatLanes for a batch call
+template <class V> inline PerlinRepeatLanes<V> perlinRepeatLanes(typename V::Scalar repeat) {
+    typedef typename V::Scalar Scalar;
+    PerlinRepeatLanes<V> wrap;
+    wrap.repeat = V::set1(repeat);
+    wrap.period = V::set1((Scalar)(int)repeat);
+    return wrap;
+}
+
+/// the lanewise equivalent of sceneObjects::fade for x in [0, 1)
+template <class V> inline typename V::Real fadeLanes(typename V::Real x) {
+    typename V::Real inner = V::add(V::mul(x, V::sub(V::mul(x, V::set1(6.0)), V::set1(15.0))), V::set1(10.0));
+    return V::mul(V::mul(V::mul(x, x), x), inner);
+}
+
+/// the lanewise equivalent of sceneObjects::lerp - lerp() takes a float weight so double lanes must already have `x` rounded to float (see latticeLanes)
+template <class V> inline typename V::Real lerpLanes(typename V::Real a, typename V::Real b, typename V::Real x) {
+    return V::add(a, V::mul(x, V::sub(b, a)));
+}
+
+/// Splits a coordinate into its lattice index and its position within the unit cell
+template <class V, class W> inline void cellLanes(typename V::Real coord, const W& wrap, typename V::Int& index, typename V::Real& frac) {
+    coord = wrap.wrap(coord);
+    typename V::Int whole = V::truncToInt(coord);
+    index = V::andi(whole, V::set1i(255));
+    frac = V::sub(coord, V::toReal(whole));
+}
+
+/// Splits a coordinate into its lattice index, its position within the unit cell and its faded weight
+template <class V, class W> inline void latticeLanes(typename V::Real coord, const W& wrap,
+                                                     typename V::Int& index, typename V::Real& frac, typename V::Real& weight) {
+    cellLanes<V>(coord, wrap, index, frac);
+    weight = V::roundToFloat(fadeLanes<V>(frac));
+}
+
+/// The corner hashes and in-cell position of V::width points - shared by perlinLanes and perlinDerivativeLanes
+template <class V> struct PerlinCell {
+    typename V::Int aaa, aab, aba, abb, baa, bab, bba, bbb; ///< The hash of each corner, named as in perlin()
+    typename V::Real xf, yf, zf; ///< The position within the unit cell
+    typename V::Real u, v, w; ///< The faded weights, rounded to float as perlin() passes them to lerp()
+    typename V::Real preciseU, preciseV, preciseW; ///< The faded weights before rounding, which the gradient of perlinDerivative() is interpolated with
+};
+
+/// Finds the unit cell of each point and hashes its corners with the same nested lookups as perlin()
+template <class V, class W, typename P> inline void perlinCellLanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z,
+                                                                    const W& wrap, PerlinCell<V>& cell) {
+    typedef typename V::Int Int;
+    Int xi, yi, zi;
+    cellLanes<V>(x, wrap, xi, cell.xf);
+    cellLanes<V>(y, wrap, yi, cell.yf);
+    cellLanes<V>(z, wrap, zi, cell.zf);
+    cell.preciseU = fadeLanes<V>(cell.xf);
+    cell.preciseV = fadeLanes<V>(cell.yf);
+    cell.preciseW = fadeLanes<V>(cell.zf);
+    cell.u = V::roundToFloat(cell.preciseU);
+    cell.v = V::roundToFloat(cell.preciseV);
+    cell.w = V::roundToFloat(cell.preciseW);
+    Int xi1 = wrap.inc(xi);
+    Int yi1 = wrap.inc(yi);
+    Int zi1 = wrap.inc(zi);
+
+    // sharing the common prefixes of the lookups
+    Int a = V::gather(perms, xi);
+    Int b = V::gather(perms, xi1);
+    Int aa = V::gather(perms, V::addi(a, yi));
+    Int ab = V::gather(perms, V::addi(a, yi1));
+    Int ba = V::gather(perms, V::addi(b, yi));
+    Int bb = V::gather(perms, V::addi(b, yi1));
+    cell.aaa = V::gather(perms, V::addi(aa, zi));
+    cell.aab = V::gather(perms, V::addi(aa, zi1));
+    cell.aba = V::gather(perms, V::addi(ab, zi));
+    cell.abb = V::gather(perms, V::addi(ab, zi1));
+    cell.baa = V::gather(perms, V::addi(ba, zi));
+    cell.bab = V::gather(perms, V::addi(ba, zi1));
+    cell.bba = V::gather(perms, V::addi(bb, zi));
+    cell.bbb = V::gather(perms, V::addi(bb, zi1));
+}
+
+/// the 8 corner hashes of a cell indexed by their x, y, z offsets as bits 2, 1, 0
+template <class V> inline void cornerHashesLanes(const PerlinCell<V>& c, typename V::Int* hashes) {
+    hashes[0] = c.aaa;
+    hashes[1] = c.aab;
+    hashes[2] = c.aba;
+    hashes[3] = c.abb;
+    hashes[4] = c.baa;
+    hashes[5] = c.bab;
+    hashes[6] = c.bba;
+    hashes[7] = c.bbb;
+}
+
+/// the perlin noise of the cell `c` with the corner hashes `h` (see cornerHashesLanes) - the interpolation of perlinLanes
+template <class V> inline typename V::Real perlinCornersLanes(const typename V::Int* h, const PerlinCell<V>& c) {
+    typedef typename V::Real Real;
+    Real one = V::set1(1.0);
+    Real xf1 = V::sub(c.xf, one);
+    Real yf1 = V::sub(c.yf, one);
+    Real zf1 = V::sub(c.zf, one);
+
+    Real x1 = lerpLanes<V>(V::grad(h[0], c.xf, c.yf, c.zf), V::grad(h[4], xf1, c.yf, c.zf), c.u);
+    Real x2 = lerpLanes<V>(V::grad(h[2], c.xf, yf1, c.zf), V::grad(h[6], xf1, yf1, c.zf), c.u);
+    Real y1 = lerpLanes<V>(x1, x2, c.v);
+    x1 = lerpLanes<V>(V::grad(h[1], c.xf, c.yf, zf1), V::grad(h[5], xf1, c.yf, zf1), c.u);
+    x2 = lerpLanes<V>(V::grad(h[3], c.xf, yf1, zf1), V::grad(h[7], xf1, yf1, zf1), c.u);
+    Real y2 = lerpLanes<V>(x1, x2, c.v);
+
+    return V::mul(V::add(lerpLanes<V>(y1, y2, c.w), one), V::set1(0.5));
+}
+
+/// Evaluates sceneObjects::perlin on V::width points at once
+template <class V, class W, typename P> inline typename V::Real perlinLanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, const W& wrap) {
+    PerlinCell<V> c;
+    perlinCellLanes<V>(perms, x, y, z, wrap, c);
+    typename V::Int hashes[8];
+    cornerHashesLanes<V>(c, hashes);
+    return perlinCornersLanes<V>(hashes, c);
+}
+
+/// the derivative of sceneObjects::fade
+template <class V> inline typename V::Real fadeDerivativeLanes(typename V::Real x) {
+    typename V::Real xm1 = V::sub(x, V::set1(1.0));
+    return V::mul(V::set1(30.0), V::mul(V::mul(x, x), V::mul(xm1, xm1)));
+}
+
+/// trilinear interpolation of the 8 corner values c[xyz] with the unrounded cell weights
+template <class V> inline typename V::Real trilerpLanes(const typename V::Real* c, const PerlinCell<V>& cell) {
+    typename V::Real y1 = lerpLanes<V>(lerpLanes<V>(c[0], c[4], cell.preciseU), lerpLanes<V>(c[2], c[6], cell.preciseU), cell.preciseV);
+    typename V::Real y2 = lerpLanes<V>(lerpLanes<V>(c[1], c[5], cell.preciseU), lerpLanes<V>(c[3], c[7], cell.preciseU), cell.preciseV);
+    return lerpLanes<V>(y1, y2, cell.preciseW);
+}
+
+/// the perlin noise and its gradient of the cell `c` with the corner hashes `h` (see cornerHashesLanes) - the interpolation of perlinDerivativeLanes
+template <class V> inline typename V::Real perlinDerivativeCornersLanes(const typename V::Int* hashes, const PerlinCell<V>& c,
+                                                                        typename V::Real& gx, typename V::Real& gy, typename V::Real& gz) {
+    typedef typename V::Real Real;
+    Real zero = V::set1(0.0);
+    Real one = V::set1(1.0);
+    Real half = V::set1(0.5);
+    Real xf1 = V::sub(c.xf, one);
+    Real yf1 = V::sub(c.yf, one);
+    Real zf1 = V::sub(c.zf, one);
+
+    Real n[8], dirX[8], dirY[8], dirZ[8];
+    for (int i = 0; i < 8; i++) {
+        n[i] = V::grad(hashes[i], (i & 4) ? xf1 : c.xf, (i & 2) ? yf1 : c.yf, (i & 1) ? zf1 : c.zf);
+        dirX[i] = V::grad(hashes[i], one, zero, zero);
+        dirY[i] = V::grad(hashes[i], zero, one, zero);
+        dirZ[i] = V::grad(hashes[i], zero, zero, one);
+    }
+
+    // the same interpolation as perlinLanes, keeping the partial results needed for the derivative of the weights
+    Real x1 = lerpLanes<V>(n[0], n[4], c.u);
+    Real x2 = lerpLanes<V>(n[2], n[6], c.u);
+    Real y1 = lerpLanes<V>(x1, x2, c.v);
+    Real x3 = lerpLanes<V>(n[1], n[5], c.u);
+    Real x4 = lerpLanes<V>(n[3], n[7], c.u);
+    Real y2 = lerpLanes<V>(x3, x4, c.v);
+    Real value = V::mul(V::add(lerpLanes<V>(y1, y2, c.w), one), half);
+
+    Real dx1 = lerpLanes<V>(V::sub(n[4], n[0]), V::sub(n[6], n[2]), c.preciseV);
+    Real dx2 = lerpLanes<V>(V::sub(n[5], n[1]), V::sub(n[7], n[3]), c.preciseV);
+    Real dLdu = lerpLanes<V>(dx1, dx2, c.preciseW);
+    Real dLdv = lerpLanes<V>(V::sub(x2, x1), V::sub(x4, x3), c.preciseW);
+    Real dLdw = V::sub(y2, y1);
+
+    gx = V::mul(V::add(trilerpLanes<V>(dirX, c), V::mul(fadeDerivativeLanes<V>(c.xf), dLdu)), half);
+    gy = V::mul(V::add(trilerpLanes<V>(dirY, c), V::mul(fadeDerivativeLanes<V>(c.yf), dLdv)), half);
+    gz = V::mul(V::add(trilerpLanes<V>(dirZ, c), V::mul(fadeDerivativeLanes<V>(c.zf), dLdw)), half);
+    return value;
+}
+
+/// Evaluates sceneObjects::perlinDerivative on V::width points at once - the value matches perlinLanes and the gradient is written to gx, gy, gz
+template <class V, class W, typename P> inline typename V::Real perlinDerivativeLanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, const W& wrap,
+                                                                                      typename V::Real& gx, typename V::Real& gy, typename V::Real& gz) {
+    PerlinCell<V> c;
+    perlinCellLanes<V>(perms, x, y, z, wrap, c);
+    typename V::Int hashes[8];
+    cornerHashesLanes<V>(c, hashes);
+    return perlinDerivativeCornersLanes<V>(hashes, c, gx, gy, gz);
+}
+
+/// the corner hashes of noise channel `channel` - channel 0 is perlin() itself and channel c > 0 looks each hash up again at an offset of c (mod 256)
+template <class V, typename P> inline void channelHashesLanes(const P* perms, const typename V::Int* hashes, int channel, typename V::Int* channelHashes) {
+    if (channel == 0) {
+        for (int i = 0; i < 8; i++) {
+            channelHashes[i] = hashes[i];
+        }
+        return;
+    }
+    typename V::Int offset = V::set1i(channel & 255);
+    for (int i = 0; i < 8; i++) {
+        channelHashes[i] = V::gather(perms, V::addi(hashes[i], offset));
+    }
+}
+
+/// Evaluates `channels` channels of sceneObjects::perlinChannels on V::width points at once, sharing the cell between them - channel c is stored to out + c*stride
+template <class V, class W, typename P> inline void perlinChannelsLanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, const W& wrap,
+                                                                        typename V::Scalar* out, size_t stride, int channels) {
+    PerlinCell<V> c;
+    perlinCellLanes<V>(perms, x, y, z, wrap, c);
+    typename V::Int hashes[8], channelHashes[8];
+    cornerHashesLanes<V>(c, hashes);
+    for (int channel = 0; channel < channels; channel++) {
+        channelHashesLanes<V>(perms, hashes, channel, channelHashes);
+        V::store(out + channel*stride, perlinCornersLanes<V>(channelHashes, c));
+    }
+}
+
+/// Evaluates sceneObjects::curlNoise on V::width points at once - the curl of the vector potential made of channels 0, 1 and 2, from their analytic gradients
+template <class V, class W, typename P> inline void curlNoiseLanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, const W& wrap,
+                                                                   typename V::Real& cx, typename V::Real& cy, typename V::Real& cz) {
+    typedef typename V::Real Real;
+    PerlinCell<V> c;
+    perlinCellLanes<V>(perms, x, y, z, wrap, c);
+    typename V::Int hashes[8], channelHashes[8];
+    cornerHashesLanes<V>(c, hashes);
+    Real g[3][3]; // g[channel][axis]
+    for (int channel = 0; channel < 3; channel++) {
+        channelHashesLanes<V>(perms, hashes, channel, channelHashes);
+        perlinDerivativeCornersLanes<V>(channelHashes, c, g[channel][0], g[channel][1], g[channel][2]);
+    }
+    cx = V::sub(g[2][1], g[1][2]);
+    cy = V::sub(g[0][2], g[2][0]);
+    cz = V::sub(g[1][0], g[0][1]);
+}
+
+/// Runs perlinLanes with the lattice wrapping `wrap` over arrays of any length - the tail is padded out to a full vector
+template <class V, class W, typename P> void perlinBatchWrapped(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                                typename V::Scalar* out, size_t count, const W& wrap) {
+    typedef typename V::Scalar Scalar;
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width) {
+        V::store(out + i, perlinLanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), wrap));
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {}, tailOut[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+        }
+        V::store(tailOut, perlinLanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), wrap));
+        for (size_t j = 0; i + j < count; j++) {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+/// Runs perlinBatchWrapped with the lattice wrapping for `repeat`
+template <class V, typename P> void perlinBatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                     typename V::Scalar* out, size_t count, typename V::Scalar repeat) {
+    if (repeat > 0) {
+        perlinBatchWrapped<V>(perms, x, y, z, out, count, perlinRepeatLanes<V>(repeat));
+    } else {
+        perlinBatchWrapped<V>(perms, x, y, z, out, count, PerlinUnboundedLanes<V>());
+    }
+}
+
+/// Runs perlinDerivativeLanes with the lattice wrapping `wrap` over arrays of any length - the tail is padded out to a full vector
+template <class V, class W, typename P> void perlinDerivativeBatchWrapped(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                                          typename V::Scalar* out, typename V::Scalar* gradX, typename V::Scalar* gradY, typename V::Scalar* gradZ,
+                                                                          size_t count, const W& wrap) {
+    typedef typename V::Scalar Scalar;
+    typedef typename V::Real Real;
+    size_t i = 0;
+    Real gx, gy, gz;
+    for (; i + V::width <= count; i += V::width) {
+        V::store(out + i, perlinDerivativeLanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), wrap, gx, gy, gz));
+        V::store(gradX + i, gx);
+        V::store(gradY + i, gy);
+        V::store(gradZ + i, gz);
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {};
+        Scalar tailOut[V::width], tailGX[V::width], tailGY[V::width], tailGZ[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+        }
+        V::store(tailOut, perlinDerivativeLanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), wrap, gx, gy, gz));
+        V::store(tailGX, gx);
+        V::store(tailGY, gy);
+        V::store(tailGZ, gz);
+        for (size_t j = 0; i + j < count; j++) {
+            out[i + j] = tailOut[j];
+            gradX[i + j] = tailGX[j];
+            gradY[i + j] = tailGY[j];
+            gradZ[i + j] = tailGZ[j];
+        }
+    }
+}
+
+/// Runs perlinDerivativeBatchWrapped with the lattice wrapping for `repeat`
+template <class V, typename P> void perlinDerivativeBatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                               typename V::Scalar* out, typename V::Scalar* gradX, typename V::Scalar* gradY, typename V::Scalar* gradZ,
+                                                               size_t count, typename V::Scalar repeat) {
+    if (repeat > 0) {
+        perlinDerivativeBatchWrapped<V>(perms, x, y, z, out, gradX, gradY, gradZ, count, perlinRepeatLanes<V>(repeat));
+    } else {
+        perlinDerivativeBatchWrapped<V>(perms, x, y, z, out, gradX, gradY, gradZ, count, PerlinUnboundedLanes<V>());
+    }
+}
+
+/// Evaluates sceneObjects::perlin2D on V::width points at once - the 4 corners of the square around each point, hashed with two lookups
+template <class V, class W, typename P> inline typename V::Real perlin2DLanes(const P* perms, typename V::Real x, typename V::Real y, const W& wrap) {
+    typedef typename V::Real Real;
+    typedef typename V::Int Int;
+    Int xi, yi;
+    Real xf, yf, u, v;
+    latticeLanes<V>(x, wrap, xi, xf, u);
+    latticeLanes<V>(y, wrap, yi, yf, v);
+    Int yi1 = wrap.inc(yi);
+    Int a = V::gather(perms, xi);
+    Int b = V::gather(perms, wrap.inc(xi));
+
+    Real one = V::set1(1.0);
+    Real xf1 = V::sub(xf, one);
+    Real yf1 = V::sub(yf, one);
+    Real x1 = lerpLanes<V>(V::grad2(V::gather(perms, V::addi(a, yi)), xf, yf), V::grad2(V::gather(perms, V::addi(b, yi)), xf1, yf), u);
+    Real x2 = lerpLanes<V>(V::grad2(V::gather(perms, V::addi(a, yi1)), xf, yf1), V::grad2(V::gather(perms, V::addi(b, yi1)), xf1, yf1), u);
+    return V::mul(V::add(lerpLanes<V>(x1, x2, v), one), V::set1(0.5));
+}
+
+/// Runs perlin2DLanes with the lattice wrapping `wrap` over arrays of any length - the tail is padded out to a full vector
+template <class V, class W, typename P> void perlin2DBatchWrapped(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y,
+                                                                  typename V::Scalar* out, size_t count, const W& wrap) {
+    typedef typename V::Scalar Scalar;
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width) {
+        V::store(out + i, perlin2DLanes<V>(perms, V::load(x + i), V::load(y + i), wrap));
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailOut[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+        }
+        V::store(tailOut, perlin2DLanes<V>(perms, V::load(tailX), V::load(tailY), wrap));
+        for (size_t j = 0; i + j < count; j++) {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+/// Runs perlin2DBatchWrapped with the lattice wrapping for `repeat`
+template <class V, typename P> void perlin2DBatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y,
+                                                       typename V::Scalar* out, size_t count, typename V::Scalar repeat) {
+    if (repeat > 0) {
+        perlin2DBatchWrapped<V>(perms, x, y, out, count, perlinRepeatLanes<V>(repeat));
+    } else {
+        perlin2DBatchWrapped<V>(perms, x, y, out, count, PerlinUnboundedLanes<V>());
+    }
+}
+
+/// Runs perlinChannelsLanes with the lattice wrapping `wrap` over arrays of any length - channel c of point i is written to out[c*count + i]
+template <class V, class W, typename P> void perlinChannelsBatchWrapped(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                                        typename V::Scalar* out, size_t count, int channels, const W& wrap) {
+    typedef typename V::Scalar Scalar;
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width) {
+        perlinChannelsLanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), wrap, out + i, count, channels);
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {}, tailOut[256*V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+        }
+        perlinChannelsLanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), wrap, tailOut, V::width, channels);
+        for (int channel = 0; channel < channels; channel++) {
+            for (size_t j = 0; i + j < count; j++) {
+                out[channel*count + i + j] = tailOut[channel*V::width + j];
+            }
+        }
+    }
+}
+
+/// Runs perlinChannelsBatchWrapped with the lattice wrapping for `repeat` - `channels` must be at most 256
+template <class V, typename P> void perlinChannelsBatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                             typename V::Scalar* out, size_t count, int channels, typename V::Scalar repeat) {
+    if (repeat > 0) {
+        perlinChannelsBatchWrapped<V>(perms, x, y, z, out, count, channels, perlinRepeatLanes<V>(repeat));
+    } else {
+        perlinChannelsBatchWrapped<V>(perms, x, y, z, out, count, channels, PerlinUnboundedLanes<V>());
+    }
+}
+
+/// Runs curlNoiseLanes with the lattice wrapping `wrap` over arrays of any length - the tail is padded out to a full vector
+template <class V, class W, typename P> void curlNoiseBatchWrapped(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                                   typename V::Scalar* outX, typename V::Scalar* outY, typename V::Scalar* outZ, size_t count, const W& wrap) {
+    typedef typename V::Scalar Scalar;
+    typedef typename V::Real Real;
+    size_t i = 0;
+    Real cx, cy, cz;
+    for (; i + V::width <= count; i += V::width) {
+        curlNoiseLanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), wrap, cx, cy, cz);
+        V::store(outX + i, cx);
+        V::store(outY + i, cy);
+        V::store(outZ + i, cz);
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {};
+        Scalar tailCX[V::width], tailCY[V::width], tailCZ[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+        }
+        curlNoiseLanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), wrap, cx, cy, cz);
+        V::store(tailCX, cx);
+        V::store(tailCY, cy);
+        V::store(tailCZ, cz);
+        for (size_t j = 0; i + j < count; j++) {
+            outX[i + j] = tailCX[j];
+            outY[i + j] = tailCY[j];
+            outZ[i + j] = tailCZ[j];
+        }
+    }
+}
+
+/// Runs curlNoiseBatchWrapped with the lattice wrapping for `repeat`
+template <class V, typename P> void curlNoiseBatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                        typename V::Scalar* outX, typename V::Scalar* outY, typename V::Scalar* outZ, size_t count, typename V::Scalar repeat) {
+    if (repeat > 0) {
+        curlNoiseBatchWrapped<V>(perms, x, y, z, outX, outY, outZ, count, perlinRepeatLanes<V>(repeat));
+    } else {
+        curlNoiseBatchWrapped<V>(perms, x, y, z, outX, outY, outZ, count, PerlinUnboundedLanes<V>());
+    }
+}
+
+/// Constants of a simplex batch call which depend only on `repeat`
+template <class V> struct SimplexWrap {
+    bool wrapCoords; ///< repeat > 0 - the coordinates and lattice points are wrapped into [0, repeat)
+    typename V::Real repeat; ///< repeat as passed in
+};
+
+/// sets up the SimplexWrap for a batch call
+template <class V> inline SimplexWrap<V> simplexWrap(typename V::Scalar repeat) {
+    SimplexWrap<V> wrap;
+    wrap.wrapCoords = repeat > 0;
+    wrap.repeat = V::set1(repeat);
+    return wrap;
+}
+
+/// -1, 0 or 1 - the number of periods a corner position less than one period outside [0, repeat) must be moved by to bring it back inside
+template <class V> inline typename V::Real wrapShiftLanes(typename V::Real x, typename V::Real repeat) {
+    return V::sub(V::sub(V::set1(1.0), V::step(V::set1(0.0), x)), V::step(repeat, x));
+}
+
+/// the contribution of one simplex corner at offset (x, y, z) from the point
+template <class V> inline typename V::Real simplexCorner3Lanes(typename V::Int hash, typename V::Real x, typename V::Real y, typename V::Real z) {
+    typename V::Real t = V::sub(V::set1(0.5), V::add(V::add(V::mul(x, x), V::mul(y, y)), V::mul(z, z)));
+    t = V::max(t, V::set1(0.0));
+    return V::mul(V::mul(V::mul(t, t), t), V::grad(hash, x, y, z));
+}
+
+/// hashes the simplex corner with lattice coordinates a, b, c and position vx, vy, vz and returns its contribution to the point at offset x, y, z from it
+template <class V, typename P> inline typename V::Real simplexVertex3Lanes(const P* perms, typename V::Real a, typename V::Real b, typename V::Real c,
+                                                                           typename V::Real vx, typename V::Real vy, typename V::Real vz,
+                                                                           typename V::Real x, typename V::Real y, typename V::Real z, const SimplexWrap<V>& wrap) {
+    typedef typename V::Real Real;
+    if (wrap.wrapCoords) { // hash the copy of the corner inside [0, repeat) so corners on either side of the boundary agree
+        Real shiftX = wrapShiftLanes<V>(vx, wrap.repeat);
+        Real shiftY = wrapShiftLanes<V>(vy, wrap.repeat);
+        Real shiftZ = wrapShiftLanes<V>(vz, wrap.repeat);
+        a = V::add(a, V::mul(wrap.repeat, V::add(shiftY, shiftZ)));
+        b = V::add(b, V::mul(wrap.repeat, V::add(shiftX, shiftZ)));
+        c = V::add(c, V::mul(wrap.repeat, V::add(shiftX, shiftY)));
+    }
+    typename V::Int mask = V::set1i(255);
+    typename V::Int hash = V::gather(perms, V::andi(V::truncToInt(a), mask));
+    hash = V::gather(perms, V::addi(hash, V::andi(V::truncToInt(b), mask)));
+    hash = V::gather(perms, V::addi(hash, V::andi(V::truncToInt(c), mask)));
+    return simplexCorner3Lanes<V>(hash, x, y, z);
+}
+
+/// Evaluates sceneObjects::simplex (3D) on V::width points at once
+/**
+ * The simplices are the tetrahedra of the body centred cubic lattice, in lattice coordinates (y+z, x+z, x+y) - this lattice contains
+ * every integer translation, so the noise tiles exactly when `repeat` is a whole number. The corners' contributions are (0.5-r^2)^3
+ * times the same 12 gradients as perlin().
+**/
+template <class V, typename P> inline typename V::Real simplex3Lanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, const SimplexWrap<V>& wrap) {
+    typedef typename V::Real Real;
+    if (wrap.wrapCoords) {
+        x = modulusLanes<V>(x, wrap.repeat);
+        y = modulusLanes<V>(y, wrap.repeat);
+        z = modulusLanes<V>(z, wrap.repeat);
+    }
+
+    Real u = V::add(y, z);
+    Real v = V::add(x, z);
+    Real w = V::add(x, y);
+    Real iu = V::floor(u);
+    Real iv = V::floor(v);
+    Real iw = V::floor(w);
+    Real fu = V::sub(u, iu);
+    Real fv = V::sub(v, iv);
+    Real fw = V::sub(w, iw);
+
+    // which of the 6 tetrahedra in the cell the point is in, as the lattice offsets of its second and third corners
+    Real one = V::set1(1.0);
+    Real half = V::set1(0.5);
+    Real gu = V::step(fu, fv);
+    Real gv = V::step(fv, fw);
+    Real gw = V::step(fu, fw);
+    Real g1 = V::sub(one, gw), g2 = gu, g3 = gv;
+    Real l1 = V::sub(one, gu), l2 = V::sub(one, gv), l3 = gw;
+    Real o1u = V::min(g1, l1), o1v = V::min(g2, l2), o1w = V::min(g3, l3);
+    Real o2u = V::max(g1, l1), o2v = V::max(g2, l2), o2w = V::max(g3, l3);
+
+    // the corners' positions - the lattice point (a, b, c) is at ((b+c-a)/2, (a+c-b)/2, (a+b-c)/2)
+    Real x0 = V::mul(V::sub(V::add(iv, iw), iu), half);
+    Real y0 = V::mul(V::sub(V::add(iu, iw), iv), half);
+    Real z0 = V::mul(V::sub(V::add(iu, iv), iw), half);
+    Real x1 = V::add(x0, V::mul(V::sub(V::add(o1v, o1w), o1u), half));
+    Real y1 = V::add(y0, V::mul(V::sub(V::add(o1u, o1w), o1v), half));
+    Real z1 = V::add(z0, V::mul(V::sub(V::add(o1u, o1v), o1w), half));
+    Real x2 = V::add(x0, V::mul(V::sub(V::add(o2v, o2w), o2u), half));
+    Real y2 = V::add(y0, V::mul(V::sub(V::add(o2u, o2w), o2v), half));
+    Real z2 = V::add(z0, V::mul(V::sub(V::add(o2u, o2v), o2w), half));
+    Real x3 = V::add(x0, half);
+    Real y3 = V::add(y0, half);
+    Real z3 = V::add(z0, half);
+
+    Real n = simplexVertex3Lanes<V>(perms, iu, iv, iw, x0, y0, z0, V::sub(x, x0), V::sub(y, y0), V::sub(z, z0), wrap);
+    n = V::add(n, simplexVertex3Lanes<V>(perms, V::add(iu, o1u), V::add(iv, o1v), V::add(iw, o1w), x1, y1, z1, V::sub(x, x1), V::sub(y, y1), V::sub(z, z1), wrap));
+    n = V::add(n, simplexVertex3Lanes<V>(perms, V::add(iu, o2u), V::add(iv, o2v), V::add(iw, o2w), x2, y2, z2, V::sub(x, x2), V::sub(y, y2), V::sub(z, z2), wrap));
+    n = V::add(n, simplexVertex3Lanes<V>(perms, V::add(iu, one), V::add(iv, one), V::add(iw, one), x3, y3, z3, V::sub(x, x3), V::sub(y, y3), V::sub(z, z3), wrap));
+
+    // scaled so the result spans [0, 1] like perlin()
+    return V::mul(V::add(V::mul(n, V::set1(simplex3Scale)), one), half);
+}
+
+/// the contribution of one 4D simplex corner with hash `hash` at offset (x, y, z, w) from the point
+template <class V> inline typename V::Real simplexCorner4Lanes(typename V::Int hash, typename V::Real x, typename V::Real y, typename V::Real z, typename V::Real w) {
+    typename V::Real t = V::sub(V::set1(0.5), V::add(V::add(V::mul(x, x), V::mul(y, y)), V::add(V::mul(z, z), V::mul(w, w))));
+    t = V::max(t, V::set1(0.0));
+    t = V::mul(t, t);
+    return V::mul(V::mul(t, t), V::grad4(hash, x, y, z, w));
+}
+
+/// Evaluates sceneObjects::simplex4D on V::width points at once
+/**
+ * The classic skewed simplex lattice - a point's simplex is found by ranking its position within the skewed hypercube, so only 5 corners
+ * are hashed where 4D perlin noise would need 16. No axis aligned translation other than the 256 cell wrap of the table maps this lattice
+ * onto itself, which is why there is no `repeat`.
+**/
+template <class V, typename P> inline typename V::Real simplex4Lanes(const P* perms, typename V::Real x, typename V::Real y, typename V::Real z, typename V::Real w) {
+    typedef typename V::Real Real;
+    typedef typename V::Int Int;
+    Real skew = V::set1(simplex4Skew);
+    Real unskew = V::set1(simplex4Unskew);
+    Real s = V::mul(V::add(V::add(x, y), V::add(z, w)), skew);
+    Real i = V::floor(V::add(x, s));
+    Real j = V::floor(V::add(y, s));
+    Real k = V::floor(V::add(z, s));
+    Real l = V::floor(V::add(w, s));
+    Real t = V::mul(V::add(V::add(i, j), V::add(k, l)), unskew);
+    Real x0 = V::sub(x, V::sub(i, t));
+    Real y0 = V::sub(y, V::sub(j, t));
+    Real z0 = V::sub(z, V::sub(k, t));
+    Real w0 = V::sub(w, V::sub(l, t));
+
+    // rank each axis by how far the point is along it - the simplex steps along the highest ranked axis first
+    Real one = V::set1(1.0);
+    Real rankX = V::set1(0.0), rankY = rankX, rankZ = rankX, rankW = rankX;
+    Real c = V::step(y0, x0);
+    rankX = V::add(rankX, c);
+    rankY = V::add(rankY, V::sub(one, c));
+    c = V::step(z0, x0);
+    rankX = V::add(rankX, c);
+    rankZ = V::add(rankZ, V::sub(one, c));
+    c = V::step(w0, x0);
+    rankX = V::add(rankX, c);
+    rankW = V::add(rankW, V::sub(one, c));
+    c = V::step(z0, y0);
+    rankY = V::add(rankY, c);
+    rankZ = V::add(rankZ, V::sub(one, c));
+    c = V::step(w0, y0);
+    rankY = V::add(rankY, c);
+    rankW = V::add(rankW, V::sub(one, c));
+    c = V::step(w0, z0);
+    rankZ = V::add(rankZ, c);
+    rankW = V::add(rankW, V::sub(one, c));
+
+    Int mask = V::set1i(255);
+    Int ii = V::andi(V::truncToInt(i), mask);
+    Int jj = V::andi(V::truncToInt(j), mask);
+    Int kk = V::andi(V::truncToInt(k), mask);
+    Int ll = V::andi(V::truncToInt(l), mask);
+    Real n = V::set1(0.0);
+    for (int corner = 0; corner < 5; corner++) {
+        // corner c steps along the axes ranked at least 4-c, and is c*unskew further from the skewed origin
+        Real threshold = V::set1(4.0 - corner);
+        Real oi = V::step(threshold, rankX);
+        Real oj = V::step(threshold, rankY);
+        Real ok = V::step(threshold, rankZ);
+        Real ol = V::step(threshold, rankW);
+        Real shift = V::set1(corner*simplex4Unskew);
+        Int hash = V::gather(perms, V::addi(ll, V::truncToInt(ol)));
+        hash = V::gather(perms, V::addi(V::addi(kk, V::truncToInt(ok)), hash));
+        hash = V::gather(perms, V::addi(V::addi(jj, V::truncToInt(oj)), hash));
+        hash = V::gather(perms, V::addi(V::addi(ii, V::truncToInt(oi)), hash));
+        n = V::add(n, simplexCorner4Lanes<V>(hash, V::add(V::sub(x0, oi), shift), V::add(V::sub(y0, oj), shift),
+                                                    V::add(V::sub(z0, ok), shift), V::add(V::sub(w0, ol), shift)));
+    }
+
+    // scaled so the result spans [0, 1] like perlin()
+    return V::mul(V::add(V::mul(n, V::set1(simplex4Scale)), one), V::set1(0.5));
+}
+
+/// Runs simplex3Lanes over arrays of any length - the tail is padded out to a full vector
+template <class V, typename P> void simplex3BatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                       typename V::Scalar* out, size_t count, typename V::Scalar repeat) {
+    typedef typename V::Scalar Scalar;
+    SimplexWrap<V> wrap = simplexWrap<V>(repeat);
+
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width) {
+        V::store(out + i, simplex3Lanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), wrap));
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {}, tailOut[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+        }
+        V::store(tailOut, simplex3Lanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), wrap));
+        for (size_t j = 0; i + j < count; j++) {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+/// Runs simplex4Lanes over arrays of any length - the tail is padded out to a full vector
+template <class V, typename P> void simplex4BatchKernel(const P* perms, const typename V::Scalar* x, const typename V::Scalar* y, const typename V::Scalar* z,
+                                                       const typename V::Scalar* w, typename V::Scalar* out, size_t count) {
+    typedef typename V::Scalar Scalar;
+
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width) {
+        V::store(out + i, simplex4Lanes<V>(perms, V::load(x + i), V::load(y + i), V::load(z + i), V::load(w + i)));
+    }
+    if (i < count) {
+        Scalar tailX[V::width] = {}, tailY[V::width] = {}, tailZ[V::width] = {}, tailW[V::width] = {}, tailOut[V::width];
+        for (size_t j = 0; i + j < count; j++) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+            tailZ[j] = z[i + j];
+            tailW[j] = w[i + j];
+        }
+        V::store(tailOut, simplex4Lanes<V>(perms, V::load(tailX), V::load(tailY), V::load(tailZ), V::load(tailW)));
+        for (size_t j = 0; i + j < count; j++) {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,218 @@
+/** \file noiseKernelsSSE42.cpp
+ * \brief SSE4.2 instantiations of the noise kernels - this file is compiled with -msse4.2 and only called after a runtime CPU check
+*/
+#include "noiseKernels.hpp"
+#include <nmmintrin.h>
+
+#ifndef __SSE4_2__
+#error "noiseKernelsSSE42.cpp must be compiled with -msse4.2"
+#endif
+
+namespace {
+
+/// 2 double lanes, with lattice indices held in the low 2 int32 lanes - SSE has no gather so table lookups are done per lane
+struct SSE42Double {
+    static const int width = 2;
+    typedef double Scalar;
+    typedef __m128d Real;
+    typedef __m128i Int;
+
+    static Real load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, Real a) { _mm_storeu_pd(p, a); }
+    static Real set1(double a) { return _mm_set1_pd(a); }
+    static Real add(Real a, Real b) { return _mm_add_pd(a, b); }
+    static Real sub(Real a, Real b) { return _mm_sub_pd(a, b); }
+    static Real mul(Real a, Real b) { return _mm_mul_pd(a, b); }
+    static Real div(Real a, Real b) { return _mm_div_pd(a, b); }
+    static Real floor(Real a) { return _mm_floor_pd(a); }
+    static Real roundToFloat(Real a) { return _mm_cvtps_pd(_mm_cvtpd_ps(a)); }
+    static Int truncToInt(Real a) { return _mm_cvttpd_epi32(a); }
+    static Real toReal(Int a) { return _mm_cvtepi32_pd(a); }
+    static Real min(Real a, Real b) { return _mm_min_pd(a, b); }
+    static Real max(Real a, Real b) { return _mm_max_pd(a, b); }
+    static Real sqrt(Real a) { return _mm_sqrt_pd(a); }
+    static Real step(Real edge, Real a) { return _mm_and_pd(_mm_cmpge_pd(a, edge), _mm_set1_pd(1.0)); }
+
+    static Int set1i(int a) { return _mm_set1_epi32(a); }
+    static Int addi(Int a, Int b) { return _mm_add_epi32(a, b); }
+    static Int andi(Int a, Int b) { return _mm_and_si128(a, b); }
+    static Int gather(const int* table, Int index) {
+        return _mm_set_epi32(0, 0, table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 0)]);
+    }
+    static Int gather(const unsigned char* table, Int index) {
+        return _mm_set_epi32(0, 0, table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 0)]);
+    }
+
+    /// branch free sceneObjects::grad - picks the same two of x/y/z and the same signs as the switch
+    static Real grad(Int hash, Real x, Real y, Real z) {
+        __m128i h = _mm_cvtepi32_epi64(_mm_and_si128(hash, _mm_set1_epi32(0xF)));
+        Real below8 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(8), h));
+        Real below4 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(4), h));
+        Real useX = _mm_castsi128_pd(_mm_or_si128(_mm_cmpeq_epi64(h, _mm_set1_epi64x(12)), _mm_cmpeq_epi64(h, _mm_set1_epi64x(14))));
+        Real u = _mm_blendv_pd(y, x, below8);
+        Real v = _mm_blendv_pd(_mm_blendv_pd(z, x, useX), y, below4);
+        Real signU = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(1)), 63));
+        Real signV = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(2)), 62));
+        return _mm_add_pd(_mm_xor_pd(u, signU), _mm_xor_pd(v, signV));
+    }
+
+    /// branch free 2D gradient - the same choice of x/y and signs as noiseKernels::grad2
+    static Real grad2(Int hash, Real x, Real y) {
+        __m128i h = _mm_cvtepi32_epi64(_mm_and_si128(hash, _mm_set1_epi32(0x7)));
+        Real below6 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(6), h));
+        Real below4 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(4), h));
+        Real u = _mm_blendv_pd(y, x, below6);
+        Real v = _mm_and_pd(y, below4);
+        Real signU = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(1)), 63));
+        Real signV = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(2)), 62));
+        return _mm_add_pd(_mm_xor_pd(u, signU), _mm_xor_pd(v, signV));
+    }
+
+    /// branch free 4D gradient - the same choice of three of x/y/z/w and signs as the scalar simplex grad4
+    static Real grad4(Int hash, Real x, Real y, Real z, Real w) {
+        __m128i h = _mm_cvtepi32_epi64(_mm_and_si128(hash, _mm_set1_epi32(0x1F)));
+        Real below24 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(24), h));
+        Real below16 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(16), h));
+        Real below8 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(8), h));
+        Real a = _mm_blendv_pd(y, x, below24);
+        Real b = _mm_blendv_pd(z, y, below16);
+        Real c = _mm_blendv_pd(w, z, below8);
+        Real signA = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(1)), 63));
+        Real signB = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(2)), 62));
+        Real signC = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(4)), 61));
+        return _mm_add_pd(_mm_add_pd(_mm_xor_pd(a, signA), _mm_xor_pd(b, signB)), _mm_xor_pd(c, signC));
+    }
+};
+
+/// 4 float lanes, with lattice indices held as 4 int32 lanes
+struct SSE42Float {
+    static const int width = 4;
+    typedef float Scalar;
+    typedef __m128 Real;
+    typedef __m128i Int;
+
+    static Real load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Real a) { _mm_storeu_ps(p, a); }
+    static Real set1(float a) { return _mm_set1_ps(a); }
+    static Real add(Real a, Real b) { return _mm_add_ps(a, b); }
+    static Real sub(Real a, Real b) { return _mm_sub_ps(a, b); }
+    static Real mul(Real a, Real b) { return _mm_mul_ps(a, b); }
+    static Real div(Real a, Real b) { return _mm_div_ps(a, b); }
+    static Real floor(Real a) { return _mm_floor_ps(a); }
+    static Real roundToFloat(Real a) { return a; }
+    static Int truncToInt(Real a) { return _mm_cvttps_epi32(a); }
+    static Real toReal(Int a) { return _mm_cvtepi32_ps(a); }
+    static Real min(Real a, Real b) { return _mm_min_ps(a, b); }
+    static Real max(Real a, Real b) { return _mm_max_ps(a, b); }
+    static Real sqrt(Real a) { return _mm_sqrt_ps(a); }
+    static Real step(Real edge, Real a) { return _mm_and_ps(_mm_cmpge_ps(a, edge), _mm_set1_ps(1.0f)); }
+
+    static Int set1i(int a) { return _mm_set1_epi32(a); }
+    static Int addi(Int a, Int b) { return _mm_add_epi32(a, b); }
+    static Int andi(Int a, Int b) { return _mm_and_si128(a, b); }
+    static Int gather(const int* table, Int index) {
+        return _mm_set_epi32(table[_mm_extract_epi32(index, 3)], table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 0)]);
+    }
+    static Int gather(const unsigned char* table, Int index) {
+        return _mm_set_epi32(table[_mm_extract_epi32(index, 3)], table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 0)]);
+    }
+
+    /// branch free sceneObjects::grad - the hash is already in the same lanes as the coordinates
+    static Real grad(Int hash, Real x, Real y, Real z) {
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(0xF));
+        Real below8 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(8), h));
+        Real below4 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(4), h));
+        Real useX = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+        Real u = _mm_blendv_ps(y, x, below8);
+        Real v = _mm_blendv_ps(_mm_blendv_ps(z, x, useX), y, below4);
+        Real signU = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+        Real signV = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+        return _mm_add_ps(_mm_xor_ps(u, signU), _mm_xor_ps(v, signV));
+    }
+
+    /// branch free 2D gradient - the same choice of x/y and signs as noiseKernels::grad2
+    static Real grad2(Int hash, Real x, Real y) {
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(0x7));
+        Real below6 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(6), h));
+        Real below4 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(4), h));
+        Real u = _mm_blendv_ps(y, x, below6);
+        Real v = _mm_and_ps(y, below4);
+        Real signU = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+        Real signV = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+        return _mm_add_ps(_mm_xor_ps(u, signU), _mm_xor_ps(v, signV));
+    }
+
+    /// branch free 4D gradient - the same choice of three of x/y/z/w and signs as the scalar simplex grad4
+    static Real grad4(Int hash, Real x, Real y, Real z, Real w) {
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(0x1F));
+        Real below24 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(24), h));
+        Real below16 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(16), h));
+        Real below8 = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(8), h));
+        Real a = _mm_blendv_ps(y, x, below24);
+        Real b = _mm_blendv_ps(z, y, below16);
+        Real c = _mm_blendv_ps(w, z, below8);
+        Real signA = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+        Real signB = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+        Real signC = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), 29));
+        return _mm_add_ps(_mm_add_ps(_mm_xor_ps(a, signA), _mm_xor_ps(b, signB)), _mm_xor_ps(c, signC));
+    }
+};
+
+/// selects the lane traits for a scalar type
+template <typename T> struct SSE42Lanes;
+template <> struct SSE42Lanes<double> { typedef SSE42Double Type; };
+template <> struct SSE42Lanes<float> { typedef SSE42Float Type; };
+
+}
+
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat) {
+    perlinBatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, out, count, repeat);
+}
+
+template void sceneObjects::noiseKernels::perlinBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+template void sceneObjects::noiseKernels::perlinBatchSSE42<double, unsigned char>(const unsigned char* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinBatchSSE42<float, unsigned char>(const unsigned char* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinDerivativeBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, T* gradX, T* gradY, T* gradZ, size_t count, T repeat) {
+    perlinDerivativeBatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, out, gradX, gradY, gradZ, count, repeat);
+}
+
+template void sceneObjects::noiseKernels::perlinDerivativeBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchSSE42<double, unsigned char>(const unsigned char* perms, const double* x, const double* y, const double* z, double* out, double* gradX, double* gradY, double* gradZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlinDerivativeBatchSSE42<float, unsigned char>(const unsigned char* perms, const float* x, const float* y, const float* z, float* out, float* gradX, float* gradY, float* gradZ, size_t count, float repeat);
+
+template <typename T, typename P> void sceneObjects::noiseKernels::perlinChannelsBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, int channels, T repeat) {
+    perlinChannelsBatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, out, count, channels, repeat);
+}
+
+template void sceneObjects::noiseKernels::perlinChannelsBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, int channels, double repeat);
+template void sceneObjects::noiseKernels::perlinChannelsBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, int channels, float repeat);
+
+template <typename T, typename P> void sceneObjects::noiseKernels::curlNoiseBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, T repeat) {
+    curlNoiseBatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, outX, outY, outZ, count, repeat);
+}
+
+template void sceneObjects::noiseKernels::curlNoiseBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, double* outX, double* outY, double* outZ, size_t count, double repeat);
+template void sceneObjects::noiseKernels::curlNoiseBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count, float repeat);
+
+template <typename T, typename P> void sceneObjects::noiseKernels::perlin2DBatchSSE42(const P* perms, const T* x, const T* y, T* out, size_t count, T repeat) {
+    perlin2DBatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, out, count, repeat);
+}
+
+template void sceneObjects::noiseKernels::perlin2DBatchSSE42<double, int>(const int* perms, const double* x, const double* y, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::perlin2DBatchSSE42<float, int>(const int* perms, const float* x, const float* y, float* out, size_t count, float repeat);
+
+template <typename T, typename P> void sceneObjects::noiseKernels::simplexBatchSSE42(const P* perms, const T* x, const T* y, const T* z, T* out, size_t count, T repeat) {
+    simplex3BatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, out, count, repeat);
+}
+
+template <typename T, typename P> void sceneObjects::noiseKernels::simplex4DBatchSSE42(const P* perms, const T* x, const T* y, const T* z, const T* w, T* out, size_t count) {
+    simplex4BatchKernel<typename SSE42Lanes<T>::Type>(perms, x, y, z, w, out, count);
+}
+
+template void sceneObjects::noiseKernels::simplexBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, double* out, size_t count, double repeat);
+template void sceneObjects::noiseKernels::simplexBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, float* out, size_t count, float repeat);
+template void sceneObjects::noiseKernels::simplex4DBatchSSE42<double, int>(const int* perms, const double* x, const double* y, const double* z, const double* w, double* out, size_t count);
+template void sceneObjects::noiseKernels::simplex4DBatchSSE42<float, int>(const int* perms, const float* x, const float* y, const float* z, const float* w, float* out, size_t count);
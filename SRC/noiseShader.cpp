@@ -0,0 +1,99 @@
+/** \file noiseShader.cpp */
+#include "sceneObjects.hpp"
+
+//the GLSL form of perlin() - each step mirrors the CPU code so the results agree to float precision
+//the permutation table is read from the usampler1D "perlinPerms", which should hold createPerlinPermsTexture()
+std::string sceneObjects::perlinShaderSource(void) {
+    return R"glsl(
+        uniform usampler1D perlinPerms;
+
+        int perlinPerm(int index) {
+            return int(texelFetch(perlinPerms, index, 0).r);
+        }
+
+        // the same switch as sceneObjects::grad
+        float perlinGrad(int hash, float x, float y, float z) {
+            switch (hash & 15) {
+                case 0: return  x + y;
+                case 1: return -x + y;
+                case 2: return  x - y;
+                case 3: return -x - y;
+                case 4: return  x + z;
+                case 5: return -x + z;
+                case 6: return  x - z;
+                case 7: return -x - z;
+                case 8: return  y + z;
+                case 9: return -y + z;
+                case 10: return  y - z;
+                case 11: return -y - z;
+                case 12: return  y + x;
+                case 13: return -y + z;
+                case 14: return  y - x;
+                default: return -y - z;
+            }
+        }
+
+        float perlinFade(float t) {
+            return t*t*t*(t*(t*6.0 - 15.0) + 10.0);
+        }
+
+        // sceneObjects::lerp - not mix(), which rounds differently
+        float perlinLerp(float a, float b, float t) {
+            return a + t*(b - a);
+        }
+
+        // perlin noise in [0, 1] at p, repeating every `repeat` units if repeat > 0 - matches sceneObjects::perlin
+        float perlin(vec3 p, float repeat) {
+            if (repeat > 0.0) {
+                p = mod(p, repeat);
+            }
+            p = mod(p, 256.0);
+            ivec3 whole = ivec3(p);
+            ivec3 i = whole & 255;
+            ivec3 i1 = i + 1;
+            int period = int(repeat);
+            if (repeat > 0.0 && period > 0) {
+                i1 = i1 % period;
+            }
+            vec3 f = p - vec3(whole);
+            float u = perlinFade(f.x);
+            float v = perlinFade(f.y);
+            float w = perlinFade(f.z);
+
+            int a = perlinPerm(i.x);
+            int b = perlinPerm(i1.x);
+            int aa = perlinPerm(a + i.y);
+            int ab = perlinPerm(a + i1.y);
+            int ba = perlinPerm(b + i.y);
+            int bb = perlinPerm(b + i1.y);
+
+            float x1 = perlinLerp(perlinGrad(perlinPerm(aa + i.z), f.x, f.y, f.z), perlinGrad(perlinPerm(ba + i.z), f.x - 1.0, f.y, f.z), u);
+            float x2 = perlinLerp(perlinGrad(perlinPerm(ab + i.z), f.x, f.y - 1.0, f.z), perlinGrad(perlinPerm(bb + i.z), f.x - 1.0, f.y - 1.0, f.z), u);
+            float y1 = perlinLerp(x1, x2, v);
+            x1 = perlinLerp(perlinGrad(perlinPerm(aa + i1.z), f.x, f.y, f.z - 1.0), perlinGrad(perlinPerm(ba + i1.z), f.x - 1.0, f.y, f.z - 1.0), u);
+            x2 = perlinLerp(perlinGrad(perlinPerm(ab + i1.z), f.x, f.y - 1.0, f.z - 1.0), perlinGrad(perlinPerm(bb + i1.z), f.x - 1.0, f.y - 1.0, f.z - 1.0), u);
+            float y2 = perlinLerp(x1, x2, v);
+            return (perlinLerp(y1, y2, w) + 1.0)/2.0;
+        }
+    )glsl";
+}
+
+//upload perlinPerms as a 512 texel GL_R8UI 1D texture for perlinShaderSource()
+GLuint sceneObjects::createPerlinPermsTexture(void) {
+    unsigned char perms[512];
+    for (int i = 0; i < 512; i++) {
+        perms[i] = (unsigned char)perlinPerms[i];
+    }
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_1D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R8UI, 512, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, perms);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // integer textures are only complete with nearest filtering, and texelFetch() never filters anyway
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    return textureID;
+}
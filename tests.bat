@@ -64,4 +64,82 @@ cd "J Skybox"
 del main.exe main.o
 mingw32-make
 .\main
+cd ..
+
+cd "K PerlinBatch"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "L Simplex"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "M PerlinNoise"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "N FractalNoise"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "O MarchingCubes"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "P Heightfield"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "Q ColorMapBatch"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "R IcosphereCache"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "S Icosphere"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "T TerrainElements"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "U NoiseChunkCache"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "V NoiseShader"
+del main.exe main.o
+mingw32-make
+.\main
+cd ..
+
+cd "W ColormapShader"
+del main.exe main.o
+mingw32-make
+.\main
 cd ..
\ No newline at end of file
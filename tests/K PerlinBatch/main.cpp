@@ -0,0 +1,249 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+using namespace sceneObjects;
+
+int WIDTH = 1000;
+int HEIGHT = 1000;
+
+//compares perlinBatch and the perlinGrid functions against perlin() for a heightfield the same shape as test E (but larger) and prints the speedup
+int main(int argc, char *argv[]) {
+
+    std::vector<double> xs, ys, zs;
+    xs.resize(WIDTH*HEIGHT);
+    ys.resize(WIDTH*HEIGHT);
+    zs.resize(WIDTH*HEIGHT);
+    for (int w = 0; w < WIDTH; w++) {
+        for (int h = 0; h < HEIGHT; h++) {
+            int index = w+h*WIDTH;
+            xs[index] = 20*(-1.0 + 2.0*((double)w/(WIDTH-1)));
+            ys[index] = 20*(-1.0 + 2.0*((double)h/(HEIGHT-1)));
+            zs[index] = 0.37*w; // vary z as well so every lattice lookup is exercised
+        }
+    }
+
+    std::vector<double> scalar(WIDTH*HEIGHT);
+    std::vector<double> batch(WIDTH*HEIGHT);
+    double repeats[3] = {0, 16, 10.5};
+    for (int r = 0; r < 3; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            scalar[i] = perlin(xs[i], ys[i], zs[i], repeats[r]);
+        }
+        auto mid = std::chrono::steady_clock::now();
+        perlinBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT, repeats[r]);
+        auto end = std::chrono::steady_clock::now();
+
+        double maxDiff = 0;
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            maxDiff = std::fmax(maxDiff, std::fabs(scalar[i] - batch[i]));
+        }
+        double scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+        double batchTime = std::chrono::duration<double, std::milli>(end - mid).count();
+        printf("repeat %5.1f: perlin() %8.2fms, perlinBatch() %8.2fms, speedup %5.2fx, max difference %g\n", repeats[r], scalarTime, batchTime, scalarTime/batchTime, maxDiff);
+        if (maxDiff > 1e-12) {
+            printf("FAILED: perlinBatch() does not match perlin()\n");
+            return 1;
+        }
+    }
+
+    //the compile time periods against the matching runtime repeats
+    std::vector<double> wrapped(WIDTH*HEIGHT);
+    const char* names[2] = {"perlin<SO_FixedPeriod<16> >()", "perlin<SO_FixedPeriod<256> >()"};
+    double periods[2] = {16, 256};
+    for (int form = 0; form < 2; form++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            scalar[i] = perlin(xs[i], ys[i], zs[i], periods[form]);
+        }
+        auto mid = std::chrono::steady_clock::now();
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            wrapped[i] = form == 0 ? perlin<SO_FixedPeriod<16> >(xs[i], ys[i], zs[i]) : perlin<SO_FixedPeriod<256> >(xs[i], ys[i], zs[i]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+        double wrappedTime = std::chrono::duration<double, std::milli>(end - mid).count();
+        printf("repeat %5.1f: perlin() %8.2fms, %s %8.2fms, speedup %5.2fx\n", periods[form], scalarTime, names[form], wrappedTime, scalarTime/wrappedTime);
+        if (wrapped != scalar) {
+            printf("FAILED: %s does not match perlin()\n", names[form]);
+            return 1;
+        }
+    }
+
+    //the same field without the varying z as a grid fill
+    std::vector<double> grid(WIDTH*HEIGHT);
+    double step = 40.0/(WIDTH-1);
+    auto start = std::chrono::steady_clock::now();
+    for (int h = 0; h < HEIGHT; h++) {
+        for (int w = 0; w < WIDTH; w++) {
+            scalar[w+h*WIDTH] = perlin(-20.0 + w*step, -20.0 + h*step, 0.0, 0);
+        }
+    }
+    auto mid = std::chrono::steady_clock::now();
+    perlinGrid2D(&grid[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.0, 0);
+    auto end = std::chrono::steady_clock::now();
+    double maxDiff = 0;
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        maxDiff = std::fmax(maxDiff, std::fabs(scalar[i] - grid[i]));
+    }
+    double scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double gridTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("grid 2D:      perlin() %8.2fms, perlinGrid2D() %8.2fms, speedup %5.2fx, max difference %g\n", scalarTime, gridTime, scalarTime/gridTime, maxDiff);
+    if (maxDiff != 0) {
+        printf("FAILED: perlinGrid2D() does not match perlin()\n");
+        return 1;
+    }
+
+    std::vector<double> parallelGrid(WIDTH*HEIGHT);
+    start = std::chrono::steady_clock::now();
+    perlinGridParallel2D(&parallelGrid[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.0, 0);
+    end = std::chrono::steady_clock::now();
+    double parallelTime = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("grid 2D:      perlinGridParallel2D() %8.2fms on %u threads, speedup over perlinGrid2D() %5.2fx\n", parallelTime, SO_ThreadPool::global().getThreadCount(), gridTime/parallelTime);
+    if (parallelGrid != grid) {
+        printf("FAILED: perlinGridParallel2D() does not match perlinGrid2D()\n");
+        return 1;
+    }
+
+    //2D perlin noise against perlin() on the plane z = 0, as in test E
+    std::vector<double> planar(WIDTH*HEIGHT);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        scalar[i] = perlin(xs[i], ys[i], 0.0, 0);
+    }
+    mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        planar[i] = perlin2D(xs[i], ys[i], 0.0);
+    }
+    end = std::chrono::steady_clock::now();
+    scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double planarTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("2D:           perlin(x, y, 0, 0) %8.2fms, perlin2D() %8.2fms, speedup %5.2fx\n", scalarTime, planarTime, scalarTime/planarTime);
+
+    start = std::chrono::steady_clock::now();
+    perlin2DBatch(&xs[0], &ys[0], &batch[0], WIDTH*HEIGHT, 0.0);
+    end = std::chrono::steady_clock::now();
+    double batch2DTime = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("2D:           perlin2D() %8.2fms, perlin2DBatch() %8.2fms, speedup %5.2fx\n", planarTime, batch2DTime, planarTime/batch2DTime);
+    if (batch != planar) {
+        printf("FAILED: perlin2DBatch() does not match perlin2D()\n");
+        return 1;
+    }
+
+    for (int h = 0; h < HEIGHT; h++) {
+        for (int w = 0; w < WIDTH; w++) {
+            planar[w+h*WIDTH] = perlin2D(-20.0 + w*step, -20.0 + h*step, 0.0);
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    perlin2DGrid(&grid[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.0);
+    end = std::chrono::steady_clock::now();
+    double grid2DTime = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("2D grid:      perlinGrid2D() %8.2fms, perlin2DGrid() %8.2fms, speedup %5.2fx\n", gridTime, grid2DTime, gridTime/grid2DTime);
+    if (grid != planar) {
+        printf("FAILED: perlin2DGrid() does not match perlin2D()\n");
+        return 1;
+    }
+
+    //three channels from one lattice walk against three separate perlinBatch() calls, and curl noise against three perlinDerivativeBatch() calls
+    std::vector<double> channels(3*WIDTH*HEIGHT);
+    start = std::chrono::steady_clock::now();
+    for (int c = 0; c < 3; c++) {
+        perlinBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT, 0.0);
+    }
+    mid = std::chrono::steady_clock::now();
+    perlinChannelsBatch(&xs[0], &ys[0], &zs[0], &channels[0], WIDTH*HEIGHT, 3, 0.0);
+    end = std::chrono::steady_clock::now();
+    double separateTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double channelsTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("channels:     3x perlinBatch() %8.2fms, perlinChannelsBatch() %8.2fms, speedup %5.2fx\n", separateTime, channelsTime, separateTime/channelsTime);
+    if (!std::equal(batch.begin(), batch.end(), channels.begin())) {
+        printf("FAILED: channel 0 of perlinChannelsBatch() does not match perlinBatch()\n");
+        return 1;
+    }
+
+    std::vector<double> gx(WIDTH*HEIGHT), gy(WIDTH*HEIGHT), gz(WIDTH*HEIGHT);
+    start = std::chrono::steady_clock::now();
+    for (int c = 0; c < 3; c++) {
+        perlinDerivativeBatch(&xs[0], &ys[0], &zs[0], &batch[0], &gx[0], &gy[0], &gz[0], WIDTH*HEIGHT, 0.0);
+    }
+    mid = std::chrono::steady_clock::now();
+    curlNoiseBatch(&xs[0], &ys[0], &zs[0], &gx[0], &gy[0], &gz[0], WIDTH*HEIGHT, 0.0);
+    end = std::chrono::steady_clock::now();
+    separateTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double curlTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    double maxCurlDiff = 0;
+    for (int i = 0; i < WIDTH*HEIGHT; i += 97) {
+        glm::dvec3 curl = curlNoise(xs[i], ys[i], zs[i], 0);
+        maxCurlDiff = std::fmax(maxCurlDiff, std::fabs(curl.x - gx[i]) + std::fabs(curl.y - gy[i]) + std::fabs(curl.z - gz[i]));
+    }
+    printf("curl:         3x perlinDerivativeBatch() %8.2fms, curlNoiseBatch() %8.2fms, speedup %5.2fx, max difference %g\n", separateTime, curlTime, separateTime/curlTime, maxCurlDiff);
+    if (maxCurlDiff > 1e-12) {
+        printf("FAILED: curlNoiseBatch() does not match curlNoise()\n");
+        return 1;
+    }
+
+    //worley noise - the batch and grid forms against worley()
+    std::vector<double> f1(WIDTH*HEIGHT), f2(WIDTH*HEIGHT), gridF1(WIDTH*HEIGHT), gridF2(WIDTH*HEIGHT);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        glm::dvec2 distances = worley(xs[i], ys[i], zs[i], 0);
+        scalar[i] = distances.x;
+        batch[i] = distances.y;
+    }
+    mid = std::chrono::steady_clock::now();
+    worleyBatch(&xs[0], &ys[0], &zs[0], &f1[0], &f2[0], WIDTH*HEIGHT, 0.0);
+    end = std::chrono::steady_clock::now();
+    scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double worleyTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("worley:       worley() %8.2fms, worleyBatch() %8.2fms, speedup %5.2fx\n", scalarTime, worleyTime, scalarTime/worleyTime);
+    if (f1 != scalar || f2 != batch) {
+        printf("FAILED: worleyBatch() does not match worley()\n");
+        return 1;
+    }
+    start = std::chrono::steady_clock::now();
+    for (int h = 0; h < HEIGHT; h++) {
+        for (int w = 0; w < WIDTH; w++) {
+            glm::dvec2 distances = worley(-20.0 + w*step, -20.0 + h*step, 0.0, 0);
+            scalar[w+h*WIDTH] = distances.x;
+            batch[w+h*WIDTH] = distances.y;
+        }
+    }
+    mid = std::chrono::steady_clock::now();
+    worleyGrid2D(&gridF1[0], &gridF2[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.0, 0);
+    end = std::chrono::steady_clock::now();
+    scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    worleyTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("worley grid:  worley() %8.2fms, worleyGrid2D() %8.2fms, speedup %5.2fx\n", scalarTime, worleyTime, scalarTime/worleyTime);
+    if (gridF1 != scalar || gridF2 != batch) {
+        printf("FAILED: worleyGrid2D() does not match worley()\n");
+        return 1;
+    }
+    std::fill(gridF1.begin(), gridF1.end(), 0.0);
+    std::fill(gridF2.begin(), gridF2.end(), 0.0);
+    worleyGridParallel2D(&gridF1[0], &gridF2[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.0, 0, 1000);
+    if (gridF1 != scalar || gridF2 != batch) {
+        printf("FAILED: worleyGridParallel2D() does not match worley()\n");
+        return 1;
+    }
+    std::vector<double> volumeF1(24*20*16), volumeF2(24*20*16);
+    worleyGridParallel3D(&volumeF1[0], &volumeF2[0], 24, 20, 16, -3.0, 1.0, 2.0, 0.37, 0.41, 0.29, 5.0, 100);
+    for (int d = 0; d < 16; d++) {
+        for (int h = 0; h < 20; h++) {
+            for (int w = 0; w < 24; w++) {
+                glm::dvec2 distances = worley(-3.0 + w*0.37, 1.0 + h*0.41, 2.0 + d*0.29, 5.0);
+                if (distances.x != volumeF1[w + h*24 + d*24*20] || distances.y != volumeF2[w + h*24 + d*24*20]) {
+                    printf("FAILED: worleyGridParallel3D() does not match worley() with repeat 5\n");
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
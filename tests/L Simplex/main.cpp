@@ -0,0 +1,100 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+using namespace sceneObjects;
+
+int WIDTH = 1000;
+int HEIGHT = 1000;
+
+//times simplex() and simplexBatch() against perlin() and perlinBatch() over the same points, and checks the batch forms match the scalar ones
+int main(int argc, char *argv[]) {
+
+    std::vector<double> xs, ys, zs, ws;
+    xs.resize(WIDTH*HEIGHT);
+    ys.resize(WIDTH*HEIGHT);
+    zs.resize(WIDTH*HEIGHT);
+    ws.resize(WIDTH*HEIGHT);
+    for (int w = 0; w < WIDTH; w++) {
+        for (int h = 0; h < HEIGHT; h++) {
+            int index = w+h*WIDTH;
+            xs[index] = 20*(-1.0 + 2.0*((double)w/(WIDTH-1)));
+            ys[index] = 20*(-1.0 + 2.0*((double)h/(HEIGHT-1)));
+            zs[index] = 0.37*w;
+            ws[index] = 0.01*h; // e.g. time
+        }
+    }
+
+    std::vector<double> perlinScalar(WIDTH*HEIGHT), simplexScalar(WIDTH*HEIGHT), batch(WIDTH*HEIGHT);
+    double repeats[2] = {0, 16};
+    for (int r = 0; r < 2; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            perlinScalar[i] = perlin(xs[i], ys[i], zs[i], repeats[r]);
+        }
+        auto perlinEnd = std::chrono::steady_clock::now();
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            simplexScalar[i] = simplex(xs[i], ys[i], zs[i], repeats[r]);
+        }
+        auto simplexEnd = std::chrono::steady_clock::now();
+        perlinBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT, repeats[r]);
+        auto perlinBatchEnd = std::chrono::steady_clock::now();
+        simplexBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT, repeats[r]);
+        auto simplexBatchEnd = std::chrono::steady_clock::now();
+
+        double maxDiff = 0;
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            maxDiff = std::fmax(maxDiff, std::fabs(simplexScalar[i] - batch[i]));
+        }
+        double perlinTime = std::chrono::duration<double, std::milli>(perlinEnd - start).count();
+        double simplexTime = std::chrono::duration<double, std::milli>(simplexEnd - perlinEnd).count();
+        double perlinBatchTime = std::chrono::duration<double, std::milli>(perlinBatchEnd - simplexEnd).count();
+        double simplexBatchTime = std::chrono::duration<double, std::milli>(simplexBatchEnd - perlinBatchEnd).count();
+        printf("3D repeat %4.1f: perlin() %8.2fms, simplex() %8.2fms (%5.2fx), perlinBatch() %8.2fms, simplexBatch() %8.2fms (%5.2fx), max difference %g\n",
+               repeats[r], perlinTime, simplexTime, perlinTime/simplexTime, perlinBatchTime, simplexBatchTime, perlinBatchTime/simplexBatchTime, maxDiff);
+        if (maxDiff > 1e-12) {
+            printf("FAILED: simplexBatch() does not match simplex()\n");
+            return 1;
+        }
+    }
+
+    //3D simplex() tiles seamlessly with a whole number repeat
+    for (int i = 0; i < WIDTH*HEIGHT; i += 101) {
+        double wrapped = simplex(xs[i] + 16, ys[i] - 32, zs[i] + 48, 16);
+        if (std::fabs(wrapped - simplex(xs[i], ys[i], zs[i], 16)) > 1e-9) {
+            printf("FAILED: simplex() does not repeat every 16\n");
+            return 1;
+        }
+    }
+
+    //4D against the 3D perlin() an animated field would otherwise have to make do with
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        perlinScalar[i] = perlin(xs[i], ys[i], zs[i], 0);
+    }
+    auto perlinEnd = std::chrono::steady_clock::now();
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        simplexScalar[i] = simplex4D(xs[i], ys[i], zs[i], ws[i]);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    simplex4DBatch(&xs[0], &ys[0], &zs[0], &ws[0], &batch[0], WIDTH*HEIGHT);
+    auto end = std::chrono::steady_clock::now();
+    double maxDiff = 0;
+    for (int i = 0; i < WIDTH*HEIGHT; i++) {
+        maxDiff = std::fmax(maxDiff, std::fabs(simplexScalar[i] - batch[i]));
+    }
+    double perlinTime = std::chrono::duration<double, std::milli>(perlinEnd - start).count();
+    double scalarTime = std::chrono::duration<double, std::milli>(mid - perlinEnd).count();
+    double batchTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("4D:             perlin() (3D) %8.2fms, simplex4D() %8.2fms (%5.2fx), simplex4DBatch() %8.2fms (%5.2fx over simplex4D()), max difference %g\n",
+           perlinTime, scalarTime, perlinTime/scalarTime, batchTime, scalarTime/batchTime, maxDiff);
+    if (maxDiff > 1e-12) {
+        printf("FAILED: simplex4DBatch() does not match simplex4D()\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace sceneObjects;
+
+int WIDTH = 256;
+int HEIGHT = 256;
+
+//returns true if the two objects have the same table and give the same noise
+bool sameNoise(const SO_PerlinNoise& a, const SO_PerlinNoise& b) {
+    for (int i = 0; i < 512; i++) {
+        if (a.getPermutations()[i] != b.getPermutations()[i]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 1000; i++) {
+        double x = 0.137*i, y = -0.071*i, z = 0.29*i;
+        if (a.noise(x, y, z) != b.noise(x, y, z)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//returns true if the object's table starts on a cache line
+bool aligned(const SO_PerlinNoise& noise) {
+    return ((uintptr_t)noise.getPermutations() % 64) == 0;
+}
+
+//checks SO_PerlinNoise's table, its copy semantics, and that its batch and grid forms match noise()
+int main(int argc, char *argv[]) {
+
+    //the table is a permutation of 0-255 repeated twice, and depends only on the seed
+    SO_PerlinNoise first(1234), second(1234), other(4321);
+    std::vector<int> seen(256, 0);
+    for (int i = 0; i < 256; i++) {
+        seen[first.getPermutations()[i]]++;
+        if (first.getPermutations()[i] != first.getPermutations()[i + 256]) {
+            printf("FAILED: permutation table entries %d and %d differ\n", i, i + 256);
+            return 1;
+        }
+    }
+    for (int i = 0; i < 256; i++) {
+        if (seen[i] != 1) {
+            printf("FAILED: permutation table is not a permutation of 0-255\n");
+            return 1;
+        }
+    }
+    if (first.getSeed() != 1234 || !sameNoise(first, second)) {
+        printf("FAILED: objects with the same seed give different noise\n");
+        return 1;
+    }
+    if (sameNoise(first, other)) {
+        printf("FAILED: objects with different seeds give the same noise\n");
+        return 1;
+    }
+    printf("table:        seed %u, first entries %d %d %d %d\n", first.getSeed(), first.getPermutations()[0], first.getPermutations()[1], first.getPermutations()[2], first.getPermutations()[3]);
+
+    //copies - on the stack, by assignment and inside a vector - keep the seed and table, and each table starts on a cache line
+    SO_PerlinNoise copied(first);
+    SO_PerlinNoise assigned(99);
+    assigned = other;
+    std::vector<SO_PerlinNoise> layers;
+    for (unsigned int seed = 0; seed < 8; seed++) {
+        layers.push_back(SO_PerlinNoise(seed));
+    }
+    std::vector<SO_PerlinNoise> layersCopy = layers;
+    if (copied.getSeed() != first.getSeed() || !sameNoise(copied, first) || assigned.getSeed() != other.getSeed() || !sameNoise(assigned, other)) {
+        printf("FAILED: a copy of an SO_PerlinNoise gives different noise\n");
+        return 1;
+    }
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (!sameNoise(layers[i], layersCopy[i]) || !sameNoise(layers[i], SO_PerlinNoise(i))) {
+            printf("FAILED: SO_PerlinNoise copied into a vector gives different noise\n");
+            return 1;
+        }
+    }
+    if (!aligned(first) || !aligned(copied) || !aligned(assigned)) {
+        printf("FAILED: permutation table is not aligned to 64 bytes\n");
+        return 1;
+    }
+    int alignedLayers = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        alignedLayers += aligned(layers[i]) ? 1 : 0;
+    }
+    printf("copies:       %d of %d tables in a vector start on a cache line\n", alignedLayers, (int)layers.size());
+
+    //the batch, derivative and grid forms against noise()
+    std::vector<double> xs(WIDTH*HEIGHT), ys(WIDTH*HEIGHT), zs(WIDTH*HEIGHT);
+    std::vector<float> xf(WIDTH*HEIGHT), yf(WIDTH*HEIGHT), zf(WIDTH*HEIGHT);
+    double step = 40.0/(WIDTH-1);
+    for (int w = 0; w < WIDTH; w++) {
+        for (int h = 0; h < HEIGHT; h++) {
+            int index = w+h*WIDTH;
+            xs[index] = -20.0 + w*step;
+            ys[index] = -20.0 + h*step;
+            zs[index] = 0.5;
+            xf[index] = (float)xs[index];
+            yf[index] = (float)ys[index];
+            zf[index] = (float)zs[index];
+        }
+    }
+    double repeats[2] = {0, 16};
+    for (int r = 0; r < 2; r++) {
+        double repeat = repeats[r];
+        std::vector<double> batch(WIDTH*HEIGHT), gx(WIDTH*HEIGHT), gy(WIDTH*HEIGHT), gz(WIDTH*HEIGHT), grid(WIDTH*HEIGHT), parallelGrid(WIDTH*HEIGHT);
+        std::vector<float> batchF(WIDTH*HEIGHT);
+        first.noiseBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT, repeat);
+        first.noiseBatch(&xf[0], &yf[0], &zf[0], &batchF[0], WIDTH*HEIGHT, (float)repeat);
+        first.noiseDerivativeBatch(&xs[0], &ys[0], &zs[0], &grid[0], &gx[0], &gy[0], &gz[0], WIDTH*HEIGHT, repeat);
+        double maxDiff = 0, maxFloatDiff = 0, maxGradientDiff = 0;
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            double expected = first.noise(xs[i], ys[i], zs[i], repeat);
+            maxDiff = std::fmax(maxDiff, std::fabs(expected - batch[i]));
+            maxDiff = std::fmax(maxDiff, std::fabs(expected - grid[i]));
+            maxFloatDiff = std::fmax(maxFloatDiff, std::fabs(first.noise(xf[i], yf[i], zf[i], (float)repeat) - batchF[i]));
+            if (i % 97 == 0) {
+                glm::dvec3 gradient;
+                first.noiseDerivative(xs[i], ys[i], zs[i], gradient, repeat);
+                maxGradientDiff = std::fmax(maxGradientDiff, std::fabs(gradient.x - gx[i]) + std::fabs(gradient.y - gy[i]) + std::fabs(gradient.z - gz[i]));
+            }
+        }
+        printf("repeat %4.1f:  batch max difference %g, float batch %g, gradient %g\n", repeat, maxDiff, maxFloatDiff, maxGradientDiff);
+        if (maxDiff > 1e-12 || maxFloatDiff > 1e-6 || maxGradientDiff > 1e-12) {
+            printf("FAILED: SO_PerlinNoise batch forms do not match noise()\n");
+            return 1;
+        }
+
+        first.noiseGrid2D(&grid[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.5, repeat);
+        first.noiseGridParallel2D(&parallelGrid[0], WIDTH, HEIGHT, -20.0, -20.0, step, step, 0.5, repeat, 1024);
+        for (int i = 0; i < WIDTH*HEIGHT; i++) {
+            if (grid[i] != first.noise(xs[i], ys[i], zs[i], repeat) || parallelGrid[i] != grid[i]) {
+                printf("FAILED: SO_PerlinNoise grid forms do not match noise()\n");
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
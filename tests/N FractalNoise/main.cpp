@@ -0,0 +1,88 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+using namespace sceneObjects;
+
+int WIDTH = 500;
+int HEIGHT = 500;
+
+//times SO_FractalNoise::noiseBatch() against noise() for each fractal type, and checks the results match, stay in [0, 1] and repeat
+int main(int argc, char *argv[]) {
+
+    std::vector<double> xs(WIDTH*HEIGHT), ys(WIDTH*HEIGHT), zs(WIDTH*HEIGHT);
+    for (int w = 0; w < WIDTH; w++) {
+        for (int h = 0; h < HEIGHT; h++) {
+            int index = w+h*WIDTH;
+            xs[index] = 20*(-1.0 + 2.0*((double)w/(WIDTH-1)));
+            ys[index] = 20*(-1.0 + 2.0*((double)h/(HEIGHT-1)));
+            zs[index] = 0.37*w;
+        }
+    }
+
+    //a single octave of fbm is perlin() itself
+    SO_FractalNoise single(SO_FRACTAL_FBM, 1);
+    for (int i = 0; i < WIDTH*HEIGHT; i += 101) {
+        if (std::fabs(single.noise(xs[i], ys[i], zs[i]) - perlin(xs[i], ys[i], zs[i], 0)) > 1e-12) {
+            printf("FAILED: one octave of fbm does not match perlin()\n");
+            return 1;
+        }
+    }
+
+    const char* names[3] = {"fbm", "ridged", "turbulence"};
+    SO_FractalType types[3] = {SO_FRACTAL_FBM, SO_FRACTAL_RIDGED, SO_FRACTAL_TURBULENCE};
+    double repeats[2] = {0, 8};
+    std::vector<double> scalar(WIDTH*HEIGHT), batch(WIDTH*HEIGHT);
+    for (int t = 0; t < 3; t++) {
+        for (int r = 0; r < 2; r++) {
+            SO_FractalNoise fractal(types[t], 6, 1.0, 2.0, 0.5, repeats[r]);
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < WIDTH*HEIGHT; i++) {
+                scalar[i] = fractal.noise(xs[i], ys[i], zs[i]);
+            }
+            auto mid = std::chrono::steady_clock::now();
+            fractal.noiseBatch(&xs[0], &ys[0], &zs[0], &batch[0], WIDTH*HEIGHT);
+            auto end = std::chrono::steady_clock::now();
+
+            double maxDiff = 0, low = 1, high = 0;
+            for (int i = 0; i < WIDTH*HEIGHT; i++) {
+                maxDiff = std::fmax(maxDiff, std::fabs(scalar[i] - batch[i]));
+                low = std::fmin(low, batch[i]);
+                high = std::fmax(high, batch[i]);
+            }
+            double scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+            double batchTime = std::chrono::duration<double, std::milli>(end - mid).count();
+            printf("%-10s repeat %3.1f: noise() %8.2fms, noiseBatch() %8.2fms, speedup %5.2fx, range [%.3f, %.3f], max difference %g\n",
+                   names[t], repeats[r], scalarTime, batchTime, scalarTime/batchTime, low, high, maxDiff);
+            if (maxDiff > 1e-12) {
+                printf("FAILED: SO_FractalNoise::noiseBatch() does not match noise()\n");
+                return 1;
+            }
+            if (low < 0 || high > 1) {
+                printf("FAILED: SO_FractalNoise is outside [0, 1]\n");
+                return 1;
+            }
+            if (repeats[r] > 0) {
+                for (int i = 0; i < WIDTH*HEIGHT; i += 37) {
+                    double shifted = fractal.noise(xs[i] + repeats[r], ys[i] - 2*repeats[r], zs[i] + 3*repeats[r]);
+                    if (std::fabs(shifted - scalar[i]) > 1e-9) {
+                        printf("FAILED: SO_FractalNoise does not repeat every %g\n", repeats[r]);
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    //no octaves gives the midpoint of each type's range rather than dividing by zero
+    SO_FractalNoise empty(SO_FRACTAL_FBM, 0);
+    if (empty.noise(1.5, 2.5, 3.5) != 0.5) {
+        printf("FAILED: SO_FractalNoise with no octaves does not return 0.5\n");
+        return 1;
+    }
+
+    return 0;
+}
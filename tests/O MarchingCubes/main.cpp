@@ -0,0 +1,137 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <map>
+#include <array>
+#include <algorithm>
+
+using namespace sceneObjects;
+
+const int SIZE = 48;
+
+//checks every edge is shared by exactly 2 triangles, which run along it in opposite directions - so the mesh is closed and consistently wound
+bool closedAndConsistent(const SO_MeshData& mesh, const char* name) {
+    std::map<std::pair<int, int>, int> directedEdges;
+    for (size_t t = 0; t < mesh.faceElements.size(); t += 3) {
+        for (int e = 0; e < 3; e++) {
+            int a = mesh.faceElements[t + e];
+            int b = mesh.faceElements[t + (e + 1) % 3];
+            if (a == b) {
+                printf("FAILED: %s has a degenerate triangle\n", name);
+                return false;
+            }
+            if (++directedEdges[std::make_pair(a, b)] > 1) {
+                printf("FAILED: %s runs along the edge %d-%d twice in the same direction\n", name, a, b);
+                return false;
+            }
+        }
+    }
+    for (const auto& edge : directedEdges) {
+        if (directedEdges.find(std::make_pair(edge.first.second, edge.first.first)) == directedEdges.end()) {
+            printf("FAILED: %s has the edge %d-%d on only one triangle - the mesh is not closed\n", name, edge.first.first, edge.first.second);
+            return false;
+        }
+    }
+    return true;
+}
+
+//the triangles of a mesh as vertex positions, each rotated to start at its smallest corner and then sorted - independent of the vertex order
+std::vector<std::array<float, 9> > canonicalTriangles(const SO_MeshData& mesh) {
+    std::vector<std::array<float, 9> > triangles;
+    for (size_t t = 0; t < mesh.faceElements.size(); t += 3) {
+        std::array<std::array<float, 3>, 3> corners;
+        for (int c = 0; c < 3; c++) {
+            const glm::vec3& vertex = mesh.vertices[mesh.faceElements[t + c]];
+            corners[c] = {{vertex.x, vertex.y, vertex.z}};
+        }
+        int first = (int)(std::min_element(corners.begin(), corners.end()) - corners.begin());
+        std::array<float, 9> triangle;
+        for (int c = 0; c < 3; c++) {
+            std::copy(corners[(first + c) % 3].begin(), corners[(first + c) % 3].end(), triangle.begin() + 3*c);
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//the volume enclosed by a closed mesh - positive if the triangles are wound counter-clockwise seen from outside
+double enclosedVolume(const SO_MeshData& mesh) {
+    double volume = 0;
+    for (size_t t = 0; t < mesh.faceElements.size(); t += 3) {
+        glm::dvec3 a(mesh.vertices[mesh.faceElements[t]]);
+        glm::dvec3 b(mesh.vertices[mesh.faceElements[t + 1]]);
+        glm::dvec3 c(mesh.vertices[mesh.faceElements[t + 2]]);
+        volume += glm::dot(a, glm::cross(b, c))/6.0;
+    }
+    return volume;
+}
+
+//meshes the samples with several block sizes, checking each mesh is closed, consistently wound and the same as the others
+bool checkField(const std::vector<double>& samples, double spacing, double isoLevel, const char* name, SO_MeshData& mesh) {
+    mesh = marchingCubes<double>(&samples[0], SIZE, SIZE, SIZE, -1.0, -1.0, -1.0, spacing, spacing, spacing, isoLevel, 16);
+    if (mesh.faceElements.empty() || !closedAndConsistent(mesh, name)) {
+        printf("FAILED: %s is empty or not a closed, consistently wound mesh\n", name);
+        return false;
+    }
+    std::vector<std::array<float, 9> > triangles = canonicalTriangles(mesh);
+    const int blockSizes[3] = {1, 5, 64};
+    for (int blockSize : blockSizes) {
+        SO_MeshData other = marchingCubes<double>(&samples[0], SIZE, SIZE, SIZE, -1.0, -1.0, -1.0, spacing, spacing, spacing, isoLevel, blockSize);
+        if (other.vertices.size() != mesh.vertices.size() || canonicalTriangles(other) != triangles) {
+            printf("FAILED: %s changes with a blockSize of %d\n", name, blockSize);
+            return false;
+        }
+    }
+    printf("%s: %zu vertices, %zu triangles, closed and consistently wound for every blockSize\n", name, mesh.vertices.size(), mesh.faceElements.size()/3);
+    return true;
+}
+
+//meshes a sphere and a noise field clipped to the grid with marchingCubes(), and checks both give closed, consistently wound meshes whatever the blockSize
+int main(int argc, char *argv[]) {
+
+    double spacing = 2.0/(SIZE - 1);
+    std::vector<double> sphere(SIZE*SIZE*SIZE), noise(SIZE*SIZE*SIZE);
+    for (int k = 0; k < SIZE; k++) {
+        for (int j = 0; j < SIZE; j++) {
+            for (int i = 0; i < SIZE; i++) {
+                double x = -1.0 + i*spacing, y = -1.0 + j*spacing, z = -1.0 + k*spacing;
+                int index = i + j*SIZE + k*SIZE*SIZE;
+                sphere[index] = 0.8*0.8 - (x*x + y*y + z*z);
+                //the noise is forced below the level on the faces of the grid, so the surface never leaves it
+                bool border = i == 0 || j == 0 || k == 0 || i == SIZE - 1 || j == SIZE - 1 || k == SIZE - 1;
+                noise[index] = border ? 0.0 : perlin(4*x, 4*y, 4*z, 0);
+            }
+        }
+    }
+
+    SO_MeshData mesh;
+    if (!checkField(sphere, spacing, 0.0, "sphere", mesh)) {
+        return 1;
+    }
+    double volume = enclosedVolume(mesh);
+    double expected = 4.0/3.0*M_PI*0.8*0.8*0.8;
+    printf("sphere: enclosed volume %g, expected %g\n", volume, expected);
+    if (std::fabs(volume - expected) > 0.01*expected) {
+        printf("FAILED: the sphere is wound the wrong way or has the wrong volume\n");
+        return 1;
+    }
+    for (size_t v = 0; v < mesh.vertices.size(); v++) {
+        if (std::fabs(glm::length(mesh.vertices[v]) - 0.8) > 0.01 || glm::dot(mesh.normals[v], glm::normalize(mesh.vertices[v])) < 0.99f) {
+            printf("FAILED: sphere vertex %zu is off the sphere or its normal does not point outwards\n", v);
+            return 1;
+        }
+    }
+
+    if (!checkField(noise, spacing, 0.5, "clipped noise", mesh)) {
+        return 1;
+    }
+    if (enclosedVolume(mesh) <= 0) {
+        printf("FAILED: the clipped noise surface is wound the wrong way\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace sceneObjects;
+
+const int WIDTH = 37;
+const int DEPTH = 23;
+
+//the heights the test uses - a quadratic, so central differences give the exact slope
+float bowl(float x, float z) {
+    return 0.05f*x*x - 0.1f*x*z + 0.5f*z;
+}
+
+//checks one packed vertex against the position (x, h, z) and the normal of slopes (slopeX, slopeZ)
+bool checkVertex(const float* vertex, float x, float z, float h, float slopeX, float slopeZ, const char* name, int i, int j) {
+    glm::vec3 normal = glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ));
+    bool matches = std::fabs(vertex[0] - x) < 1e-4f && std::fabs(vertex[1] - h) < 1e-4f && std::fabs(vertex[2] - z) < 1e-4f &&
+                   std::fabs(vertex[3] - normal.x) < 1e-4f && std::fabs(vertex[4] - normal.y) < 1e-4f && std::fabs(vertex[5] - normal.z) < 1e-4f;
+    if (!matches) {
+        printf("FAILED: %s vertex (%d, %d) is (%g %g %g / %g %g %g), expected (%g %g %g / %g %g %g)\n", name, i, j,
+               vertex[0], vertex[1], vertex[2], vertex[3], vertex[4], vertex[5], x, h, z, normal.x, normal.y, normal.z);
+    }
+    return matches;
+}
+
+//checks the vertices, normals and triangles of SO_Heightfield on the CPU - no OpenGL context is made, as no buffers are created
+int main(int argc, char *argv[]) {
+
+    const float x0 = -3.0f, z0 = 2.0f, dx = 0.25f, dz = 0.5f;
+    SO_Heightfield field(WIDTH, DEPTH, x0, z0, dx, dz);
+    field.setHeights(bowl);
+
+    //every normal comes from central differences, except along the edges of the grid where they are one-sided
+    const std::vector<float>& vertices = field.getVertices();
+    if (vertices.size() != (size_t)WIDTH*DEPTH*6) {
+        printf("FAILED: getVertices() holds %zu floats, expected %d\n", vertices.size(), WIDTH*DEPTH*6);
+        return 1;
+    }
+    for (int j = 0; j < DEPTH; j++) {
+        for (int i = 0; i < WIDTH; i++) {
+            float x = x0 + i*dx, z = z0 + j*dz;
+            int left = i > 0 ? i - 1 : i, right = i + 1 < WIDTH ? i + 1 : i;
+            int back = j > 0 ? j - 1 : j, front = j + 1 < DEPTH ? j + 1 : j;
+            float slopeX = (bowl(x0 + right*dx, z) - bowl(x0 + left*dx, z))/((right - left)*dx);
+            float slopeZ = (bowl(x, z0 + front*dz) - bowl(x, z0 + back*dz))/((front - back)*dz);
+            if (!checkVertex(&vertices[6*(i + j*WIDTH)], x, z, bowl(x, z), slopeX, slopeZ, "setHeights()", i, j)) {
+                return 1;
+            }
+        }
+    }
+
+    //the triangle list is shared by grids of the same size, covers every cell and is wound counter-clockwise seen from above
+    SO_Heightfield same(WIDTH, DEPTH);
+    SO_Heightfield other(DEPTH, WIDTH);
+    std::shared_ptr<const std::vector<unsigned int>> elements = field.getElements();
+    if (same.getElements() != elements || SO_Heightfield::gridElements(WIDTH, DEPTH) != elements || other.getElements() == elements) {
+        printf("FAILED: gridElements() does not share one list between the heightfields of each size\n");
+        return 1;
+    }
+    if (elements->size() != (size_t)(WIDTH - 1)*(DEPTH - 1)*6) {
+        printf("FAILED: gridElements() has %zu indices, expected %d\n", elements->size(), (WIDTH - 1)*(DEPTH - 1)*6);
+        return 1;
+    }
+    double area = 0;
+    for (size_t t = 0; t < elements->size(); t += 3) {
+        glm::vec3 corners[3];
+        for (int c = 0; c < 3; c++) {
+            unsigned int index = (*elements)[t + c];
+            if (index >= (unsigned int)(WIDTH*DEPTH)) {
+                printf("FAILED: gridElements() index %u is out of range\n", index);
+                return 1;
+            }
+            corners[c] = glm::vec3(vertices[6*index], 0.0f, vertices[6*index + 2]);
+        }
+        float up = glm::cross(corners[1] - corners[0], corners[2] - corners[0]).y;
+        if (up <= 0) {
+            printf("FAILED: triangle %zu is not wound counter-clockwise seen from above\n", t/3);
+            return 1;
+        }
+        area += 0.5*up;
+    }
+    double expectedArea = (WIDTH - 1)*dx*(DEPTH - 1)*dz;
+    if (std::fabs(area - expectedArea) > 1e-6*expectedArea) {
+        printf("FAILED: the triangles cover an area of %g, expected %g\n", area, expectedArea);
+        return 1;
+    }
+
+    //a piece packed from bordered heights matches the whole heightfield's interior vertices, so pieces of a terrain meet without seams
+    const int pieceWidth = 13, pieceDepth = 9, firstX = 7, firstZ = 5;
+    std::vector<float> bordered((pieceWidth + 2)*(pieceDepth + 2));
+    for (int j = 0; j < pieceDepth + 2; j++) {
+        for (int i = 0; i < pieceWidth + 2; i++) {
+            bordered[i + j*(pieceWidth + 2)] = field.getHeights()[(firstX - 1 + i) + (firstZ - 1 + j)*WIDTH];
+        }
+    }
+    std::vector<float> packed(pieceWidth*pieceDepth*6);
+    SO_Heightfield::packVertices(&bordered[0], pieceWidth, pieceDepth, x0 + firstX*dx, z0 + firstZ*dz, dx, dz, &packed[0]);
+    for (int j = 0; j < pieceDepth; j++) {
+        for (int i = 0; i < pieceWidth; i++) {
+            const float* whole = &vertices[6*((firstX + i) + (firstZ + j)*WIDTH)];
+            float x = whole[0], z = whole[2];
+            float slopeX = (bowl(x + dx, z) - bowl(x - dx, z))/(2*dx);
+            float slopeZ = (bowl(x, z + dz) - bowl(x, z - dz))/(2*dz);
+            if (!checkVertex(&packed[6*(i + j*pieceWidth)], x, z, whole[1], slopeX, slopeZ, "packVertices()", i, j)) {
+                return 1;
+            }
+            for (int c = 3; c < 6; c++) {
+                if (packed[6*(i + j*pieceWidth) + c] != whole[c]) {
+                    printf("FAILED: packVertices() normal (%d, %d) differs from the whole heightfield's\n", i, j);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    //along the border of a packed piece the normals use the border samples - here a plane, so every normal is the same
+    for (int j = 0; j < pieceDepth + 2; j++) {
+        for (int i = 0; i < pieceWidth + 2; i++) {
+            bordered[i + j*(pieceWidth + 2)] = 0.3f*(i - 1)*dx - 0.7f*(j - 1)*dz;
+        }
+    }
+    SO_Heightfield::packVertices(&bordered[0], pieceWidth, pieceDepth, 0.0f, 0.0f, dx, dz, &packed[0]);
+    for (int j = 0; j < pieceDepth; j++) {
+        for (int i = 0; i < pieceWidth; i++) {
+            if (!checkVertex(&packed[6*(i + j*pieceWidth)], i*dx, j*dz, 0.3f*i*dx - 0.7f*j*dz, 0.3f, -0.7f, "packVertices() plane", i, j)) {
+                return 1;
+            }
+        }
+    }
+
+    printf("SO_Heightfield: vertices, normals, shared elements and packVertices() borders all match\n");
+    return 0;
+}
@@ -0,0 +1,264 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <map>
+
+using namespace sceneObjects;
+
+const size_t COUNT = 1000003;
+
+//checks getLerpColorBatch() and getLerpColorBatchRGBA8() against getLerpColor() value by value - `reference` must be baked as the batch forms use a table
+bool checkBatch(const SO_ColorMap& map, const SO_ColorMap& reference, const std::vector<float>& values, size_t grainSize, const char* name) {
+    size_t count = values.size();
+    //one extra element past the end of each output, which must be left alone
+    std::vector<float> rgb(3*count + 1, -7.0f);
+    std::vector<unsigned char> rgba(4*count + 1, 7);
+    map.getLerpColorBatch(0.0f, 100.0f, &values[0], &rgb[0], count, grainSize);
+    map.getLerpColorBatchRGBA8(0.0f, 100.0f, &values[0], &rgba[0], count, grainSize);
+    if (rgb[3*count] != -7.0f || rgba[4*count] != 7) {
+        printf("FAILED: %s wrote past the end of the output\n", name);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 color = reference.getLerpColor(0.0f, 100.0f, values[i]);
+        //compared bit for bit, so NaN results must match too
+        if (std::memcmp(&color[0], &rgb[3*i], 3*sizeof(float)) != 0) {
+            printf("FAILED: %s getLerpColorBatch() gives (%.9g %.9g %.9g) for %g, getLerpColor() gives (%.9g %.9g %.9g)\n", name,
+                   rgb[3*i], rgb[3*i + 1], rgb[3*i + 2], values[i], color.x, color.y, color.z);
+            return false;
+        }
+        for (int c = 0; c < 3; c++) {
+            float clamped = std::min(std::max(color[c], 0.0f), 1.0f);
+            if (rgba[4*i + c] != (unsigned char)(clamped*255.0f + 0.5f)) {
+                printf("FAILED: %s getLerpColorBatchRGBA8() gives %d for channel %d of %g, expected %d\n", name, rgba[4*i + c], c, values[i],
+                       (int)(unsigned char)(clamped*255.0f + 0.5f));
+                return false;
+            }
+        }
+        if (rgba[4*i + 3] != 255) {
+            printf("FAILED: %s getLerpColorBatchRGBA8() gives an alpha of %d, expected 255\n", name, rgba[4*i + 3]);
+            return false;
+        }
+    }
+    return true;
+}
+
+//getLerpColor() as it was when the keys were held in a std::map - walking the keys in order to the first at or above the value
+glm::vec3 mapWalkLerpColor(const std::map<float, glm::vec3>& keys, float min, float max, float value) {
+    if (keys.empty()) {
+        return glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+    value = (value - min)/(max - min);
+    if (value <= keys.begin()->first) {
+        return keys.begin()->second;
+    }
+    for (auto it = std::next(keys.begin()); it != keys.end(); ++it) {
+        if (value <= it->first) {
+            auto prev = std::prev(it);
+            return lerp(prev->second, it->second, (value - prev->first)/(it->first - prev->first));
+        }
+    }
+    return std::prev(keys.end())->second;
+}
+
+//checks the binary search over the sorted keys against the std::map walk for maps of 0 to 39 keys built by setValue() and deleteValue()
+bool checkKeySearch(void) {
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> distribution(-0.5f, 1.5f);
+    for (int trial = 0; trial < 200; trial++) {
+        SO_ColorMap map;
+        std::map<float, glm::vec3> keys;
+        int keyCount = trial % 40;
+        //positions on a grid of 0.05, so keys are set again and deleted keys often exist
+        for (int k = 0; k < keyCount; k++) {
+            float position = std::round(distribution(generator)*20.0f)/20.0f;
+            glm::vec3 color(distribution(generator), distribution(generator), distribution(generator));
+            map.setValue(position, color);
+            keys[position] = color;
+        }
+        for (int k = 0; k < keyCount/3; k++) {
+            float position = std::round(distribution(generator)*20.0f)/20.0f;
+            map.deleteValue(position);
+            keys.erase(position);
+        }
+        if (map.getSize() != keys.size()) {
+            printf("FAILED: the map has %zu keys, expected %zu\n", map.getSize(), keys.size());
+            return false;
+        }
+        size_t index = 0;
+        for (const auto& key : keys) {
+            if (map.getPositions()[index] != key.first || std::memcmp(&map.getColors()[index][0], &key.second[0], sizeof(glm::vec3)) != 0) {
+                printf("FAILED: key %zu is at %g, expected %g\n", index, map.getPositions()[index], key.first);
+                return false;
+            }
+            index++;
+        }
+        for (int k = 0; k < 500; k++) {
+            float value = distribution(generator)*10.0f;
+            if (k < 4) {
+                const float special[4] = {NAN, INFINITY, -INFINITY, keys.empty() ? 0.0f : keys.rbegin()->first*10.0f};
+                value = special[k];
+            }
+            glm::vec3 color = map.getLerpColor(0.0f, 10.0f, value);
+            glm::vec3 expected = mapWalkLerpColor(keys, 0.0f, 10.0f, value);
+            if (std::memcmp(&color[0], &expected[0], sizeof(glm::vec3)) != 0) {
+                printf("FAILED: getLerpColor() of %g with %zu keys is (%.9g %.9g %.9g), the map walk gives (%.9g %.9g %.9g)\n", value, keys.size(),
+                       color.x, color.y, color.z, expected.x, expected.y, expected.z);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//checks findRange() against the sorted finite values - the extremes exactly, and the percentiles to within a bin of the full range
+bool checkFindRange(void) {
+    std::mt19937 generator(5);
+    std::normal_distribution<float> distribution(50.0f, 10.0f);
+    const size_t counts[6] = {0, 1, 3, 7, 1000, 200003};
+    for (size_t count : counts) {
+        std::vector<float> values(count);
+        for (float& value : values) {
+            value = distribution(generator);
+        }
+        //outliers, and a third of the values not finite - which must not count towards the percentiles
+        if (count > 10) {
+            values[6] = 1e6f;
+            values[7] = -1e6f;
+            for (size_t i = 8; i < count; i += 3) {
+                const float special[3] = {NAN, INFINITY, -INFINITY};
+                values[i] = special[i % 3];
+            }
+        }
+        std::vector<float> finite;
+        for (float value : values) {
+            if (std::isfinite(value)) {
+                finite.push_back(value);
+            }
+        }
+        std::sort(finite.begin(), finite.end());
+
+        glm::vec2 range = SO_ColorMap::findRange(count ? &values[0] : nullptr, count, 0.0f, 100.0f, 4096, 1000);
+        glm::vec2 expected = finite.empty() ? glm::vec2(0.0f, 0.0f) : glm::vec2(finite.front(), finite.back());
+        if (range.x != expected.x || range.y != expected.y) {
+            printf("FAILED: findRange() of %zu values is (%g, %g), expected (%g, %g)\n", count, range.x, range.y, expected.x, expected.y);
+            return false;
+        }
+        if (finite.size() > 100) {
+            range = SO_ColorMap::findRange(&values[0], count, 1.0f, 99.0f, 4096, 1000);
+            expected = glm::vec2(finite[(size_t)(0.01*finite.size())], finite[(size_t)(0.99*finite.size())]);
+            float tolerance = 1.01f*(finite.back() - finite.front())/4096;
+            printf("findRange():  %zu values, 1st percentile %g (expected %g), 99th percentile %g (expected %g)\n", count, range.x, expected.x, range.y, expected.y);
+            if (std::fabs(range.x - expected.x) > tolerance || std::fabs(range.y - expected.y) > tolerance) {
+                printf("FAILED: findRange() percentiles are off by more than a bin\n");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//checks the key search, findRange() and the batch colour mapping of SO_ColorMap against reference results, and times them
+int main(int argc, char *argv[]) {
+
+    if (!checkKeySearch() || !checkFindRange()) {
+        return 1;
+    }
+
+    //with many keys the binary search takes a few steps where the walk takes up to one per key
+    SO_ColorMap longMap;
+    std::map<float, glm::vec3> longKeys;
+    for (int k = 0; k < 256; k++) {
+        glm::vec3 color(k/255.0f, 1.0f - k/255.0f, 0.5f);
+        longMap.setValue(k/255.0f, color);
+        longKeys[k/255.0f] = color;
+    }
+    std::vector<float> lookups(1 << 20);
+    std::mt19937 lookupGenerator(5);
+    std::uniform_real_distribution<float> lookupDistribution(-0.5f, 1.5f);
+    for (float& value : lookups) {
+        value = lookupDistribution(lookupGenerator);
+    }
+    float searchSum = 0;
+    auto searchStart = std::chrono::steady_clock::now();
+    for (float value : lookups) {
+        searchSum += mapWalkLerpColor(longKeys, 0.0f, 1.0f, value).x;
+    }
+    auto searchMid = std::chrono::steady_clock::now();
+    for (float value : lookups) {
+        searchSum += longMap.getLerpColor(0.0f, 1.0f, value).x;
+    }
+    auto searchEnd = std::chrono::steady_clock::now();
+    double walkTime = std::chrono::duration<double, std::milli>(searchMid - searchStart).count();
+    double searchTime = std::chrono::duration<double, std::milli>(searchEnd - searchMid).count();
+    printf("256 keys:     std::map walk %8.2fms, getLerpColor() %8.2fms, speedup %5.2fx (%g)\n", walkTime, searchTime, walkTime/searchTime, searchSum);
+
+    SO_ColorMap map;
+    map.setValue(0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+    map.setValue(0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    map.setValue(0.7f, glm::vec3(1.0f, 1.0f, 0.0f));
+    map.setValue(1.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+
+    //values beyond the ends of the map, at the keys and not numbers at all
+    std::vector<float> values(COUNT);
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(-20.0f, 120.0f);
+    for (float& value : values) {
+        value = distribution(generator);
+    }
+    const float special[] = {NAN, INFINITY, -INFINITY, 0.0f, 30.0f, 70.0f, 100.0f, -0.0f};
+    std::copy(special, special + sizeof(special)/sizeof(float), values.begin() + 5);
+
+    //an unbaked map uses a table of the default resolution for the call, so it matches a baked copy
+    SO_ColorMap baked = map;
+    baked.bake();
+    if (!checkBatch(map, baked, values, 65536, "unbaked map")) {
+        return 1;
+    }
+    map.bake(4096);
+    const size_t grainSizes[3] = {1000, 65536, COUNT};
+    for (size_t grainSize : grainSizes) {
+        if (!checkBatch(map, map, values, grainSize, "map baked at 4096")) {
+            return 1;
+        }
+    }
+    //counts which aren't a multiple of 4 leave a tail after the SSE2 loop
+    for (size_t count = 1; count < 12; count++) {
+        if (!checkBatch(map, map, std::vector<float>(values.begin(), values.begin() + count), 65536, "short batch")) {
+            return 1;
+        }
+    }
+
+    //an empty map is black, and opaque in RGBA8
+    SO_ColorMap empty;
+    if (!checkBatch(empty, empty, std::vector<float>(values.begin(), values.begin() + 100), 65536, "empty map")) {
+        return 1;
+    }
+
+    const size_t timedCount = 16 << 20;
+    std::vector<float> timed(timedCount);
+    for (size_t i = 0; i < timedCount; i++) {
+        timed[i] = (i % 1000)*0.1f;
+    }
+    std::vector<float> rgb(3*timedCount);
+    float sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < timedCount; i++) {
+        sum += map.getLerpColor(0.0f, 100.0f, timed[i]).y;
+    }
+    auto mid = std::chrono::steady_clock::now();
+    map.getLerpColorBatch(0.0f, 100.0f, &timed[0], &rgb[0], timedCount);
+    auto end = std::chrono::steady_clock::now();
+    double scalarTime = std::chrono::duration<double, std::milli>(mid - start).count();
+    double batchTime = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("baked map:    getLerpColor() %8.2fms, getLerpColorBatch() %8.2fms, speedup %5.2fx (%g)\n", scalarTime, batchTime, scalarTime/batchTime, sum);
+
+    printf("SO_ColorMap key search matches the std::map walk, findRange() the sorted values and batch mapping getLerpColor()\n");
+    return 0;
+}
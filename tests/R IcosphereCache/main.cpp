@@ -0,0 +1,140 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <stdexcept>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+using namespace sceneObjects;
+
+const int THREADS = 8;
+
+//checks cachedIcosphere() shares one mesh per level across threads and icosphereBuffers() one pair of buffers, which are deleted with the last handle
+int main(int argc, char *argv[]) {
+
+    //a hidden window, just for the OpenGL context icosphereBuffers() needs
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "OpenGL", nullptr, nullptr);
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    //many threads asking for the same few levels at once get one mesh per level
+    std::vector<std::shared_ptr<const SO_MeshData>> handles;
+    std::mutex handleMutex;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 500; i++) {
+                std::shared_ptr<const SO_MeshData> mesh = cachedIcosphere(1 + (i + t) % 6);
+                std::lock_guard<std::mutex> lock(handleMutex);
+                handles.push_back(mesh);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::set<const SO_MeshData*> distinct;
+    for (const std::shared_ptr<const SO_MeshData>& handle : handles) {
+        distinct.insert(handle.get());
+    }
+    printf("cachedIcosphere(): %d lookups of 6 levels over %d threads in %.2fms\n", THREADS*500, THREADS, std::chrono::duration<double, std::milli>(end - start).count());
+    if (distinct.size() != 6) {
+        printf("FAILED: cachedIcosphere() made %zu meshes for 6 levels\n", distinct.size());
+        return 1;
+    }
+    for (int level = 1; level <= 6; level++) {
+        SO_MeshData created = createIcosphere(level);
+        std::shared_ptr<const SO_MeshData> cached = cachedIcosphere(level);
+        if (cached->faceElements != created.faceElements || cached->vertices.size() != created.vertices.size()) {
+            printf("FAILED: cachedIcosphere(%d) does not match createIcosphere(%d)\n", level, level);
+            return 1;
+        }
+    }
+
+    //a large level is built once however many threads ask for it, and a small level can be fetched while it is being built
+    std::vector<std::shared_ptr<const SO_MeshData>> large(THREADS);
+    threads.clear();
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            large[t] = cachedIcosphere(400);
+        });
+    }
+    start = std::chrono::steady_clock::now();
+    std::shared_ptr<const SO_MeshData> small = cachedIcosphere(7);
+    end = std::chrono::steady_clock::now();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    printf("cachedIcosphere(7) took %.3fms while level 400 was being built\n", std::chrono::duration<double, std::milli>(end - start).count());
+    for (int t = 1; t < THREADS; t++) {
+        if (large[t] != large[0]) {
+            printf("FAILED: cachedIcosphere(400) was built more than once\n");
+            return 1;
+        }
+    }
+    if (large[0]->faceElements.size() != (size_t)60*400*400 || small->faceElements.size() != (size_t)60*7*7) {
+        printf("FAILED: cachedIcosphere() returned the wrong level\n");
+        return 1;
+    }
+    large.clear();
+
+    //the buffers are shared while a handle is held, and deleted with the last one
+    std::shared_ptr<const SO_MeshData> mesh = cachedIcosphere(5);
+    std::shared_ptr<const SO_IcosphereBuffers> buffers = icosphereBuffers(5);
+    std::shared_ptr<const SO_IcosphereBuffers> same = icosphereBuffers(5);
+    if (same != buffers || buffers->mesh != mesh || buffers->elementCount != (GLsizei)mesh->faceElements.size()) {
+        printf("FAILED: icosphereBuffers(5) is not shared, or does not hold cachedIcosphere(5)\n");
+        return 1;
+    }
+    GLint size;
+    glBindBuffer(GL_ARRAY_BUFFER, buffers->vbo);
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+    GLint elementSize;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffers->ebo);
+    glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &elementSize);
+    if (size != (GLint)(mesh->vertices.size()*sizeof(glm::vec3)) || elementSize != (GLint)(mesh->faceElements.size()*sizeof(int))) {
+        printf("FAILED: the icosphere buffers hold %d and %d bytes\n", size, elementSize);
+        return 1;
+    }
+    GLuint vbo = buffers->vbo, ebo = buffers->ebo;
+    buffers.reset();
+    if (!glIsBuffer(vbo)) {
+        printf("FAILED: the icosphere buffers were deleted while a handle was held\n");
+        return 1;
+    }
+    same.reset();
+    if (glIsBuffer(vbo) || glIsBuffer(ebo)) {
+        printf("FAILED: the icosphere buffers were not deleted with the last handle\n");
+        return 1;
+    }
+
+    try {
+        cachedIcosphere(0);
+        printf("FAILED: cachedIcosphere(0) did not throw\n");
+        return 1;
+    } catch (std::invalid_argument&) {
+    }
+    if (glGetError() != GL_NO_ERROR) {
+        printf("FAILED: OpenGL error\n");
+        return 1;
+    }
+
+    glfwTerminate();
+
+    printf("cachedIcosphere() and icosphereBuffers() share their meshes and buffers\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+using namespace sceneObjects;
+
+//checks the triangles SO_Terrain::chunkElements() gives one cell count and set of side level differences - returns false after printing what is wrong
+bool checkElements(int cells, const int lodSteps[4]) {
+    std::vector<unsigned int> elements = SO_Terrain::chunkElements(cells, lodSteps);
+    int size = cells + 1;
+    char name[64];
+    snprintf(name, sizeof(name), "cells %d, lodSteps {%d, %d, %d, %d}", cells, lodSteps[0], lodSteps[1], lodSteps[2], lodSteps[3]);
+    if (elements.empty() || elements.size() % 3 != 0) {
+        printf("FAILED: %s gives %d indices\n", name, (int)elements.size());
+        return false;
+    }
+
+    //the step each side's vertices must be a multiple of - chunkElements() never steps further than a whole side
+    int steps[4];
+    for (int side = 0; side < 4; side++) {
+        steps[side] = 1;
+        for (int d = 0; d < lodSteps[side] && steps[side]*2 <= cells; d++) {
+            steps[side] *= 2;
+        }
+    }
+
+    long long doubleArea = 0;
+    std::vector<std::pair<unsigned int, unsigned int> > edges; //directed edges of every triangle
+    for (size_t t = 0; t < elements.size(); t += 3) {
+        int i[3], j[3];
+        for (int k = 0; k < 3; k++) {
+            if (elements[t + k] >= (unsigned int)(size*size)) {
+                printf("FAILED: %s has an index %u out of range\n", name, elements[t + k]);
+                return false;
+            }
+            i[k] = elements[t + k] % size;
+            j[k] = elements[t + k]/size;
+            //the vertex (t along the side) of a side must be a multiple of that side's step
+            int along[4] = {j[k] == 0 ? i[k] : 0, i[k] == cells ? j[k] : 0, j[k] == cells ? i[k] : 0, i[k] == 0 ? j[k] : 0};
+            for (int side = 0; side < 4; side++) {
+                if (along[side] % steps[side] != 0) {
+                    printf("FAILED: %s uses vertex %d of side %d, which is not a multiple of %d\n", name, along[side], side, steps[side]);
+                    return false;
+                }
+            }
+        }
+        //counter-clockwise seen from +y, as in chunkElements()
+        int winding = (j[1] - j[0])*(i[2] - i[0]) - (i[1] - i[0])*(j[2] - j[0]);
+        if (winding <= 0) {
+            printf("FAILED: %s has a triangle (%d,%d) (%d,%d) (%d,%d) which is %s\n", name, i[0], j[0], i[1], j[1], i[2], j[2],
+                   winding == 0 ? "degenerate" : "clockwise");
+            return false;
+        }
+        doubleArea += winding;
+        for (int k = 0; k < 3; k++) {
+            edges.push_back(std::make_pair(elements[t + k], elements[t + (k + 1)%3]));
+        }
+    }
+    if (doubleArea != 2LL*cells*cells) {
+        printf("FAILED: %s has triangles with a total area of %g rather than %d\n", name, doubleArea*0.5, cells*cells);
+        return false;
+    }
+
+    //consistently wound triangles share an interior edge in opposite directions, so each directed edge is used once, and has its
+    //reverse unless it lies along the edge of the chunk
+    std::sort(edges.begin(), edges.end());
+    for (size_t e = 0; e < edges.size(); e++) {
+        int ai = edges[e].first % size, aj = edges[e].first/size;
+        int bi = edges[e].second % size, bj = edges[e].second/size;
+        bool boundary = (aj == 0 && bj == 0) || (ai == cells && bi == cells) || (aj == cells && bj == cells) || (ai == 0 && bi == 0);
+        bool repeated = e + 1 < edges.size() && edges[e + 1] == edges[e];
+        bool reversed = std::binary_search(edges.begin(), edges.end(), std::make_pair(edges[e].second, edges[e].first));
+        if (repeated || reversed == boundary) {
+            printf("FAILED: %s has the %s edge (%d,%d)-(%d,%d) used by %s\n", name, boundary ? "boundary" : "interior", ai, aj, bi, bj,
+                   repeated ? "two triangles wound the same way" : (reversed ? "two triangles" : "one triangle"));
+            return false;
+        }
+    }
+    return true;
+}
+
+//checks the stitched triangles of every chunk size SO_Terrain uses against every combination of side level differences it can ask for
+int main(int argc, char *argv[]) {
+
+    int combinations = 0;
+    for (int cells = 2; cells <= 64; cells *= 2) {
+        //a neighbour is at most as coarse as a single cell across the chunk
+        int maxStep = 0;
+        while ((1 << (maxStep + 1)) <= cells) {
+            maxStep++;
+        }
+        int lodSteps[4];
+        for (lodSteps[0] = 0; lodSteps[0] <= maxStep; lodSteps[0]++) {
+            for (lodSteps[1] = 0; lodSteps[1] <= maxStep; lodSteps[1]++) {
+                for (lodSteps[2] = 0; lodSteps[2] <= maxStep; lodSteps[2]++) {
+                    for (lodSteps[3] = 0; lodSteps[3] <= maxStep; lodSteps[3]++) {
+                        if (!checkElements(cells, lodSteps)) {
+                            return 1;
+                        }
+                        combinations++;
+                    }
+                }
+            }
+        }
+    }
+    printf("chunkElements(): %d combinations of cell count and side level differences are closed, counter-clockwise and stitched\n", combinations);
+
+    return 0;
+}
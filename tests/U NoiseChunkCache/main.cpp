@@ -0,0 +1,179 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+using namespace sceneObjects;
+
+const size_t SMALL_SAMPLES = 100; //800 bytes a chunk
+const size_t LARGE_SAMPLES = 1000; //8000 bytes a chunk
+
+std::atomic<int> calls(0); //the number of times any generator has run
+std::atomic<int> failures(0); //the number of generator calls still to throw
+
+//held shut to keep chunks of the gated layer pending
+std::mutex gateMutex;
+std::condition_variable gateChanged;
+bool gateOpen = true;
+
+void setGate(bool open) {
+    std::lock_guard<std::mutex> lock(gateMutex);
+    gateOpen = open;
+    gateChanged.notify_all();
+}
+
+//fills every sample with the chunk's x, throwing instead while `failures` is positive
+void generate(const SO_ChunkKey& key, double* samples, size_t count) {
+    calls++;
+    if (failures.fetch_sub(1) > 0) {
+        throw std::runtime_error("generator failed on chunk " + std::to_string(key.x));
+    }
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = key.x;
+    }
+}
+
+//polls `done` for up to 10 seconds
+bool waitFor(const std::function<bool(void)>& done) {
+    for (int i = 0; i < 10000; i++) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
+
+//getChunk() until the chunk arrives - returns an empty pointer on timeout
+SO_NoiseChunkCache::SO_Chunk fetch(SO_NoiseChunkCache& cache, const SO_ChunkKey& key) {
+    SO_NoiseChunkCache::SO_Chunk chunk;
+    waitFor([&]() { return (chunk = cache.getChunk(key)) != nullptr; });
+    return chunk;
+}
+
+#define CHECK(condition, message) if (!(condition)) { printf("FAILED: %s\n", message); return 1; }
+
+//checks SO_NoiseChunkCache's eviction order and budget, clear(), error reporting and pending limit with generators which count their calls and can throw
+int main(int argc, char *argv[]) {
+
+    SO_NoiseChunkCache cache(3*SMALL_SAMPLES*sizeof(double), 2);
+    int small = cache.addLayer(SMALL_SAMPLES, [](const SO_ChunkKey& key, double* samples) { generate(key, samples, SMALL_SAMPLES); });
+    int large = cache.addLayer(LARGE_SAMPLES, [](const SO_ChunkKey& key, double* samples) { generate(key, samples, LARGE_SAMPLES); });
+    int gated = cache.addLayer(SMALL_SAMPLES, [](const SO_ChunkKey& key, double* samples) {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        gateChanged.wait(lock, []() { return gateOpen; });
+        lock.unlock();
+        generate(key, samples, SMALL_SAMPLES);
+    });
+
+    //least recently used chunks are dropped first once the cache is over its budget
+    for (int x = 0; x < 3; x++) {
+        SO_NoiseChunkCache::SO_Chunk chunk = fetch(cache, SO_ChunkKey(small, x));
+        CHECK(chunk && chunk->size() == SMALL_SAMPLES && (*chunk)[0] == x, "getChunk() did not return the generated samples");
+    }
+    CHECK(calls == 3, "the generator did not run once per chunk");
+    CHECK(cache.getChunk(SO_ChunkKey(small, 0)) != nullptr, "a generated chunk was not kept"); //now chunk 0 is the most recently used
+    CHECK(calls == 3, "getChunk() of a generated chunk ran the generator again");
+    fetch(cache, SO_ChunkKey(small, 3));
+    CHECK(!cache.isReady(SO_ChunkKey(small, 1)), "adding a 4th chunk did not drop the least recently used one");
+    CHECK(cache.isReady(SO_ChunkKey(small, 0)) && cache.isReady(SO_ChunkKey(small, 2)) && cache.isReady(SO_ChunkKey(small, 3)),
+          "adding a 4th chunk dropped a more recently used one");
+    CHECK(cache.getChunkCount() == 3 && cache.getBytesUsed() == 3*SMALL_SAMPLES*sizeof(double), "the cache does not hold 3 chunks' bytes");
+    cache.setByteBudget(2*SMALL_SAMPLES*sizeof(double));
+    CHECK(!cache.isReady(SO_ChunkKey(small, 2)) && cache.isReady(SO_ChunkKey(small, 0)) && cache.isReady(SO_ChunkKey(small, 3)),
+          "setByteBudget() did not drop the least recently used chunk");
+    printf("eviction: least recently used chunks dropped first\n");
+
+    //the newest chunk is kept even when it alone is over the budget - and chunks still held stay valid after being dropped
+    SO_NoiseChunkCache::SO_Chunk held = cache.getChunk(SO_ChunkKey(small, 0));
+    SO_NoiseChunkCache::SO_Chunk oversized = fetch(cache, SO_ChunkKey(large, 0));
+    CHECK(oversized && oversized->size() == LARGE_SAMPLES, "an oversized chunk was not returned");
+    CHECK(cache.getChunkCount() == 1 && cache.isReady(SO_ChunkKey(large, 0)), "the oversized chunk was not the only one kept");
+    CHECK(cache.getBytesUsed() == LARGE_SAMPLES*sizeof(double), "the cache does not hold the oversized chunk's bytes");
+    CHECK(held->size() == SMALL_SAMPLES && (*held)[0] == 0, "a dropped chunk still in use was changed");
+    printf("eviction: oversized newest chunk kept\n");
+    cache.setByteBudget(3*SMALL_SAMPLES*sizeof(double));
+
+    //a chunk which finishes after clear() is discarded, and asking again generates it again
+    cache.clear();
+    CHECK(cache.getChunkCount() == 0 && cache.getBytesUsed() == 0, "clear() did not drop every chunk");
+    calls = 0;
+    setGate(false);
+    cache.request(SO_ChunkKey(gated, 0));
+    CHECK(cache.getPendingCount() == 1, "request() did not queue the chunk");
+    cache.clear();
+    setGate(true);
+    CHECK(waitFor([&]() { return cache.getPendingCount() == 0; }), "the pending chunk never finished");
+    CHECK(calls == 1, "the generator did not run for the pending chunk");
+    CHECK(!cache.isReady(SO_ChunkKey(gated, 0)) && cache.getChunkCount() == 0, "a chunk finishing after clear() was kept");
+    CHECK(fetch(cache, SO_ChunkKey(gated, 0)) != nullptr && calls == 2, "a chunk discarded by clear() was not generated again");
+    printf("clear(): chunks still pending discarded\n");
+
+    //getChunk() rethrows a generator error once, then queues the chunk again
+    calls = 0;
+    failures = 1;
+    CHECK(cache.getChunk(SO_ChunkKey(small, 10)) == nullptr, "getChunk() returned a chunk before generating it");
+    CHECK(waitFor([&]() { return cache.getPendingCount() == 0; }), "the failing chunk never finished");
+    bool thrown = false;
+    try {
+        cache.getChunk(SO_ChunkKey(small, 10));
+    } catch (const std::runtime_error& error) {
+        thrown = strcmp(error.what(), "generator failed on chunk 10") == 0;
+    }
+    CHECK(thrown, "getChunk() did not rethrow the generator's exception");
+    CHECK(cache.getChunk(SO_ChunkKey(small, 10)) == nullptr, "getChunk() rethrew the generator's exception twice");
+    SO_NoiseChunkCache::SO_Chunk retried = fetch(cache, SO_ChunkKey(small, 10));
+    CHECK(retried && (*retried)[0] == 10 && calls == 2, "the failed chunk was not generated again after the error was reported");
+
+    //request() drops the error and queues the chunk again without throwing
+    calls = 0;
+    failures = 1;
+    cache.request(SO_ChunkKey(small, 11));
+    CHECK(waitFor([&]() { return cache.getPendingCount() == 0; }), "the failing chunk never finished");
+    try {
+        cache.request(SO_ChunkKey(small, 11));
+    } catch (...) {
+        CHECK(false, "request() rethrew the generator's exception");
+    }
+    CHECK(waitFor([&]() { return cache.isReady(SO_ChunkKey(small, 11)); }) && calls == 2, "request() did not queue the failed chunk again");
+    CHECK(cache.getChunk(SO_ChunkKey(small, 11)) != nullptr, "getChunk() did not return the chunk request() generated again");
+    printf("errors: getChunk() rethrows once, request() discards, both retry\n");
+
+    //no more than maxPending chunks are generated at once - the rest are turned away rather than queued
+    cache.clear();
+    calls = 0;
+    setGate(false);
+    for (int x = 0; x < 5; x++) {
+        cache.request(SO_ChunkKey(gated, x));
+    }
+    CHECK(cache.getPendingCount() == 2, "more than maxPending chunks were queued");
+    CHECK(cache.getChunk(SO_ChunkKey(gated, 4)) == nullptr && cache.getPendingCount() == 2, "getChunk() queued a chunk past maxPending");
+    setGate(true);
+    CHECK(waitFor([&]() { return cache.getPendingCount() == 0; }), "the pending chunks never finished");
+    CHECK(calls == 2, "chunks turned away by maxPending were generated");
+    CHECK(cache.isReady(SO_ChunkKey(gated, 0)) && cache.isReady(SO_ChunkKey(gated, 1)), "the chunks within maxPending were not generated");
+    for (int x = 2; x < 5; x++) {
+        CHECK(!cache.isReady(SO_ChunkKey(gated, x)), "a chunk turned away by maxPending was generated");
+    }
+    CHECK(fetch(cache, SO_ChunkKey(gated, 4)) != nullptr, "a chunk turned away by maxPending could not be asked for again");
+    printf("maxPending: at most 2 chunks generated at once\n");
+
+    //an unknown layer is an error
+    thrown = false;
+    try {
+        cache.getChunk(SO_ChunkKey(7));
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    CHECK(thrown, "getChunk() of an unknown layer did not throw");
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sceneObjects;
+
+const int SIZE = 64; //the render target is SIZE x SIZE texels
+const float SPACING = 1.0f/16; //noise space units between texel centres in the raw noise check
+
+//a framebuffer with a float colour texture and a float depth texture, for reading back exactly what the shaders wrote
+struct Target {
+    GLuint fbo, color, depth;
+    Target(void) {
+        glGenTextures(1, &color);
+        glBindTexture(GL_TEXTURE_2D, color);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SIZE, SIZE, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glGenTextures(1, &depth);
+        glBindTexture(GL_TEXTURE_2D, depth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, SIZE, SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    }
+    ~Target(void) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &color);
+        glDeleteTextures(1, &depth);
+    }
+};
+
+//draws perlinShaderSource()'s noise at texel centres and the noise options of SO_PhongShader into float textures and compares them with perlin(),
+//then shows a noise coloured, noise displaced icosphere with its pattern drifting over time
+int main(int argc, char *argv[]) {
+
+    //set up window
+    glfwInit();
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 800, "OpenGL", nullptr, nullptr); // Windowed
+
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    GLuint permsTexture = createPerlinPermsTexture();
+    glActiveTexture(GL_TEXTURE3); // the default noise texture unit of SO_PhongShader
+    glBindTexture(GL_TEXTURE_1D, permsTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    {
+        Target target;
+        glViewport(0, 0, SIZE, SIZE);
+        std::vector<float> pixels(4*SIZE*SIZE);
+
+        //the raw GLSL noise, one sample per texel centre - a single triangle covering the target needs no vertex data
+        const char* vertexSource = R"glsl(
+            #version 330 core
+            void main() {
+                gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0);
+            }
+        )glsl";
+        std::string fragmentSource = R"glsl(
+            #version 330 core
+            uniform float spacing;
+            uniform float z;
+            uniform float repeat;
+            out vec4 outColor;)glsl" + perlinShaderSource() + R"glsl(
+            void main() {
+                outColor = vec4(perlin(vec3(gl_FragCoord.xy*spacing, z), repeat), 0.0, 0.0, 1.0);
+            }
+        )glsl";
+        SO_Shader noiseShader;
+        noiseShader.createVertexShader(vertexSource);
+        noiseShader.createFragmentShader(fragmentSource.c_str());
+        noiseShader.linkProgram();
+        GLuint program = noiseShader.getProgramID();
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "perlinPerms"), 3);
+        glUniform1f(glGetUniformLocation(program, "spacing"), SPACING);
+        glUniform1f(glGetUniformLocation(program, "z"), 0.3f);
+
+        float repeats[2] = {0.0f, 2.0f};
+        for (int r = 0; r < 2; r++) {
+            glUniform1f(glGetUniformLocation(program, "repeat"), repeats[r]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_FLOAT, pixels.data());
+            double maxFloat = 0, maxDouble = 0;
+            for (int j = 0; j < SIZE; j++) {
+                for (int i = 0; i < SIZE; i++) {
+                    float x = (i + 0.5f)*SPACING, y = (j + 0.5f)*SPACING; // gl_FragCoord is at the texel centre
+                    float gpu = pixels[4*(i + j*SIZE)];
+                    maxFloat = std::fmax(maxFloat, std::fabs(gpu - perlin<float>(x, y, 0.3f, repeats[r])));
+                    maxDouble = std::fmax(maxDouble, std::fabs(gpu - perlin((double)x, (double)y, (double)0.3f, (double)repeats[r])));
+                }
+            }
+            printf("perlinShaderSource() repeat %.0f: max difference %g from perlin<float>(), %g from perlin()\n", repeats[r], maxFloat, maxDouble);
+            if (maxFloat > 1e-5 || maxDouble > 1e-5) {
+                printf("FAILED: the GLSL perlin() does not match perlin()\n");
+                return 1;
+            }
+        }
+
+        //SO_NOISE_COLOR and SO_NOISE_DISPLACEMENT on a grid of vertices at the texel centres - with only an ambient light of 1 and a white
+        //colour mixed with black the colour is the noise, and with identity matrices the depth is (1 + displacement)/2
+        std::vector<float> vertices;
+        std::vector<int> elements;
+        for (int j = 0; j < SIZE; j++) {
+            for (int i = 0; i < SIZE; i++) {
+                float position[6] = {-1.0f + (2*i + 1.0f)/SIZE, -1.0f + (2*j + 1.0f)/SIZE, 0.0f, 0.0f, 0.0f, 1.0f};
+                vertices.insert(vertices.end(), position, position + 6);
+                if (i + 1 < SIZE && j + 1 < SIZE) {
+                    int corners[6] = {i + j*SIZE, i + 1 + j*SIZE, i + (j + 1)*SIZE, i + (j + 1)*SIZE, i + 1 + j*SIZE, i + 1 + (j + 1)*SIZE};
+                    elements.insert(elements.end(), corners, corners + 6);
+                }
+            }
+        }
+        SO_PhongShader phong;
+        GLuint phongProgram = phong.generate(1, SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT);
+        glUseProgram(phongProgram);
+        phong.setLightPosition(0, glm::vec3(0.0f, 0.0f, 1.0f));
+        phong.setLightConstant(0, 1.0f);
+        phong.setLightLinear(0, 0.0f);
+        phong.setLightQuadratic(0, 0.0f);
+        phong.setLightAmbient(0, glm::vec3(1.0f, 1.0f, 1.0f));
+        phong.setLightDiffuse(0, glm::vec3(0.0f, 0.0f, 0.0f));
+        phong.setLightSpecular(0, glm::vec3(0.0f, 0.0f, 0.0f));
+        phong.setModelMatrix(glm::mat4(1.0f));
+        phong.setViewMatrix(glm::mat4(1.0f));
+        phong.setProjectionMatrix(glm::mat4(1.0f));
+        phong.setViewPosition(glm::vec3(0.0f, 0.0f, 1.0f));
+        phong.setColor(glm::vec3(1.0f, 1.0f, 1.0f));
+        phong.setNoiseColor(glm::vec3(0.0f, 0.0f, 0.0f));
+        glm::vec3 offset(0.3f, 0.7f, 0.25f);
+        float scale = 4.0f, amplitude = 0.5f;
+        phong.setNoiseScale(scale);
+        phong.setNoiseOffset(offset);
+        phong.setNoiseAmplitude(amplitude);
+
+        GLuint gridVbo, gridEbo;
+        glGenBuffers(1, &gridVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, gridVbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glGenBuffers(1, &gridEbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridEbo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(int), elements.data(), GL_STATIC_DRAW);
+        GLint posAttrib = glGetAttribLocation(phongProgram, "position");
+        glEnableVertexAttribArray(posAttrib);
+        glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), 0);
+        GLint normalAttrib = glGetAttribLocation(phongProgram, "normal");
+        glEnableVertexAttribArray(normalAttrib);
+        glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glClearColor(1.0f, 0.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, elements.size(), GL_UNSIGNED_INT, 0);
+        std::vector<float> depths(SIZE*SIZE);
+        glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_FLOAT, pixels.data());
+        glReadPixels(0, 0, SIZE, SIZE, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data());
+        //texel centres on the outside edges of the grid may not be covered, so only the inside ones are compared
+        double maxColor = 0, maxDepth = 0;
+        for (int j = 1; j < SIZE - 1; j++) {
+            for (int i = 1; i < SIZE - 1; i++) {
+                const float* vertex = &vertices[6*(i + j*SIZE)];
+                double n = perlin(vertex[0]*scale + offset.x, vertex[1]*scale + offset.y, vertex[2]*scale + offset.z, 0);
+                for (int c = 0; c < 3; c++) {
+                    maxColor = std::fmax(maxColor, std::fabs(pixels[4*(i + j*SIZE) + c] - n));
+                }
+                maxDepth = std::fmax(maxDepth, std::fabs(depths[i + j*SIZE] - (1.0 + amplitude*(2*n - 1))/2));
+            }
+        }
+        printf("SO_NOISE_COLOR: max difference %g from perlin(), SO_NOISE_DISPLACEMENT: max depth difference %g\n", maxColor, maxDepth);
+        if (maxColor > 1e-4 || maxDepth > 1e-4) {
+            printf("FAILED: the noise options of SO_PhongShader do not follow perlin()\n");
+            return 1;
+        }
+        glDepthFunc(GL_LESS);
+        glDeleteBuffers(1, &gridEbo);
+        glDeleteBuffers(1, &gridVbo);
+    }
+
+    //the demo - an icosphere whose colour and surface drift with the noise offset
+    SO_MeshData sphere = createIcosphere(5);
+    SO_PhongShader shaderObj;
+    GLuint shaderProgram = shaderObj.generate(1, SO_NOISE_COLOR | SO_NOISE_DISPLACEMENT);
+    glUseProgram(shaderProgram);
+    shaderObj.setLightPosition(0, glm::vec3(2.0f, 0.0f, 2.0f));
+    shaderObj.setLightConstant(0, 1.0f);
+    shaderObj.setLightLinear(0, 0.0f);
+    shaderObj.setLightQuadratic(0, 0.0f);
+    shaderObj.setLightAmbient(0, glm::vec3(0.1f, 0.1f, 0.1f));
+    shaderObj.setLightDiffuse(0, glm::vec3(1.0f, 1.0f, 1.0f));
+    shaderObj.setLightSpecular(0, glm::vec3(0.5f, 0.5f, 0.5f));
+    shaderObj.setModelMatrix(glm::mat4(1.0f));
+    shaderObj.setViewMatrix(glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+    shaderObj.setProjectionMatrix(glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 10.0f));
+    shaderObj.setViewPosition(glm::vec3(2.0f, 2.0f, 2.0f));
+    shaderObj.setColor(glm::vec3(0.9f, 0.6f, 0.2f));
+    shaderObj.setNoiseColor(glm::vec3(0.1f, 0.2f, 0.6f));
+    shaderObj.setNoiseScale(3.0f);
+    shaderObj.setNoiseAmplitude(0.08f);
+
+    //the vertices of a unit icosphere are also its normals
+    GLuint vbo, ebo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sphere.vertices.size()*sizeof(glm::vec3), sphere.vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.faceElements.size()*sizeof(int), sphere.faceElements.data(), GL_STATIC_DRAW);
+    GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    GLint normalAttrib = glGetAttribLocation(shaderProgram, "normal");
+    glEnableVertexAttribArray(normalAttrib);
+    glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+
+    glViewport(0, 0, 800, 800);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    double start = glfwGetTime();
+    while(!glfwWindowShouldClose(window))
+    {
+        shaderObj.setNoiseOffset(glm::vec3(0.0f, 0.0f, 0.5f*(float)(glfwGetTime() - start)));
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, sphere.faceElements.size(), GL_UNSIGNED_INT, 0);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    //clear up
+
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteTextures(1, &permsTexture);
+
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+//includes
+#include <sceneObjects.hpp>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+using namespace sceneObjects;
+
+const int SIZE = 64; //the grid has SIZE x SIZE vertices, one at each texel centre of the render target
+const int FLOATS = 10; //position, normal, colour and scalar per vertex
+const float SCALAR_MIN = 10.0f;
+const float SCALAR_MAX = 20.0f;
+
+//an ambient only light of 1 and identity matrices, so each fragment is just its colour at its vertex position
+void setUpShader(SO_PhongShader& shader) {
+    shader.setLightPosition(0, glm::vec3(0.0f, 0.0f, 1.0f));
+    shader.setLightConstant(0, 1.0f);
+    shader.setLightLinear(0, 0.0f);
+    shader.setLightQuadratic(0, 0.0f);
+    shader.setLightAmbient(0, glm::vec3(1.0f, 1.0f, 1.0f));
+    shader.setLightDiffuse(0, glm::vec3(0.0f, 0.0f, 0.0f));
+    shader.setLightSpecular(0, glm::vec3(0.0f, 0.0f, 0.0f));
+    shader.setModelMatrix(glm::mat4(1.0f));
+    shader.setViewMatrix(glm::mat4(1.0f));
+    shader.setProjectionMatrix(glm::mat4(1.0f));
+    shader.setViewPosition(glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+//a vertex array reading the grid's position, normal and either its colour or its scalar
+GLuint gridVao(GLuint program, GLuint vbo, GLuint ebo, bool scalar) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    GLint posAttrib = glGetAttribLocation(program, "position");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, FLOATS*sizeof(float), 0);
+    GLint normalAttrib = glGetAttribLocation(program, "normal");
+    glEnableVertexAttribArray(normalAttrib);
+    glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, FLOATS*sizeof(float), (void*)(3*sizeof(float)));
+    if (scalar) {
+        GLint scalarAttrib = glGetAttribLocation(program, "scalar");
+        glEnableVertexAttribArray(scalarAttrib);
+        glVertexAttribPointer(scalarAttrib, 1, GL_FLOAT, GL_FALSE, FLOATS*sizeof(float), (void*)(9*sizeof(float)));
+    } else {
+        GLint colAttrib = glGetAttribLocation(program, "color");
+        glEnableVertexAttribArray(colAttrib);
+        glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, FLOATS*sizeof(float), (void*)(6*sizeof(float)));
+    }
+    glBindVertexArray(0);
+    return vao;
+}
+
+//draws the same grid of scalars coloured per vertex with getLerpColor(), and per fragment with SO_SCALAR_ATTRIBUTE and createTexture(), for a
+//few colormaps - checks the texture is looked up at (keyPosition*(texels - 1) + 0.5)/texels and both ways agree, then shows the grid with its range sweeping
+int main(int argc, char *argv[]) {
+
+    //set up window
+    glfwInit();
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 800, "OpenGL", nullptr, nullptr); // Windowed
+
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    //the scalars run a quarter of the range past each end, so the clamping at the ends of the map is drawn too
+    std::vector<float> vertices(FLOATS*SIZE*SIZE);
+    std::vector<int> elements;
+    for (int j = 0; j < SIZE; j++) {
+        for (int i = 0; i < SIZE; i++) {
+            float* vertex = &vertices[FLOATS*(i + j*SIZE)];
+            vertex[0] = -1.0f + (2*i + 1.0f)/SIZE;
+            vertex[1] = -1.0f + (2*j + 1.0f)/SIZE;
+            vertex[5] = 1.0f;
+            vertex[9] = SCALAR_MIN + (SCALAR_MAX - SCALAR_MIN)*(-0.25f + 1.5f*(i + j*SIZE)/(SIZE*SIZE - 1));
+            if (i + 1 < SIZE && j + 1 < SIZE) {
+                int corners[6] = {i + j*SIZE, i + 1 + j*SIZE, i + (j + 1)*SIZE, i + (j + 1)*SIZE, i + 1 + j*SIZE, i + 1 + (j + 1)*SIZE};
+                elements.insert(elements.end(), corners, corners + 6);
+            }
+        }
+    }
+    GLuint vbo, ebo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(int), elements.data(), GL_STATIC_DRAW);
+
+    SO_PhongShader colorShader;
+    GLuint colorProgram = colorShader.generate(1, SO_COLOR_ATTRIBUTE);
+    setUpShader(colorShader);
+    GLuint colorVao = gridVao(colorProgram, vbo, ebo, false);
+    SO_PhongShader scalarShader;
+    GLuint scalarProgram = scalarShader.generate(1, SO_SCALAR_ATTRIBUTE);
+    setUpShader(scalarShader);
+    scalarShader.setScalarRange(SCALAR_MIN, SCALAR_MAX);
+    GLuint scalarVao = gridVao(scalarProgram, vbo, ebo, true);
+
+    //a float render target to read back exactly what was drawn
+    GLuint target, fbo;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SIZE, SIZE, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, SIZE, SIZE);
+    std::vector<float> perVertex(4*SIZE*SIZE), perFragment(4*SIZE*SIZE);
+
+    //keys away from 0 and 1 so the key range has to be mapped across the texture - and a coarse texture of the same map, whose keys fall on
+    //texel centres so it still matches getLerpColor(), but where a lookup anywhere but the texel centres would be far out
+    SO_ColorMap spectrum;
+    spectrum.setValue(0.1f, glm::vec3(1.0f, 0.0f, 0.0f));
+    spectrum.setValue(0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    spectrum.setValue(0.9f, glm::vec3(0.0f, 0.0f, 1.0f));
+    SO_ColorMap single;
+    single.setValue(0.3f, glm::vec3(0.2f, 0.6f, 1.0f));
+    SO_ColorMap empty;
+    struct Case {
+        const char* name;
+        const SO_ColorMap* map;
+        int resolution;
+        double lerpTolerance; // how far the texture may be from getLerpColor() - the 8 bit texels and the filtering
+    };
+    Case cases[4] = {{"3 keys, resolution 1024", &spectrum, 1024, 2.0/255}, {"3 keys, resolution 4", &spectrum, 4, 2.0/255},
+                     {"1 key", &single, 1024, 1.0/255}, {"empty", &empty, 1024, 0.0}};
+
+    for (const Case& test : cases) {
+        //per vertex colours straight from getLerpColor()
+        for (int v = 0; v < SIZE*SIZE; v++) {
+            glm::vec3 color = test.map->getLerpColor(SCALAR_MIN, SCALAR_MAX, vertices[FLOATS*v + 9]);
+            vertices[FLOATS*v + 6] = color.x;
+            vertices[FLOATS*v + 7] = color.y;
+            vertices[FLOATS*v + 8] = color.z;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size()*sizeof(float), vertices.data());
+        glUseProgram(colorProgram);
+        glBindVertexArray(colorVao);
+        glClearColor(1.0f, 0.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, elements.size(), GL_UNSIGNED_INT, 0);
+        glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_FLOAT, perVertex.data());
+
+        //the scalars looked up in the texture
+        GLuint texture = test.map->createTexture(test.resolution);
+        glActiveTexture(GL_TEXTURE4); // the default colormap texture unit of SO_PhongShader
+        glBindTexture(GL_TEXTURE_1D, texture);
+        glActiveTexture(GL_TEXTURE0);
+        scalarShader.setColorMap(*test.map);
+        glUseProgram(scalarProgram);
+        glBindVertexArray(scalarVao);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, elements.size(), GL_UNSIGNED_INT, 0);
+        glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_FLOAT, perFragment.data());
+
+        //the texels as uploaded, to filter on the CPU at the lookup SO_SCALAR_ATTRIBUTE should make
+        GLint texels;
+        glBindTexture(GL_TEXTURE_1D, texture);
+        glGetTexLevelParameteriv(GL_TEXTURE_1D, 0, GL_TEXTURE_WIDTH, &texels);
+        std::vector<unsigned char> bytes(4*texels);
+        glGetTexImage(GL_TEXTURE_1D, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
+        glBindTexture(GL_TEXTURE_1D, 0);
+        int expectedTexels = test.map->getSize() > 1 ? test.resolution + 1 : 1;
+        if (texels != expectedTexels) {
+            printf("FAILED: %s: createTexture() made %d texels rather than %d\n", test.name, texels, expectedTexels);
+            return 1;
+        }
+
+        //texel centres on the outside edges of the grid may not be covered, so only the inside ones are compared
+        const std::vector<float>& positions = test.map->getPositions();
+        float first = positions.empty() ? 0.0f : positions.front();
+        float last = positions.empty() ? 0.0f : positions.back();
+        double maxFilter = 0, maxLerp = 0;
+        for (int j = 1; j < SIZE - 1; j++) {
+            for (int i = 1; i < SIZE - 1; i++) {
+                int v = i + j*SIZE;
+                float normalised = (vertices[FLOATS*v + 9] - SCALAR_MIN)/(SCALAR_MAX - SCALAR_MIN);
+                double keyPosition = last > first ? (normalised - first)/(last - first) : 0.0;
+                keyPosition = keyPosition < 0 ? 0 : (keyPosition > 1 ? 1 : keyPosition);
+                //(keyPosition*(texels - 1) + 0.5)/texels in texture coordinates is keyPosition*(texels - 1) texels from the first texel centre
+                double texel = keyPosition*(texels - 1);
+                int lower = (int)texel;
+                int upper = lower + 1 < texels ? lower + 1 : lower;
+                double fraction = texel - lower;
+                for (int c = 0; c < 4; c++) {
+                    double filtered = (bytes[4*lower + c] + fraction*(bytes[4*upper + c] - bytes[4*lower + c]))/255.0;
+                    maxFilter = std::fmax(maxFilter, std::fabs(perFragment[4*v + c] - filtered));
+                    if (c < 3) {
+                        maxLerp = std::fmax(maxLerp, std::fabs(perFragment[4*v + c] - perVertex[4*v + c]));
+                    }
+                }
+            }
+        }
+        printf("%-24s %5d texels: max difference %g from the texel centre lookup, %g from getLerpColor()\n", test.name, texels, maxFilter, maxLerp);
+        if (maxFilter > 1.5/255) {
+            printf("FAILED: %s: SO_SCALAR_ATTRIBUTE does not look up (keyPosition*(texels - 1) + 0.5)/texels\n", test.name);
+            return 1;
+        }
+        if (maxLerp > test.lerpTolerance + 1e-6) {
+            printf("FAILED: %s: SO_SCALAR_ATTRIBUTE does not match getLerpColor()\n", test.name);
+            return 1;
+        }
+        glDeleteTextures(1, &texture);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &target);
+
+    //the demo - the grid in the window with its scalar range sweeping back and forth, which needs no vertex data re-uploaded
+    GLuint texture = spectrum.createTexture();
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glActiveTexture(GL_TEXTURE0);
+    scalarShader.setColorMap(spectrum);
+    glUseProgram(scalarProgram);
+    glBindVertexArray(scalarVao);
+    glViewport(0, 0, 800, 800);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    double start = glfwGetTime();
+    while(!glfwWindowShouldClose(window))
+    {
+        float sweep = 0.25f*(SCALAR_MAX - SCALAR_MIN)*(float)std::sin(glfwGetTime() - start);
+        scalarShader.setScalarRange(SCALAR_MIN + sweep, SCALAR_MAX + sweep);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, elements.size(), GL_UNSIGNED_INT, 0);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    //clear up
+
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &colorVao);
+    glDeleteVertexArrays(1, &scalarVao);
+
+    glfwTerminate();
+
+    return 0;
+}